@@ -0,0 +1,42 @@
+#include <david/utils/gameState.h>
+#include <david/utils/neuralNet.h>
+
+#include <array>
+#include "benchmark/benchmark.h"
+
+
+// the legacy conversion, returning an array
+static void BM_convertGameStateToInputsArray(benchmark::State& state) {
+  ::david::type::gameState_t gs;
+  ::utils::gameState::generateFromFEN(gs, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10");
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(::utils::neuralNet::convertGameStateToInputs(gs));
+  }
+}
+BENCHMARK(BM_convertGameStateToInputsArray);
+
+// written straight into a batch buffer
+static void BM_convertGameStateToInputsTrained(benchmark::State& state) {
+  ::david::type::gameState_t gs;
+  ::utils::gameState::generateFromFEN(gs, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10");
+  std::array<float, ::david::constant::nn::INPUTSIZE> inputs;
+
+  while (state.KeepRunning()) {
+    ::utils::neuralNet::convertGameStateToInputs(gs, inputs.data(), ::utils::neuralNet::LAYOUT_TRAINED);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_convertGameStateToInputsTrained);
+
+static void BM_convertGameStateToInputsFull(benchmark::State& state) {
+  ::david::type::gameState_t gs;
+  ::utils::gameState::generateFromFEN(gs, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10");
+  std::array<float, ::david::constant::nn::INPUTSIZE> inputs;
+
+  while (state.KeepRunning()) {
+    ::utils::neuralNet::convertGameStateToInputs(gs, inputs.data(), ::utils::neuralNet::LAYOUT_FULL);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_convertGameStateToInputsFull);
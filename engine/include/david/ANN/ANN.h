@@ -3,18 +3,24 @@
 // local dependencies
 #include "david/types.h"
 #include <david/bitboard.h>
+#include "david/ANN/DenseNetwork.h"
+#include "david/EvaluationCache.h"
+#include "david/utils/neuralNet.h"
 
 // git submodule libraries
 #include "fann/floatfann.h"
 
 // system dependencies
 #include <iostream>
+#include <mutex>
 
 // forward declaration
 
 namespace david {
 class ANN {
  public:
+  typedef DenseNetwork::Accumulator Accumulator;
+
   ANN();
   ANN(const std::string filename);
   ~ANN();
@@ -51,12 +57,21 @@ class ANN {
   bool hasANNInstance() const;
 
   /**
-   * Start the ANN from given files.
+   * Start the ANN from given files. A binary network file next to the
+   * ANN file, see DenseNetwork::binaryPath, is mapped instead of parsing it.
    */
   void createANNInstance();
 
+  /**
+   * The file the network is loaded from, the binary network file when
+   * there is one.
+   * @return std::string absolute path
+   */
+  std::string getWeightFile() const;
+
   /**
    * Run the boards through the trained neural network to get a generated output.
+   * Any number of threads may evaluate at once, see DenseNetwork.
    *
    * @param board ::gameTree::gameState, of shared_ptr type
    * @return int board evaluation
@@ -72,10 +87,109 @@ class ANN {
    */
   int ANNEvaluate(const std::string& fen) const;
 
+  /**
+   * Evaluate several boards at once, usually the children of a position.
+   * The network runs them as a batch, so the weights are read once for
+   * every DenseNetwork::BATCH boards instead of once per board.
+   *
+   * @param boards the game states
+   * @param n number of boards
+   * @param scores where the board evaluations are written, n of them
+   */
+  void evaluateBatch(type::gameState_t* boards, const size_t n, int* scores) const;
+
+  /**
+   * Check if positions can be evaluated from the first layer of the position
+   * before them, which needs the float network of the in-house kernels.
+   */
+  bool hasAccumulators() const;
+
+  /**
+   * Compute the first layer of a position from all of its inputs.
+   *
+   * @param board the position
+   * @param accumulator where the first layer is stored
+   */
+  void refreshAccumulator(type::gameState_t& board, Accumulator& accumulator) const;
+
+  /**
+   * Compute the first layer of a position from the first layer of another
+   * position, usually the one before a move. Only the inputs that changed
+   * are added.
+   *
+   * @param from first layer of the other position
+   * @param board the position
+   * @param accumulator where the first layer is stored
+   */
+  void updateAccumulator(const Accumulator& from, type::gameState_t& board, Accumulator& accumulator) const;
+
+  /**
+   * Run the rest of the network from the first layer of a position.
+   *
+   * @param accumulator filled by refreshAccumulator or updateAccumulator
+   * @return int board evaluation
+   */
+  int ANNEvaluate(const Accumulator& accumulator) const;
+
+  /**
+   * Run the rest of the network for several positions as a batch.
+   *
+   * @param accumulators filled by refreshAccumulator or updateAccumulator
+   * @param n number of positions
+   * @param scores where the board evaluations are written, n of them
+   */
+  void evaluateBatch(const Accumulator* accumulators, const size_t n, int* scores) const;
+
+  /**
+   * Name of the inference kernels, "avx2" or "scalar" with " int8" added
+   * when quantized, or "fann" when the network file could only be loaded by FANN.
+   */
+  std::string getKernel() const;
+
+  /**
+   * Switch between float and integer inference. The integer weights are
+   * converted from the float ones, switching back loads the file again.
+   * Must not be called while a search is running.
+   *
+   * @param quantized bool
+   * @return false if the network isn't run by the in-house kernels
+   */
+  bool setQuantized(const bool quantized);
+
+  /**
+   * Scores of positions that were already evaluated. ANNEvaluate and
+   * evaluateBatch check it before a board is converted to inputs, the
+   * accumulator methods leave it to the caller since they don't see the board.
+   * The cache is safe to use from several search threads at once.
+   */
+  EvaluationCache& getEvaluationCache() const;
+
+  /**
+   * Change the size of the evaluation cache, this clears it.
+   * Must not be called while a search is running.
+   *
+   * @param megabytes approximate memory use, 0 turns the cache off
+   */
+  void setEvaluationCacheSize(const size_t megabytes);
+
 
 
  private:
   std::string ANNFile;
   fann* ANNInstance;
+
+  // fann_run writes the neuron values into the fann instance, so unlike the
+  // in-house kernels it can only be run by one thread at a time
+  mutable std::mutex fannMutex;
+
+  // float networks are run by the in-house kernels, FANN is only used for files they can't load
+  DenseNetwork network;
+
+  // how the boards are converted, binary network files can use another layout
+  ::utils::neuralNet::InputLayout inputLayout;
+  void convert(const type::gameState_t& board, float* inputs) const;
+
+  // filled by the const evaluation methods
+  mutable EvaluationCache cache;
 };
 } // namespace david end
\ No newline at end of file
@@ -0,0 +1,372 @@
+#pragma once
+
+// system dependencies
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace david {
+
+/**
+ * Fully connected feed forward network, evaluated without FANN.
+ *
+ * The weights of a float FANN .net file are loaded into one row major matrix
+ * per layer, with the bias as a separate vector. Rows are padded to a
+ * multiple of 8 floats and start on 32 byte boundaries, so the matrix vector
+ * products run on whole AVX registers. The kernels are picked when the
+ * network is loaded: AVX2 with FMA when the CPU has it, plain C++ otherwise.
+ *
+ * The sigmoid activations are computed from a polynomial approximation of
+ * exp, which is within 1e-6 of the exact functions.
+ *
+ * Once quantized, the layers run as integer dot products, int16 inputs of
+ * the first layer with vpmaddwd and the uint8 activations of the others with
+ * vpmaddubsw. The sums are turned back into floats for the bias and the
+ * activation function, then clipped to [-1, 1] and stored as uint8 for the
+ * next layer.
+ *
+ * Positions reached by a move share most of their inputs, so the first
+ * layer can be kept in an Accumulator and updated with the weights of the
+ * inputs that changed, instead of being computed from every input.
+ *
+ * Siblings can be run as a batch. Each layer is then computed for the whole
+ * batch before the next one, with every group of weight rows applied to all
+ * of the positions while it is still in the L1 cache.
+ *
+ * Weights are read only once loaded, and shared by every DenseNetwork in the
+ * process that loads the same file. A binary network file, written by save,
+ * is memory mapped instead of parsed, so loading it takes milliseconds and
+ * the weights are read straight from the page cache.
+ *
+ * Nothing is written to the network when it's run. The neuron outputs go to
+ * scratch buffers every thread has of its own, so any number of threads can
+ * run the same network at once without locks. Loading or quantizing must
+ * not happen while a thread runs it.
+ */
+class DenseNetwork {
+ public:
+  // activation functions, same numbers as the FANN enum
+  static constexpr int LINEAR = 0;
+  static constexpr int SIGMOID = 3;
+  static constexpr int SIGMOID_SYMMETRIC = 5;
+
+  // floats per AVX register, rows and vectors are padded to a multiple of it
+  static constexpr size_t LANES = 8;
+
+  DenseNetwork();
+  DenseNetwork(const DenseNetwork&) = delete;
+  void operator=(const DenseNetwork&) = delete;
+
+  // binary network files, see save
+  static constexpr uint32_t FORMAT_VERSION = 1;
+  static constexpr const char* BINARY_EXTENSION = ".dnet";
+
+  /**
+   * Load the weights of a binary network file, or of a FANN float network
+   * file. Only layered, fully connected networks without input scaling,
+   * where every neuron of a layer has the same activation function, can be
+   * loaded. A file that's already loaded by another network is shared.
+   * @param path .dnet or .net file
+   * @param vectorize use the AVX2 kernels if the CPU supports them
+   * @return false if the file can't be read or has a network that isn't supported
+   */
+  bool load(const std::string& path, const bool vectorize = true);
+
+  bool isLoaded() const;
+
+  /**
+   * Write the float weights as a binary network file, so they can be
+   * memory mapped by load. The file is in the byte order of the machine.
+   * @param path file to write, usually ending with BINARY_EXTENSION
+   * @param inputLayout how positions are converted to inputs, see utils::neuralNet::InputLayout
+   * @return false if nothing is loaded, the network is quantized or the file can't be written
+   */
+  bool save(const std::string& path, const int inputLayout) const;
+
+  /**
+   * @param path of a FANN .net file
+   * @return std::string the same path, ending with BINARY_EXTENSION instead
+   */
+  static std::string binaryPath(const std::string& path);
+
+  /**
+   * How positions are converted to inputs, see utils::neuralNet::InputLayout.
+   * FANN files are always in the layout the networks were trained on.
+   * @return int the layout, 0 if nothing is loaded
+   */
+  int inputLayout() const;
+
+  /**
+   * @return true if the weights are mapped from a binary network file
+   */
+  bool isMapped() const;
+
+  /**
+   * @param other network
+   * @return true if both networks run on the same weights in memory
+   */
+  bool sharesWeightsWith(const DenseNetwork& other) const;
+
+  /**
+   * Neurons per layer, inputs first, not counting the bias neurons.
+   * @return std::vector<int> empty if nothing is loaded
+   */
+  std::vector<int> topology() const;
+
+  /**
+   * Run the network.
+   * @param inputs as many as the first layer has neurons
+   * @return float the first output neuron
+   */
+  float run(const float* inputs) const;
+
+  // positions per batch, longer runs are split
+  static constexpr size_t BATCH = 16;
+
+  /**
+   * Run the network for several positions at once.
+   * @param inputs n rows of as many inputs as the first layer has neurons
+   * @param n number of positions
+   * @param outputs the first output neuron of every position
+   */
+  void run(const float* inputs, const size_t n, float* outputs) const;
+
+  /**
+   * @return const char* name of the kernels in use, "avx2" or "scalar"
+   */
+  const char* kernel() const;
+
+  /**
+   * Convert the weights to integers, the first layer to int16 and the
+   * others to int8, with one scale per layer. The float weights aren't used
+   * any more, but stay in memory while other networks share them. Load the
+   * file again to go back to float inference.
+   * @return false if nothing is loaded
+   */
+  bool quantize();
+
+  bool isQuantized() const;
+
+  /**
+   * @return size_t bytes taken by the weights and biases
+   */
+  size_t weightBytes() const;
+
+  // quantized activations are stored as uint8, -1 is 0 and 1 is 2 * ACTIVATION_ONE
+  static constexpr int ACTIVATION_ONE = 64;
+
+  /**
+   * Inputs and first layer sums of a position, before the bias and the
+   * activation function.
+   */
+  class Accumulator {
+   public:
+    inline bool isEmpty() const {
+      return this->inputs.empty();
+    }
+
+   private:
+    friend class DenseNetwork;
+    std::vector<float> inputs;
+    std::vector<float> sums; // padded to whole registers
+  };
+
+  /**
+   * Accumulators need the float weights, they can't be used once quantized.
+   * @return true if the accumulator methods can be used
+   */
+  bool hasAccumulators() const;
+
+  /**
+   * Compute the first layer of a position from all of its inputs.
+   * @param inputs as many as the first layer has neurons
+   * @param accumulator where the inputs and sums are stored
+   */
+  void refresh(const float* inputs, Accumulator& accumulator) const;
+
+  /**
+   * Compute the first layer of a position from the accumulator of another
+   * position, usually the one before a move, by only adding the weights of
+   * the inputs that differ.
+   * @param from accumulator of the other position
+   * @param inputs as many as the first layer has neurons
+   * @param accumulator where the inputs and sums are stored, may not be from
+   * @return size_t number of inputs that changed
+   */
+  size_t update(const Accumulator& from, const float* inputs, Accumulator& accumulator) const;
+
+  /**
+   * Run the network from the first layer sums of a position.
+   * @param accumulator filled by refresh or update
+   * @return float the first output neuron
+   */
+  float run(const Accumulator& accumulator) const;
+
+  /**
+   * Run the network for several positions from their first layer sums.
+   * @param accumulators n accumulators filled by refresh or update
+   * @param n number of positions
+   * @param outputs the first output neuron of every position
+   */
+  void run(const Accumulator* accumulators, const size_t n, float* outputs) const;
+
+ private:
+  // values on a 32 byte boundary, zero initialised
+  template<typename T>
+  class AlignedBuffer {
+   public:
+    AlignedBuffer()
+        : values(nullptr)
+    {}
+
+    explicit AlignedBuffer(const size_t size)
+        : values(static_cast<T*>(std::aligned_alloc(32, (std::max<size_t>(size, 1) * sizeof(T) + 31) / 32 * 32)))
+    {
+      std::fill(this->values, this->values + size, T{0});
+    }
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept
+        : values(other.values)
+    {
+      other.values = nullptr;
+    }
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+      std::swap(this->values, other.values);
+      return *this;
+    }
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    void operator=(const AlignedBuffer&) = delete;
+
+    ~AlignedBuffer() {
+      std::free(this->values);
+    }
+
+    inline T* data() const {
+      return this->values;
+    }
+
+   private:
+    T* values;
+  };
+
+  struct Layer {
+    size_t inputs;
+    size_t outputs;
+    size_t stride; // floats per weight row, inputs rounded up to LANES
+    int activation;
+    float steepness;
+    const float* weights; // outputs x stride, nullptr once quantized
+    const float* biases;  // outputs, rounded up to LANES
+  };
+
+  // the weights of a file, kept alive by every network that loaded it
+  struct SharedWeights;
+
+  // integer weights of a quantized layer
+  struct QuantizedLayer {
+    size_t stride;  // weights per row, rounded up to whole AVX registers
+    float scale;    // turns an integer sum back into a float sum
+    AlignedBuffer<int16_t> wideWeights; // first layer, outputs x stride
+    AlignedBuffer<int8_t> weights;      // other layers, outputs x stride
+    std::vector<int32_t> offsets;       // ACTIVATION_ONE times the weights of a row, zero in the first layer
+  };
+
+  // output[r] = activation(steepness * (weights[r] . input + biases[r]))
+  typedef void (*layer_kernel_t)(const Layer& layer, const float* input, float* output);
+
+  // the same for n positions, whose values are pitch floats apart
+  typedef void (*batch_kernel_t)(const Layer& layer, const float* input, const size_t n, const size_t pitch, float* output);
+
+  // sums[r] = weights[r] . input, of a quantized layer
+  typedef void (*first_kernel_t)(const Layer& layer, const QuantizedLayer& quantized, const int16_t* input, int32_t* sums);
+  typedef void (*hidden_kernel_t)(const Layer& layer, const QuantizedLayer& quantized, const uint8_t* input, int32_t* sums);
+
+  // values[r] = activation(steepness * (values[r] + biases[r])), for the padded length of the layer
+  typedef void (*activation_kernel_t)(const Layer& layer, float* values);
+
+  // sums[r] += factor * column[r], n is a multiple of LANES
+  typedef void (*axpy_kernel_t)(const float factor, const float* column, const size_t n, float* sums);
+
+  // values[r] = (sums[r] - offsets[r]) * scale
+  typedef void (*dequantize_kernel_t)(const int32_t* sums, const int32_t* offsets, const float scale, const size_t n, float* values);
+
+  // activations[i] = values[i] clipped to [-1, 1] as uint8, see ACTIVATION_ONE
+  typedef void (*quantize_kernel_t)(const float* values, const size_t n, uint8_t* activations);
+
+  std::shared_ptr<const SharedWeights> shared;
+  std::vector<Layer> layers; // point into the shared weights
+  std::vector<QuantizedLayer> quantizedLayers; // empty unless quantized
+  layer_kernel_t runLayer;
+  batch_kernel_t runBatchLayer;
+  first_kernel_t runFirstLayer;
+  hidden_kernel_t runHiddenLayer;
+  activation_kernel_t activateLayer;
+  dequantize_kernel_t dequantize;
+  quantize_kernel_t quantizeActivations;
+  axpy_kernel_t addColumn;
+  bool vectorized;
+
+  // the first layer weights again, by input, for the accumulators. inputs x padded outputs
+  const float* columns;
+  size_t columnStride;
+
+  // floats per layer of neuron values, and bytes of the quantized ones
+  size_t widest;
+  size_t wideInputSize;
+  size_t activationSize;
+
+  // neuron values of a run, every thread has its own. They're grown to fit
+  // the largest network the thread has run
+  struct Scratch {
+    // the layer being read and the layer being written
+    AlignedBuffer<float> input;
+    AlignedBuffer<float> output;
+    size_t widest = 0;
+
+    // the same for a batch of positions, widest floats apart
+    AlignedBuffer<float> batchInput;
+    AlignedBuffer<float> batchOutput;
+
+    // inputs and sums of the quantized layers
+    AlignedBuffer<int16_t> wideInput;
+    AlignedBuffer<uint8_t> activations;
+    AlignedBuffer<int32_t> sums;
+    size_t wideInputSize = 0;
+    size_t activationSize = 0;
+  };
+
+  Scratch& scratch() const;
+  float runQuantized(Scratch& buffers, const float* inputs) const;
+  float runHiddenLayers(Scratch& buffers, float* values) const;
+  void runBatch(Scratch& buffers, float* values, const size_t firstLayer, const size_t n, float* outputs) const;
+  void selectKernels(const bool vectorize);
+
+  static std::shared_ptr<const SharedWeights> share(const std::string& path);
+  static std::shared_ptr<const SharedWeights> parse(const std::string& path);
+  static std::shared_ptr<const SharedWeights> map(const std::string& path);
+
+  static void runLayerScalar(const Layer& layer, const float* input, float* output);
+  static void runLayerAVX2(const Layer& layer, const float* input, float* output);
+  static void runBatchLayerScalar(const Layer& layer, const float* input, const size_t n, const size_t pitch, float* output);
+  static void runBatchLayerAVX2(const Layer& layer, const float* input, const size_t n, const size_t pitch, float* output);
+  static void runFirstLayerScalar(const Layer& layer, const QuantizedLayer& quantized, const int16_t* input, int32_t* sums);
+  static void runFirstLayerAVX2(const Layer& layer, const QuantizedLayer& quantized, const int16_t* input, int32_t* sums);
+  static void runHiddenLayerScalar(const Layer& layer, const QuantizedLayer& quantized, const uint8_t* input, int32_t* sums);
+  static void runHiddenLayerAVX2(const Layer& layer, const QuantizedLayer& quantized, const uint8_t* input, int32_t* sums);
+  static void activateLayerScalar(const Layer& layer, float* values);
+  static void activateLayerAVX2(const Layer& layer, float* values);
+  static void dequantizeScalar(const int32_t* sums, const int32_t* offsets, const float scale, const size_t n, float* values);
+  static void dequantizeAVX2(const int32_t* sums, const int32_t* offsets, const float scale, const size_t n, float* values);
+  static void quantizeScalar(const float* values, const size_t n, uint8_t* activations);
+  static void quantizeAVX2(const float* values, const size_t n, uint8_t* activations);
+  static void addColumnScalar(const float factor, const float* column, const size_t n, float* sums);
+  static void addColumnAVX2(const float factor, const float* column, const size_t n, float* sums);
+};
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// local dependencies
+#include "david/types.h"
+
+// system dependencies
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace david {
+
+/**
+ * Speed benchmark, searches a fixed set of positions to a fixed depth.
+ *
+ * Every position is searched from a cleared transposition table and
+ * history, without a clock, so the total number of nodes only changes when
+ * the search or the evaluation changes. That number is the signature of a
+ * build, and the nodes per second compare builds and hardware.
+ */
+class Bench {
+ public:
+  static constexpr int DEFAULT_DEPTH = 6;
+  static constexpr int DEFAULT_THREADS = 1;
+  static constexpr int DEFAULT_HASH = 16; // MB
+
+  struct Result {
+    uint64_t nodes;
+    int time; // milliseconds
+    uint64_t nps;
+  };
+
+  Bench(type::TreeGen_t& tg, type::Search_t& search);
+
+  /**
+   * Search every position, and print the totals.
+   * @param depth iterations of every search
+   * @param threads search threads, the search is single threaded so only 1 is used
+   * @param hash transposition table size in MB
+   * @param out where the totals are written
+   * @return the totals
+   */
+  Result run(const int depth, const int threads, const int hash, std::ostream& out);
+
+  // FEN strings of the built in positions
+  static const std::vector<std::string>& positions();
+
+ private:
+  type::TreeGen_t& treeGen;
+  type::Search_t& search;
+};
+
+}
@@ -5,6 +5,7 @@
 #include "david/bitboard.h"
 #include "david/ANN/ANN.h"
 #include "david/Search.h"
+#include "david/PolyglotBook.h"
 #include "david/TreeGen.h"
 
 // git submodule dependencies
@@ -26,9 +27,6 @@ struct Player {
 
 class ChessEngine {
   bool UCIProtocolActivated;
-  int wtime;
-  int btime;
-  int timeLeft;
 
   // this is sent to other classes so they can communicate with each other
   type::NeuralNetwork_t neuralNet;
@@ -44,6 +42,20 @@ class ChessEngine {
   volatile bool uciMode;
   std::thread searchThread;
 
+  // set when ponderhit turned the running ponder search into a normal search
+  std::atomic<bool> ponderHitReceived;
+
+  // opening book, only used when the GUI lets the engine play its own book moves
+  PolyglotBook book;
+  bool ownBook;
+  bool bookBestMove;
+
+  /**
+   * Send the best move of the last search to the GUI, together with the
+   * latency since the deadline or stop command when the search was stopped.
+   */
+  void sendBestMove();
+
  public:
 
   ChessEngine();
@@ -172,6 +184,17 @@ class ChessEngine {
    */
   void findBestMove();
 
+  /**
+   * Search the built in benchmark positions, see Bench.
+   * The tree and the transposition table are cleared afterwards.
+   *
+   * @param depth iterations of every search
+   * @param threads search threads
+   * @param hash transposition table size in MB
+   * @return uint64_t nodes of all the searches, the signature of the build
+   */
+  uint64_t bench(const int depth, const int threads, const int hash);
+
 
 };
 
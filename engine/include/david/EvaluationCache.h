@@ -0,0 +1,100 @@
+#pragma once
+
+// local dependencies
+#include "david/types.h"
+#include "david/bitboard.h"
+
+// system dependencies
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace david {
+
+/**
+ * Hash table of ANN scores, keyed by position.
+ *
+ * Transpositions and repeated iterations reach the same positions again and
+ * again, a stored score skips the input conversion and the network.
+ *
+ * The table can be used by several threads without locks. Every slot is two
+ * atomic words, the score and the key xor the score, so a slot written by
+ * two threads at once is seen as a miss instead of a wrong score.
+ *
+ * The network inputs include the move counters, so they are part of the key
+ * and a hit always returns what the network would have.
+ *
+ * The probes and hits are counted per thread, so the search threads don't
+ * write to a shared cache line on every probe.
+ */
+class EvaluationCache {
+ public:
+  static constexpr size_t DEFAULT_SIZE = 16; // MB
+
+  // threads with counters of their own, more threads share them
+  static constexpr unsigned int MAX_THREADS = 64;
+
+  EvaluationCache(const size_t megabytes = DEFAULT_SIZE);
+  EvaluationCache(const EvaluationCache&) = delete;
+  void operator=(const EvaluationCache&) = delete;
+
+  /**
+   * Change the size of the table, this clears it. Must not be called while
+   * the table is in use.
+   * @param megabytes approximate memory use, 0 turns the cache off
+   */
+  void resize(const size_t megabytes);
+  void clear();
+
+  inline bool isEnabled() const {
+    return this->slots != nullptr;
+  }
+
+  /**
+   * @param gs position
+   * @return uint64_t key of the position, zobrist hash and move counters
+   */
+  static uint64_t key(const type::gameState_t& gs);
+
+  /**
+   * Find the score of a position.
+   * @param key from EvaluationCache::key
+   * @param score set on a hit
+   * @return true if the position is stored
+   */
+  bool probe(const uint64_t key, int& score);
+
+  /**
+   * Store the score of a position, replacing the slot content.
+   * @param key from EvaluationCache::key
+   * @param score ANN score
+   */
+  void store(const uint64_t key, const int score);
+
+  size_t size() const;
+  uint64_t getProbes() const;
+  uint64_t getHits() const;
+  void resetCounters();
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> check; // key ^ data
+    std::atomic<uint64_t> data;  // score, with a bit set so an empty slot never matches
+  };
+
+  std::unique_ptr<Slot[]> slots; // nullptr when turned off
+  size_t mask;
+
+  // counters of a thread, on a cache line of their own
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> probes;
+    std::atomic<uint64_t> hits;
+  };
+
+  std::array<Counters, MAX_THREADS> counters;
+  static unsigned int counterSlot();
+};
+
+}
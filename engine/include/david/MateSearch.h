@@ -0,0 +1,92 @@
+#pragma once
+
+// local dependencies
+#include "david/david.h"
+#include "david/types.h"
+#include "david/bitboard.h"
+#include "david/SearchControl.h"
+#include "david/SearchInfo.h"
+
+// system dependencies
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace david {
+
+/**
+ * Mate finder for "go mate N", a depth-first proof-number search (df-pn).
+ *
+ * The side to move is the attacker and only its checking moves are
+ * generated, the defender answers with all of its legal moves, which are
+ * the evasions. A position is proven once every defence ends in mate, and
+ * disproven once the attacker runs out of checks or plies.
+ *
+ * Proof and disproof numbers are kept in a transposition table of its own,
+ * keyed by position and the number of plies left, so results found for
+ * shorter mates are never mixed up with longer ones. Mates are tried from
+ * one move and up, so the first mate found is the shortest one.
+ */
+class MateSearch {
+ public:
+  static constexpr uint32_t INFINITE = 1u << 30;
+  static constexpr size_t DEFAULT_SIZE = 16; // MB
+
+  MateSearch(const SearchControl& control, SearchInfo& info, const size_t megabytes = DEFAULT_SIZE);
+  MateSearch(const MateSearch&) = delete;
+  void operator=(const MateSearch&) = delete;
+
+  /**
+   * Look for a mate of the side to move.
+   * @param root position to search from
+   * @param moves longest mate to look for, in moves of the side to move
+   * @param thread counter slot in info
+   * @return number of moves of the shortest mate, 0 if none was found
+   */
+  int search(const type::gameState_t& root, const int moves, const unsigned int thread = 0);
+
+  /**
+   * @return the moves of the mate found by the last search, attacker first
+   */
+  const std::vector<type::move_t>& getPV() const;
+
+  void resize(const size_t megabytes);
+  void clear();
+
+ private:
+  struct Entry {
+    uint64_t key;
+    uint32_t pn;
+    uint32_t dn;
+    uint8_t depth;
+  };
+
+  struct Ply {
+    type::gameState_t position;
+    uint16_t nrOfChildren;
+    std::array<type::gameState_t, constant::MAXMOVES> children;
+    std::array<type::move_t, constant::MAXMOVES> moves;
+    std::array<uint64_t, constant::MAXMOVES> keys;
+  };
+
+  const SearchControl& control;
+  SearchInfo& info;
+  unsigned int threadID;
+  bool aborted;
+  uint64_t nodes;
+
+  std::vector<Entry> table;
+  size_t mask;
+  std::vector<Ply> plies;
+  std::vector<type::move_t> pv;
+
+  void mid(const int ply, const uint32_t thpn, const uint32_t thdn, const int depth);
+  void generateChildren(const int ply);
+  bool extractPV(const int depth);
+
+  bool lookup(const uint64_t key, const int depth, uint32_t& pn, uint32_t& dn) const;
+  void store(const uint64_t key, const int depth, const uint32_t pn, const uint32_t dn);
+  size_t slot(const uint64_t key, const int depth) const;
+};
+
+}
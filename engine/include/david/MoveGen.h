@@ -24,8 +24,8 @@ class MoveGen {
   friend class MoveGenTest;
 #endif
  public:
-  MoveGen(type::gameState_t& gs);
-  void setGameState(type::gameState_t& gs);
+  MoveGen(const type::gameState_t& gs);
+  void setGameState(const type::gameState_t& gs);
 
   // run all the psuedo move generators
   void runAllMoveGenerators();
@@ -45,8 +45,12 @@ class MoveGen {
 
   // extract all possible sub gameStates
   template <size_t N>
-  uint16_t generateGameStates(std::array<type::gameState_t, N>& arr, const unsigned long start = 0, const unsigned long stop = N - 1)
-  {
+  uint16_t generateGameStates(
+      std::array<type::gameState_t, N>& arr,
+      const unsigned long start = 0,
+      const unsigned long stop = N - 1,
+      type::move_t* encodedMoves = nullptr
+  ) {
     if (stop >= N) {
       throw "MoveGen@generateGameStates: `end` is larger than `N`";
     }
@@ -64,226 +68,295 @@ class MoveGen {
 
 
     //generate gameStates based on moves
-    type::bitboard_t oldPieces = 0ull;
     type::gameState_t gs{};
     const auto nrOfPieceTypes = movegen::moves.size();
     for (unsigned long pieceType = 0; pieceType < nrOfPieceTypes; pieceType++) {
 
-      oldPieces = this->state.piecesArr[pieceType][0];
-
       // for every pieceType
       for (unsigned long board = 0; board < this->index_moves[pieceType]; board++) {
-
-        //make sure the king hasn't been captured.
-        if ((this->state.piecesArr[::david::constant::index::king][1] & movegen::moves[pieceType][board]) > 0) {
+        if (!this->generateGameState(pieceType, movegen::moves[pieceType][board], gs)) {
           continue;
         }
 
-        // create a child game state
-        gs = this->reversedState;
-        gs.piecesArr[pieceType][1] = movegen::moves[pieceType][board];       // the colour that just moved. now opponent.
+        // valid move, add it to the record.
+        if (encodedMoves != nullptr) {
+          encodedMoves[index_gameStates] = this->encodeMove(pieceType, movegen::moves[pieceType][board]);
+        }
+        arr[start + index_gameStates++] = gs;
+      }
+    }
+
+    // #########################################################################
+
+    return index_gameStates;
+  }
 
-        // update moved piece
-        gs.piecess[1] ^= oldPieces; // turn off all pieces
-        gs.piecess[1] |= movegen::moves[pieceType][board]; // since the move contains the not moved pieces, + the newly moved one. just add it.
+  /**
+   * Create the child game state for one move of the active colour.
+   *
+   * @param pieceType index of the piece type that moves, or the promoted piece type
+   * @param moveBoard the board of that piece type after the move
+   * @param gs where the child is written
+   * @return false if the move is illegal, gs is then garbage
+   */
+  inline bool generateGameState(const unsigned long pieceType, const type::bitboard_t moveBoard, type::gameState_t& gs) const
+  {
+    const type::bitboard_t oldPieces = this->state.piecesArr[pieceType][0];
 
+    //make sure the king hasn't been captured.
+    if ((this->state.piecesArr[::david::constant::index::king][1] & moveBoard) > 0) {
+      return false;
+    }
 
-        // Check for capture, and destroy captured piece!
-        // this is done by finding bits laying ontop of each other.
-        if ((movegen::moves[pieceType][board] & this->state.piecess[1]) > 0) {
-          const uint8_t attackedPiecePosition = ::utils::LSB(movegen::moves[pieceType][board] & this->state.piecess[1]);
+    // create a child game state
+    gs = this->reversedState;
+    gs.piecesArr[pieceType][1] = moveBoard;       // the colour that just moved. now opponent.
 
-          for (auto& bbArr : gs.piecesArr) {
-            // since gs has the opposite indexes, use 0 in stead of 1.
-            if (::utils::bitAt(bbArr[0], attackedPiecePosition)) {
-              ::utils::flipBitOff(bbArr[0], attackedPiecePosition);
-              break;
-            }
-          }
+    // update moved piece
+    gs.piecess[1] ^= oldPieces; // turn off all pieces
+    gs.piecess[1] |= moveBoard; // since the move contains the not moved pieces, + the newly moved one. just add it.
 
-          // if king has captured a piece, turn off castling.
-          // king isn't dealt with whenever a capture takes place normally.
-          if (pieceType == ::david::constant::index::king) {
-            gs.queenCastlings[1] = false;
-            gs.kingCastlings[1] = false;
-          }
 
-          // do the same for rook moves
-          else if (pieceType == ::david::constant::index::rook) {
-            if (gs.kingCastlings[1]
-                && (gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 1ull : 72057594037927937ull))
-                    == 0) {
-              // there is no rook at its home anymore. however what if theres a friendly rook at the hostile rank?
-              gs.kingCastlings[1] = false;
-            }
-              // queen side
-            else if (gs.queenCastlings[1]
-                && (gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 128ull : 9223372036854775808ull))
-                    == 0) {
-              // there is no rook at its home anymore. however what if theres a friendly rook at the hostile rank?
-              gs.queenCastlings[1] = false;
-            }
-          }
-          
-          // check if this destroys castling for opponent
-          if (::utils::bitAt(9295429630892703873ull, attackedPiecePosition)) {
-            // one of the corners was attacked, make sure the opponent has castling rights
-            if (gs.kingCastlings[0] || gs.queenCastlings[0]) {
-              // opponent has castling rights.
-              if (attackedPiecePosition == (gs.isWhite ? 63 : 7) && gs.queenCastlings[0]) {
-                gs.queenCastlings[0] = false;
-              }
-              else if (attackedPiecePosition == (gs.isWhite ? 56 : 0) && gs.kingCastlings[0]) {
-                gs.kingCastlings[0] = false;
-              }
-            }
-          }
+    // Check for capture, and destroy captured piece!
+    // this is done by finding bits laying ontop of each other.
+    if ((moveBoard & this->state.piecess[1]) > 0) {
+      const uint8_t attackedPiecePosition = ::utils::LSB(moveBoard & this->state.piecess[1]);
 
-          // update pieces
-          ::utils::flipBitOff(gs.piecess[0], attackedPiecePosition);
+      for (auto& bbArr : gs.piecesArr) {
+        // since gs has the opposite indexes, use 0 in stead of 1.
+        if (::utils::bitAt(bbArr[0], attackedPiecePosition)) {
+          ::utils::flipBitOff(bbArr[0], attackedPiecePosition);
+          break;
         }
+      }
+
+      // if king has captured a piece, turn off castling.
+      // king isn't dealt with whenever a capture takes place normally.
+      if (pieceType == ::david::constant::index::king) {
+        gs.queenCastlings[1] = false;
+        gs.kingCastlings[1] = false;
+      }
 
-          // en passant capture.
-        else if (pieceType == 0 && this->state.enPassant > 15 && ::utils::bitAt(movegen::moves[0][board], this->state.enPassant)) {
-          ::utils::flipBitOff(gs.piecesArr[0][0], this->state.enPassantPawn);
-          ::utils::flipBitOff(gs.piecess[0], this->state.enPassantPawn);
-          gs.passant = true;
+      // do the same for rook moves
+      else if (pieceType == ::david::constant::index::rook) {
+        if (gs.kingCastlings[1]
+            && (gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 1ull : 72057594037927937ull))
+                == 0) {
+          // there is no rook at its home anymore. however what if theres a friendly rook at the hostile rank?
+          gs.kingCastlings[1] = false;
+        }
+          // queen side
+        else if (gs.queenCastlings[1]
+            && (gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 128ull : 9223372036854775808ull))
+                == 0) {
+          // there is no rook at its home anymore. however what if theres a friendly rook at the hostile rank?
+          gs.queenCastlings[1] = false;
+        }
+      }
+      
+      // check if this destroys castling for opponent
+      if (::utils::bitAt(9295429630892703873ull, attackedPiecePosition)) {
+        // one of the corners was attacked, make sure the opponent has castling rights
+        if (gs.kingCastlings[0] || gs.queenCastlings[0]) {
+          // opponent has castling rights.
+          if (attackedPiecePosition == (gs.isWhite ? 63 : 7) && gs.queenCastlings[0]) {
+            gs.queenCastlings[0] = false;
+          }
+          else if (attackedPiecePosition == (gs.isWhite ? 56 : 0) && gs.kingCastlings[0]) {
+            gs.kingCastlings[0] = false;
+          }
         }
+      }
+
+      // update pieces
+      ::utils::flipBitOff(gs.piecess[0], attackedPiecePosition);
+    }
+
+      // en passant capture.
+    else if (pieceType == 0 && this->state.enPassant > 15 && ::utils::bitAt(moveBoard, this->state.enPassant)) {
+      ::utils::flipBitOff(gs.piecesArr[0][0], this->state.enPassantPawn);
+      ::utils::flipBitOff(gs.piecess[0], this->state.enPassantPawn);
+      gs.passant = true;
+    }
 
-          // identify a castling situation
-        else if (pieceType == ::david::constant::index::king) {
-          // king side castling
-          if (gs.kingCastlings[1] && (gs.piecesArr[5][1] & 144115188075855874ULL) > 0) {
-            type::bitboard_t castleBoard = gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 1ull : 72057594037927936ull);
-            type::bitboard_t diff = castleBoard | (castleBoard << 2);
+      // identify a castling situation
+    else if (pieceType == ::david::constant::index::king) {
+      // king side castling
+      if (gs.kingCastlings[1] && (gs.piecesArr[5][1] & 144115188075855874ULL) > 0) {
+        type::bitboard_t castleBoard = gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 1ull : 72057594037927936ull);
+        type::bitboard_t diff = castleBoard | (castleBoard << 2);
 
-            gs.piecesArr[::david::constant::index::rook][1] ^= diff;
-            gs.piecess[1] ^= diff;
+        gs.piecesArr[::david::constant::index::rook][1] ^= diff;
+        gs.piecess[1] ^= diff;
 
 #ifdef DAVID_TEST
-            gs.castled = true;
+        gs.castled = true;
 #endif
-          }
+      }
 
-          else if (gs.queenCastlings[1] && (gs.piecesArr[5][1] & 2305843009213693984ULL) > 0) {
-            type::bitboard_t castleBoard = gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 128ull : 9223372036854775808ull);
-            type::bitboard_t diff = castleBoard | (castleBoard >> 3);
+      else if (gs.queenCastlings[1] && (gs.piecesArr[5][1] & 2305843009213693984ULL) > 0) {
+        type::bitboard_t castleBoard = gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 128ull : 9223372036854775808ull);
+        type::bitboard_t diff = castleBoard | (castleBoard >> 3);
 
-            gs.piecesArr[::david::constant::index::rook][1] ^= diff;
-            gs.piecess[1] ^= diff;
+        gs.piecesArr[::david::constant::index::rook][1] ^= diff;
+        gs.piecess[1] ^= diff;
 
 #ifdef DAVID_TEST
-            gs.castled = true;
+        gs.castled = true;
 #endif
-          }
+      }
 
-          // the king has moved so disable castling for that colour
-          gs.queenCastlings[1] = false;
-          gs.kingCastlings[1] = false;
-        }
+      // the king has moved so disable castling for that colour
+      gs.queenCastlings[1] = false;
+      gs.kingCastlings[1] = false;
+    }
 
-          // If a rook move, disable that sides castling rights
-        else if (pieceType == ::david::constant::index::rook) {
-          // king side
-          if (gs.kingCastlings[1] && (gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 1ull : 72057594037927936ull)) == 0) {
-            // there is no rook at its home anymore. however what if there's a friendly rook at the hostile rank?
-            gs.kingCastlings[1] = false;
-          }
-            // queen side
-          else if (gs.queenCastlings[1] && (gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 128ull : 9223372036854775808ull)) == 0) {
-            // there is no rook at its home anymore. however what if there's a friendly rook at the hostile rank?
-            gs.queenCastlings[1] = false;
-          }
-        }
+      // If a rook move, disable that sides castling rights
+    else if (pieceType == ::david::constant::index::rook) {
+      // king side
+      if (gs.kingCastlings[1] && (gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 1ull : 72057594037927936ull)) == 0) {
+        // there is no rook at its home anymore. however what if there's a friendly rook at the hostile rank?
+        gs.kingCastlings[1] = false;
+      }
+        // queen side
+      else if (gs.queenCastlings[1] && (gs.piecesArr[::david::constant::index::rook][1] & (gs.isWhite ? 128ull : 9223372036854775808ull)) == 0) {
+        // there is no rook at its home anymore. however what if there's a friendly rook at the hostile rank?
+        gs.queenCastlings[1] = false;
+      }
+    }
 
-        // a piece was promoted, so remove the pawn that was sacrificed for this promotion
-        // every promotion will contains a active bit set to the position of an existing pawn
-        if (pieceType > 0 && pieceType < 5 && (movegen::moves[pieceType][board] & gs.piecesArr[0][1]) > 0) {
-          const type::bitboard_t pawnBoard = movegen::moves[pieceType][board] & gs.piecesArr[0][1];
+    // a piece was promoted, so remove the pawn that was sacrificed for this promotion
+    // every promotion will contains a active bit set to the position of an existing pawn
+    if (pieceType > 0 && pieceType < 5 && (moveBoard & gs.piecesArr[0][1]) > 0) {
+      const type::bitboard_t pawnBoard = moveBoard & gs.piecesArr[0][1];
 
 #ifdef DAVID_TEST
-          if (::utils::nrOfActiveBits(pawnBoard) != 1) {
-            std::__throw_overflow_error("Too many or few pawns set in promotion..");
-          }
+      if (::utils::nrOfActiveBits(pawnBoard) != 1) {
+        std::__throw_overflow_error("Too many or few pawns set in promotion..");
+      }
 #endif
 
-          // deactivate the pawn position
-          gs.piecesArr[0][1] ^= pawnBoard;
-          gs.piecesArr[pieceType][1] = (gs.piecesArr[pieceType][1] | pawnBoard) ^ pawnBoard;
-          gs.piecess[1] = (gs.piecess[1] | pawnBoard) ^ pawnBoard;
+      // deactivate the pawn position
+      gs.piecesArr[0][1] ^= pawnBoard;
+      gs.piecesArr[pieceType][1] = (gs.piecesArr[pieceType][1] | pawnBoard) ^ pawnBoard;
+      gs.piecess[1] = (gs.piecess[1] | pawnBoard) ^ pawnBoard;
 
-          // activate the promoted piece position
-          //gs.piecesArr[pieceType][1] |= ((movegen::moves[pieceType][board] ^ pawnBoard) ^ gs.piecesArr[pieceType][1]);
-          //gs.piecess[1] |= ((movegen::moves[pieceType][board] ^ pawnBoard) ^ gs.piecesArr[pieceType][1]);
+      // activate the promoted piece position
+      //gs.piecesArr[pieceType][1] |= ((moveBoard ^ pawnBoard) ^ gs.piecesArr[pieceType][1]);
+      //gs.piecess[1] |= ((moveBoard ^ pawnBoard) ^ gs.piecesArr[pieceType][1]);
 
 
 
 
 #ifdef DAVID_TEST
-          gs.promoted = true;
+      gs.promoted = true;
 #endif
-        }
+    }
 
 
-        // complete board merge
-        gs.combinedPieces = gs.piecess[0] | gs.piecess[1];
+    // complete board merge
+    gs.combinedPieces = gs.piecess[0] | gs.piecess[1];
 
 
-        // en passant record
-        if (pieceType == ::david::constant::index::pawn && !gs.passant) {
-          auto before = this->state.piecesArr[0][0];
-          auto now = gs.piecesArr[0][1];
-          const auto diff = (before ^ now);
-          before &= diff;
-          now &= diff;
+    // en passant record
+    if (pieceType == ::david::constant::index::pawn && !gs.passant) {
+      auto before = this->state.piecesArr[0][0];
+      auto now = gs.piecesArr[0][1];
+      const auto diff = (before ^ now);
+      before &= diff;
+      now &= diff;
 
-          if ((before & 71776119061282560) > 0 && (now & 1099494850560) > 0) {
-            // its en passant
-            gs.enPassantPawn = ::utils::LSB(now);
-            gs.enPassant = this->state.isWhite ? gs.enPassantPawn - 8 : gs.enPassantPawn + 8;
-          }
-        }
+      if ((before & 71776119061282560) > 0 && (now & 1099494850560) > 0) {
+        // its en passant
+        gs.enPassantPawn = ::utils::LSB(now);
+        gs.enPassant = this->state.isWhite ? gs.enPassantPawn - 8 : gs.enPassantPawn + 8;
+      }
+    }
 
 
 
-        // check?
-        if (this->dangerousPosition(gs.piecesArr[::david::constant::index::king][1], gs, 0)) {
-          continue;
-        }
+    // check?
+    if (this->dangerousPosition(gs.piecesArr[::david::constant::index::king][1], gs, 0)) {
+      return false;
+    }
 
-        // store the completed gamestate
-        // TODO: fullstep, etc.
-
-        // half step
-        // Validate half moves
-        if (!::utils::gameState::isHalfMove(
-            this->state.piecess[0],
-            gs.piecess[0],
-            this->state.piecesArr[0][0],
-            this->state.piecesArr[0][1],
-            gs.piecesArr[0][0],
-            gs.piecesArr[0][1]
-        )) {
-          gs.halfMoves = 0;
-        }
+    // store the completed gamestate
+    // TODO: fullstep, etc.
+
+    // half step
+    // Validate half moves
+    if (!::utils::gameState::isHalfMove(
+        this->state.piecess[0],
+        gs.piecess[0],
+        this->state.piecesArr[0][0],
+        this->state.piecesArr[0][1],
+        gs.piecesArr[0][0],
+        gs.piecesArr[0][1]
+    )) {
+      gs.halfMoves = 0;
+    }
 
-        gs.isWhite = !this->state.isWhite;
+    gs.isWhite = !this->state.isWhite;
 
-        // is this new game state in check?
+    // is this new game state in check?
 #ifdef DAVID_TEST
-        if (this->dangerousPosition(gs.piecesArr[::david::constant::index::king][0], gs)) {
-          gs.isInCheck = true;
-        }
+    if (this->dangerousPosition(gs.piecesArr[::david::constant::index::king][0], gs)) {
+      gs.isInCheck = true;
+    }
 #endif
 
-        // valid move, add it to the record.
-        arr[start + index_gameStates++] = gs;
-      }
+    return true;
+  }
+
+  /**
+   * Encode a generated move as from square, to square and promotion piece type.
+   * bits 0-5: from, bits 6-11: to, bits 12-14: promoted piece type, 0 if none.
+   *
+   * @param pieceType index of the piece type that moves, or the promoted piece type
+   * @param moveBoard the board of that piece type after the move
+   * @return type::move_t
+   */
+  inline type::move_t encodeMove(const unsigned long pieceType, const type::bitboard_t moveBoard) const
+  {
+    const type::bitboard_t oldPieces = this->state.piecesArr[pieceType][0];
+    const type::bitboard_t pawns = this->state.piecesArr[::david::constant::index::pawn][0];
+
+    // promotions carry the pawn position in the board of the promoted piece type
+    if (pieceType > 0 && pieceType < 5 && (moveBoard & pawns) > 0) {
+      const type::bitboard_t from = moveBoard & pawns;
+      const type::bitboard_t to = moveBoard & ~oldPieces & ~from;
+      return ::utils::LSB(from) | (::utils::LSB(to) << 6) | (pieceType << 12);
     }
 
-    // #########################################################################
+    return ::utils::LSB(oldPieces & ~moveBoard) | (::utils::LSB(moveBoard & ~oldPieces) << 6);
+  }
 
-    return index_gameStates;
+  /**
+   * Create the child game state of an encoded move, see encodeMove.
+   * Gives the exact same game state as generateGameStates does.
+   *
+   * @param move type::move_t
+   * @param gs where the child is written
+   * @return false if the move is illegal in this state
+   */
+  inline bool applyMove(const type::move_t move, type::gameState_t& gs) const
+  {
+    const type::bitboard_t from = ::utils::indexToBitboard(move & 63);
+    const type::bitboard_t to = ::utils::indexToBitboard((move >> 6) & 63);
+    const uint8_t promotion = static_cast<uint8_t>((move >> 12) & 7);
+
+    if (promotion > 0) {
+      return this->generateGameState(promotion, this->state.piecesArr[promotion][0] | from | to, gs);
+    }
+
+    for (uint8_t pieceType = 0; pieceType < 6; pieceType++) {
+      const type::bitboard_t pieces = this->state.piecesArr[pieceType][0];
+      if ((pieces & from) > 0) {
+        return this->generateGameState(pieceType, (pieces ^ from) | to, gs);
+      }
+    }
+
+    return false;
   }
 
   // how many possible moves can be generated from this state?
@@ -292,6 +365,16 @@ class MoveGen {
     return 0;
   }
 
+  /**
+   * Check if the active colour's king is attacked in the current state.
+   *
+   * @return true if the active colour is in check
+   */
+  bool isInCheck() const
+  {
+    return this->dangerousPosition(this->state.piecesArr[::david::constant::index::king][0], this->state);
+  }
+
   type::gameState_t generateAttacks() {
     type::gameState_t gs = this->state;
 
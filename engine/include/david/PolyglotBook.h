@@ -0,0 +1,94 @@
+#pragma once
+
+// local dependencies
+#include "david/david.h"
+#include "david/types.h"
+#include "david/bitboard.h"
+
+// system dependencies
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace david {
+
+/**
+ * Opening book in the Polyglot .bin format.
+ *
+ * The file is memory mapped and never copied. It's a list of 16 byte
+ * entries sorted by the Polyglot zobrist key of the position, so the moves
+ * of a position are found with a binary search.
+ *
+ * A book move is only played if it's a legal move of the position, so a
+ * broken or foreign book can't make the engine send an illegal move.
+ */
+class PolyglotBook {
+ public:
+  /**
+   * One book move, with the numbers in the host byte order.
+   */
+  struct Entry {
+    uint64_t key;
+    uint16_t move;   // to file, to row, from file, from row and promotion, 3 bits each
+    uint16_t weight; // how often the move should be played relative to the others
+    uint32_t learn;
+  };
+
+  // size of an entry in the file
+  static constexpr size_t ENTRY_SIZE = 16;
+
+  PolyglotBook();
+  ~PolyglotBook();
+  PolyglotBook(const PolyglotBook&) = delete;
+  void operator=(const PolyglotBook&) = delete;
+
+  /**
+   * Close the current book, and map a new one.
+   * @param path .bin file, "<empty>" for none
+   * @return false if the file is missing or isn't a Polyglot book
+   */
+  bool open(const std::string& path);
+  void close();
+
+  bool isOpen() const;
+
+  // number of entries in the book
+  size_t size() const;
+
+  /**
+   * Polyglot zobrist key of a position, which is what the book is sorted by.
+   * En passant is only part of the key if a pawn can take.
+   * @param gs gameState_t&
+   * @return uint64_t key
+   */
+  static uint64_t key(const type::gameState_t& gs);
+
+  /**
+   * All entries of a position, in the order of the book.
+   * @param key Polyglot key of the position
+   * @return entries, empty if the position isn't in the book
+   */
+  std::vector<Entry> find(const uint64_t key) const;
+
+  /**
+   * Pick a book move for a position.
+   * @param gs position to move from
+   * @param bestOnly play the move with the highest weight instead of a weighted random one
+   * @param move set to the move in long algebraic notation
+   * @return false if the book has no legal move for the position
+   */
+  bool probe(const type::gameState_t& gs, const bool bestOnly, std::string& move);
+
+ private:
+  const uint8_t* data;
+  size_t fileSize;
+  size_t entries;
+
+  std::mt19937 random;
+
+  Entry entry(const size_t index) const;
+};
+
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+// local dependencies
+#include "david/david.h"
+#include "david/types.h"
+#include "david/bitboard.h"
+
+namespace david {
+
+/**
+ * Static exchange evaluation, the material won or lost by the sequence of
+ * captures a move starts on its target square, when both sides always take
+ * back with their least valuable piece and may stop taking at any time.
+ *
+ * Only the bitboards are used, no moves are generated and nothing is
+ * evaluated, so it's cheap enough to order and prune moves with. Sliders
+ * behind a piece that takes are found once that piece has left the square
+ * behind them, so batteries are part of the exchange.
+ *
+ * Pins and checks are not considered, except that a king never takes a
+ * defended piece.
+ */
+namespace see {
+
+// material values of the piece type indexes, in the scale of the board scores
+constexpr int VALUES[6] = {100, 500, 300, 300, 900, 20000};
+
+inline int value(const unsigned int pieceType) {
+  return VALUES[pieceType];
+}
+
+/**
+ * Every piece of both colours that attacks a square.
+ * @param gs position the pieces are taken from
+ * @param square index of the square
+ * @param occupied squares that block the sliders, pieces outside it are ignored
+ * @return type::bitboard_t attackers
+ */
+type::bitboard_t attackersTo(const type::gameState_t& gs, const uint8_t square, const type::bitboard_t occupied);
+
+/**
+ * Every square the pieces of one type and colour attack.
+ * @param gs position the pieces are taken from
+ * @param pieceType index of the piece type
+ * @param colour 0 for the active colour
+ * @return type::bitboard_t attacked squares, also those of its own pieces
+ */
+type::bitboard_t attacksBy(const type::gameState_t& gs, const unsigned int pieceType, const unsigned int colour);
+
+/**
+ * Material the active colour wins, or loses if negative, by playing a move
+ * and the exchange that follows. A quiet move to a square the opponent
+ * attacks loses the piece unless it's defended well enough.
+ * @param gs position before the move
+ * @param move encoded move, see MoveGen::encodeMove
+ * @return int material balance
+ */
+int evaluate(const type::gameState_t& gs, const type::move_t move);
+
+/**
+ * Check if a move takes a piece, including en passant.
+ * @param gs position before the move
+ * @param move encoded move, see MoveGen::encodeMove
+ * @return true on captures
+ */
+bool isCapture(const type::gameState_t& gs, const type::move_t move);
+
+}
+}
@@ -5,12 +5,22 @@
 #include "david/types.h"
 #include "david/bitboard.h"
 #include "david/TreeGen.h"
+#include "david/TimeManager.h"
+#include "david/SearchControl.h"
+#include "david/SearchInfo.h"
+#include "david/SearchStats.h"
+#include "david/SearchStack.h"
+#include "david/TranspositionTable.h"
+#include "david/MateSearch.h"
+#include "david/Syzygy.h"
 
 // system dependencies
 #include <string>
+#include <array>
 #include <atomic>
 #include <future>
 #include <thread>
+#include <vector>
 
 
 // forward declarations
@@ -33,7 +43,8 @@ class Search {
   void operator=(const Search&) = delete;     // delete the copy-assignment operator
   int searchInit();
   int iterativeDeepening();
-  int negamax(unsigned int index, int alpha, int beta, int depth, int iterativeDepthLimit);
+  int negamax(int ply, int alpha, int beta, int depth, int iterativeDepthLimit, bool nullMoveAllowed = true);
+  int quiescence(int ply, int alpha, int beta);
   void setAbort(bool isAborted);
   void setComplete(bool isComplete);
   //std::future<int> searchInstance;
@@ -57,6 +68,10 @@ class Search {
   void stopSearch();
   void quitSearch();
   void setDepth(int depth);
+  void setMaxDepth(int depth);
+  int getMaxDepth() const;
+  void setHashSize(int megabytes);
+  void clearHash();
   void setSearchMoves(std::string moves);
   void setWTime(int wtime);
   void setBTime(int btime);
@@ -68,13 +83,76 @@ class Search {
   void setMate(int mate);
   void setInfinite(bool inf);
   void setPonder(bool ponder);
+  void ponderHit();
   void setDifficulty(int difficulty);
+  void setMoveOverhead(int overhead);
+  void setStopPollInterval(int nodes);
+  void setInfoInterval(int ms);
+  void resetTimeControls();
   int getTimeUsed();
-
-  clock_t startTime;
+  uint64_t getNodes() const;
+
+  /**
+   * Register that bestmove was sent to the GUI.
+   * @return int microseconds from the deadline or stop command until now, -1 if the search wasn't stopped
+   */
+  int bestMoveSent();
+
+  // pruning and reduction settings, exposed as UCI options
+  void setNullMovePruning(bool enabled);
+  void setNullMoveReduction(int reduction);
+  void setNullMoveMinDepth(int depth);
+  void setLateMoveReductions(bool enabled);
+  void setLMRMinDepth(int depth);
+  void setLMRMinMoveIndex(int index);
+  void setLMRHistoryThreshold(int threshold);
+  void setQuiescence(bool enabled);
+  void setSEEPruning(bool enabled);
+  void setSEEPruningDepth(int depth);
+  void setSEEQuietMargin(int margin);
+  void setLazyEvaluation(bool enabled);
+  void setLazyEvalMargin(int margin);
+  void setAspirationWindow(int window);
+  void setAspirationMinDepth(int depth);
+  void setMultiPV(int lines);
+  unsigned int setSyzygyPath(const std::string& paths);
+  void setSyzygyProbeLimit(int pieces);
+  std::string getPonderMove();
+  int getAspirationFailHighs() const;
+  int getAspirationFailLows() const;
 
  private:
+  // a move of the root node, and what the last search of it found
+  struct RootMove {
+    unsigned int index; // root child in the tree
+    int score;
+    int previousScore; // score from the last iteration, centre of the aspiration window
+    std::vector<type::move_t> pv; // moves after the root move
+  };
+
   type::TreeGen_t& treeGen;
+  TimeManager timeManager;
+  SearchControl control;
+  SearchInfo info;
+  unsigned int threadID; // counter slot in info
+
+  // tuning statistics, only collected by DAVID_SEARCH_STATS builds
+  SearchStats stats;
+
+  // move lists of positions that have been expanded, outlives a search
+  TranspositionTable tt;
+
+  // positions and move lists of the path being searched
+  SearchStack stack;
+
+  // proof-number search for go mate
+  MateSearch mateSearch;
+
+  // endgame tablebases, positions with more pieces than the probe limit are searched as usual
+  Syzygy syzygy;
+  int syzygyProbeLimit;
+  bool rootInTablebase; // the root moves were filtered by the tablebases
+  int rootTablebaseScore;
 
   bool uciMode;
   std::thread searchThread;
@@ -85,19 +163,81 @@ class Search {
   int mate;
   bool infinite;
   bool ponder;
+
+  // pondering is only read by the search thread, ponderHitPending is set by the uci thread
+  bool pondering;
+  std::atomic<bool> ponderHitPending;
+  void checkPonderHit();
   uint64_t nodes;
   std::string searchMoves;
   int searchScore;
   type::gameState_t bestMove;
   int bestMoveIndex;
-  int /*time[COLOR], inc[COLOR],*/ npmsec;
+  int wtime;
+  int btime;
+  int winc;
+  int binc;
+  int npmsec;
   //void uciOutput();
   void resetSearchValues();
-  std::atomic<bool> isAborted;
+
+  // the stop flag is only read every stopPollInterval nodes
+  int stopPollInterval;
+  int nodesUntilStopPoll;
+  bool stopping;
+  bool shouldStop();
+
   int currentSearchID;
   bool isComplete;
   bool debug;
-  uint64_t nodesSearched;
+
+  // null move pruning
+  bool nullMovePruning;
+  int nullMoveReduction;
+  int nullMoveMinDepth;
+
+  // late move reductions
+  bool lateMoveReductions;
+  int lmrMinDepth;
+  int lmrMinMoveIndex;
+  int lmrHistoryThreshold;
+
+  // captures searched past the horizon, losing ones by exchange are skipped
+  bool quiescenceSearch;
+
+  // quiet moves close to the horizon that lose more than the margin per ply by exchange are skipped
+  bool seePruning;
+  int seePruningDepth;
+  int seeQuietMargin;
+
+  // only the horizon and quiescence nodes are evaluated, with a material
+  // estimate far enough outside the window the network isn't run at all
+  bool lazyEvaluation;
+  int lazyEvalMargin;
+  int evaluate(int ply, int alpha, int beta);
+
+  // aspiration windows at the root
+  int aspirationWindow;
+  int aspirationMinDepth;
+  int aspirationFailHighs;
+  int aspirationFailLows;
+
+  // root moves, best first, the first multiPV of them are reported as separate lines
+  std::vector<RootMove> rootMoves;
+  int multiPV;
+
+  bool searchRootLine(size_t pvIndex, int iterativeDepthLimit, bool& improved);
+  bool searchMate();
+  bool probeRootTablebase();
+  bool probeTablebase(int ply, const type::gameState_t& node, int& score);
+  std::string getPV(const RootMove& rootMove);
+
+  // history heuristic for quiet moves, [colour][from][to]
+  SearchStack::History history;
+
+  bool hasNonPawnMaterial(const type::gameState_t& node) const;
+  bool isQuietMove(const type::gameState_t& parent, const type::gameState_t& child) const;
+  int& historyScore(const type::gameState_t& parent, const type::move_t move);
 };
 
 
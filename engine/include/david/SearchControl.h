@@ -0,0 +1,90 @@
+#pragma once
+
+// system dependencies
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace david {
+
+/**
+ * Shared stop signalling for search threads.
+ *
+ * The stop flag is raised either by the GUI (UCI stop) or by a timer thread
+ * once the hard deadline of the search has passed. Search threads poll the
+ * flag with relaxed loads every few nodes, so the hot path never pays for a
+ * sequentially consistent atomic.
+ *
+ * The time at which the stop was triggered is recorded, so the latency
+ * between a deadline or stop command and the bestmove response can be
+ * reported.
+ */
+class SearchControl {
+ public:
+  typedef std::chrono::steady_clock::time_point timePoint_t;
+
+  SearchControl();
+  SearchControl(const SearchControl&) = delete;
+  void operator=(const SearchControl&) = delete;
+  ~SearchControl();
+
+  /**
+   * Lower the stop flag and forget any earlier stop trigger.
+   * Must be called before a search thread is started, not from within it,
+   * otherwise a stop sent right after go could be lost.
+   */
+  void reset();
+
+  /**
+   * Raise the stop flag, typically from the UCI stop command.
+   */
+  void stop();
+
+  /**
+   * Check the stop flag. Relaxed, so call it every N nodes, not every node.
+   * @return true if the search must stop
+   */
+  inline bool stopped() const {
+    return this->stopFlag.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Start a timer thread that raises the stop flag at the deadline.
+   * @param deadline timePoint_t absolute time where the search must stop
+   */
+  void startTimer(const timePoint_t deadline);
+
+  /**
+   * Cancel and join the timer thread, if running.
+   */
+  void stopTimer();
+
+  /**
+   * Register that bestmove was sent to the GUI.
+   * @return int microseconds between the stop trigger and now, -1 if the search wasn't stopped
+   */
+  int bestMoveSent();
+
+  int getLastLatency() const;
+  int getMaxLatency() const;
+
+ private:
+  std::atomic<bool> stopFlag;
+
+  // steady_clock ticks of when the stop was triggered, 0 if it hasn't been
+  std::atomic<int64_t> stopTriggeredAt;
+
+  std::thread timer;
+  std::mutex timerMutex;
+  std::condition_variable timerCondition;
+  bool timerCancelled;
+
+  int lastLatency;
+  int maxLatency;
+
+  void trigger();
+};
+
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+// system dependencies
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+namespace david {
+
+/**
+ * Telemetry of a running search, sent to the GUI as UCI info lines.
+ *
+ * Every search thread owns a counter slot which only it writes to, so
+ * counting a node is a relaxed load and store without any contention. The
+ * slots are summed whenever a report is made.
+ *
+ * Reports are throttled, so at most one info line is printed per interval
+ * unless a report is forced, like the final one of a search.
+ */
+class SearchInfo {
+ public:
+  typedef std::chrono::steady_clock::time_point timePoint_t;
+
+  // number of search threads that can report
+  static constexpr unsigned int MAX_THREADS = 64;
+
+  SearchInfo();
+  SearchInfo(const SearchInfo&) = delete;
+  void operator=(const SearchInfo&) = delete;
+
+  /**
+   * Clear all counters and start the clock of a new search.
+   */
+  void start();
+
+  /**
+   * Count a node visited by the main search of a thread.
+   * @param thread slot of the search thread
+   */
+  inline void addNode(const unsigned int thread) {
+    auto& nodes = this->counters[thread].nodes;
+    nodes.store(nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Count a node visited by the quiescence search of a thread.
+   * @param thread slot of the search thread
+   */
+  inline void addQuiescenceNode(const unsigned int thread) {
+    auto& nodes = this->counters[thread].qnodes;
+    nodes.store(nodes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Count a position found in the endgame tablebases.
+   * @param thread slot of the search thread
+   */
+  inline void addTablebaseHit(const unsigned int thread) {
+    auto& tbhits = this->counters[thread].tbhits;
+    tbhits.store(tbhits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Register how deep from the root a thread has been.
+   * @param thread slot of the search thread
+   * @param ply distance from the root node
+   */
+  inline void updateSelectiveDepth(const unsigned int thread, const int ply) {
+    auto& seldepth = this->counters[thread].seldepth;
+    if (ply > seldepth.load(std::memory_order_relaxed)) {
+      seldepth.store(ply, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Anything that knows how full the transposition table is in permill
+   * can be plugged in here. Without one, hashfull isn't reported.
+   * @param provider returns 0..1000
+   */
+  void setHashfullProvider(std::function<int()> provider);
+
+  /**
+   * Minimum time between two info lines.
+   * @param ms milliseconds, 0 reports every time
+   */
+  void setInterval(const int ms);
+
+  void setDepth(const int depth);
+  void setCurrentMove(const std::string& move, const int number);
+
+  uint64_t getNodes() const;
+  uint64_t getQuiescenceNodes() const;
+  uint64_t getNodesPerSecond() const;
+  uint64_t getTablebaseHits() const;
+  int getSelectiveDepth() const;
+  int getHashfull() const;
+  int elapsed() const;
+
+  /**
+   * Print an info line if the interval has passed since the last one.
+   * @param force print no matter when the last line was sent
+   * @return true if a line was printed
+   */
+  bool report(const bool force = false);
+
+  /**
+   * Build the info line without printing it.
+   * @return std::string the UCI info line
+   */
+  std::string toString() const;
+
+  /**
+   * Print the result of a principal variation, never throttled.
+   * @param multipv line number, starting at 1
+   * @param score of the line
+   * @param pv moves of the line in long algebraic notation
+   */
+  void reportLine(const int multipv, const int score, const std::string& pv);
+
+  /**
+   * Build a principal variation info line without printing it. The search
+   * scores a mate as constant::boardScore::HIGHEST or LOWEST, those are
+   * reported as a mate in the moves of the principal variation.
+   * @param multipv line number, starting at 1
+   * @param score of the line
+   * @param pv moves of the line in long algebraic notation, ending in the mate
+   * @return std::string the UCI info line
+   */
+  std::string lineToString(const int multipv, const int score, const std::string& pv) const;
+
+  /**
+   * Print a proven mate, never throttled.
+   * @param moves number of moves until mate
+   * @param pv moves of the mate in long algebraic notation
+   */
+  void reportMate(const int moves, const std::string& pv);
+
+  /**
+   * Build a mate info line without printing it.
+   * @param moves number of moves until mate
+   * @param pv moves of the mate in long algebraic notation
+   * @return std::string the UCI info line
+   */
+  std::string mateLineToString(const int moves, const std::string& pv) const;
+
+ private:
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> nodes;
+    std::atomic<uint64_t> qnodes;
+    std::atomic<uint64_t> tbhits;
+    std::atomic<int> seldepth;
+  };
+
+  std::array<Counters, MAX_THREADS> counters;
+
+  timePoint_t startTime;
+  timePoint_t lastReport;
+  bool hasReported;
+  int interval;
+
+  int depth;
+  std::string currentMove;
+  int currentMoveNumber;
+
+  std::function<int()> hashfullProvider;
+
+  void writeCounters(std::ostream& line) const;
+};
+
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+// local dependencies
+#include "david/david.h"
+#include "david/types.h"
+#include "david/bitboard.h"
+#include "david/TranspositionTable.h"
+#include "david/SearchStats.h"
+#include "david/ANN/DenseNetwork.h"
+
+// system dependencies
+#include <array>
+#include <vector>
+
+namespace david {
+
+/**
+ * Holds the positions along the path the search is currently looking at.
+ *
+ * Every ply has the position that was reached, plus the moves that can be
+ * played from it. Moves are stored compactly as type::move_t together with
+ * the ANN score of the position they lead to, sorted best first. A child
+ * position is only created when the search is about to visit it.
+ *
+ * Ply 0 is the root. The number of plies is configurable, so the search is
+ * not limited by how much memory a full tree would take.
+ *
+ * Captures are ordered by static exchange evaluation, those that win
+ * material come first and those that lose it last.
+ *
+ * When the network supports it, every ply keeps the first layer of its
+ * position, and the children are evaluated from it by only adding the
+ * inputs a move changed. The rest of the network runs for the children as
+ * a batch, except for those whose score is in the evaluation cache.
+ *
+ * Sorted move lists are stored in the transposition table, so a position
+ * that is expanded again, like in every new iteration of iterative
+ * deepening, doesn't have to generate and evaluate its children again.
+ *
+ * With lazy evaluation the children are not scored when they're generated.
+ * Exchanges and the history heuristic order them, and a position is only
+ * run through the network when the search asks for its score, at the
+ * horizon and in the quiescence search.
+ */
+class SearchStack {
+ public:
+  typedef ::david::ScoredMove ScoredMove;
+
+  // history heuristic for quiet moves, [colour][from][to]
+  typedef std::array<std::array<std::array<int, 64>, 64>, 2> History;
+
+  struct Ply {
+    type::gameState_t position;
+    uint64_t hash;
+    uint16_t nrOfMoves;
+    std::array<ScoredMove, constant::MAXMOVES> moves;
+
+    // principal variation from this ply and down
+    uint16_t pvLength;
+    std::vector<type::move_t> pv;
+
+    // first layer of the network for the position, made when it's first needed
+    DenseNetwork::Accumulator accumulator;
+    bool hasAccumulator;
+
+    // position.score is the ANN score, a lazy evaluation leaves it unset
+    bool hasScore;
+  };
+
+  SearchStack(const type::NeuralNetwork_t& neuralNetwork, TranspositionTable& table, const int maxDepth = constant::MAXSEARCHDEPTH);
+  SearchStack(const SearchStack&) = delete;
+  void operator=(const SearchStack&) = delete;
+
+  /**
+   * Change how many plies the search can go down, not counting the root.
+   * @param maxDepth int
+   */
+  void setMaxDepth(const int maxDepth);
+  int getMaxDepth() const;
+
+  /**
+   * Where the ANN evaluations are counted, only used by DAVID_SEARCH_STATS builds.
+   * @param searchStats SearchStats*, may be nullptr
+   */
+  void setStats(SearchStats* searchStats);
+
+  /**
+   * Order new move lists without the network, and only score the positions
+   * the search asks for. Move lists stored in the transposition table by the
+   * other mode have the wrong scores, so it should be cleared.
+   * @param enabled bool
+   */
+  void setLazyEvaluation(const bool enabled);
+  bool isLazyEvaluation() const;
+
+  /**
+   * History heuristic that orders the quiet moves of lazy move lists.
+   * @param table History*, may be nullptr
+   */
+  void setHistory(const History* table);
+
+  /**
+   * Set the position of a ply, usually the root or a root child.
+   * @param ply int
+   * @param gs position to copy
+   */
+  void setPosition(const int ply, const type::gameState_t& gs);
+
+  inline type::gameState_t& getPosition(const int ply) {
+    return this->plies[ply].position;
+  }
+
+  inline const ScoredMove& getMove(const int ply, const unsigned int i) const {
+    return this->plies[ply].moves[i];
+  }
+
+  inline bool hasScore(const int ply) const {
+    return this->plies[ply].hasScore;
+  }
+
+  /**
+   * ANN score of the position at ply, evaluated now if it wasn't when the
+   * move to it was generated.
+   * @param ply int, 1 or more
+   * @return int score from the side of the active colour
+   */
+  int score(const int ply);
+
+  /**
+   * Generate, evaluate and sort the moves of the position at ply, or
+   * reuse them from the transposition table.
+   * @param ply int
+   * @return number of legal moves
+   */
+  uint16_t generateMoves(const int ply);
+
+  /**
+   * Captures and promotions of the position at ply that don't lose material
+   * by exchange, best exchange first, for the quiescence search. Never stored
+   * in the transposition table, a stored move list is reused when there is one.
+   * @param ply int
+   * @return number of moves
+   */
+  uint16_t generateCaptures(const int ply);
+
+  /**
+   * Move the i'th move of ply to the front of its move list, also in the
+   * transposition table, so it's searched first the next time.
+   * @param ply int
+   * @param i index in the sorted move list
+   */
+  void promoteMove(const int ply, const unsigned int i);
+
+  /**
+   * Create the position after the i'th move of ply in the next ply.
+   * @param ply int
+   * @param i index in the sorted move list
+   * @return the new position
+   */
+  type::gameState_t& makeMove(const int ply, const unsigned int i);
+
+  /**
+   * Create the position after the active colour passes in the next ply.
+   * @param ply int
+   * @return the new position
+   */
+  type::gameState_t& makeNullMove(const int ply);
+
+  inline void clearPV(const int ply) {
+    this->plies[ply].pvLength = 0;
+  }
+
+  /**
+   * The i'th move of ply raised alpha, so it's followed by the principal
+   * variation of the next ply.
+   * @param ply int
+   * @param i index in the sorted move list
+   */
+  void updatePV(const int ply, const unsigned int i);
+
+  /**
+   * @param ply int
+   * @return the principal variation from ply and down
+   */
+  std::vector<type::move_t> getPV(const int ply) const;
+
+ private:
+  const type::NeuralNetwork_t& neuralnet;
+  TranspositionTable& tt;
+  SearchStats* stats;
+  const History* history;
+  bool lazy;
+  std::vector<Ply> plies;
+
+  // full game states are only needed while the children of a ply are evaluated
+  std::array<type::gameState_t, constant::MAXMOVES> children;
+  std::array<type::move_t, constant::MAXMOVES> childMoves;
+  std::array<DenseNetwork::Accumulator, DenseNetwork::BATCH> childAccumulators;
+
+  const DenseNetwork::Accumulator& accumulator(const int ply);
+  int evaluate(const int ply, type::gameState_t& child);
+  void evaluate(const int ply, type::gameState_t* children, const uint16_t n, ScoredMove* moves);
+
+  void orderByExchange(const type::gameState_t& position, ScoredMove* moves, const uint16_t len) const;
+  void orderByHistory(const type::gameState_t& position, ScoredMove* moves, const uint16_t len) const;
+};
+
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+// system dependencies
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// The statistics are only collected by builds with DAVID_SEARCH_STATS, in
+// other builds the statements given to DAVID_STATS aren't compiled at all.
+//
+#ifdef DAVID_SEARCH_STATS
+#define DAVID_STATS(statement) statement
+#else
+#define DAVID_STATS(statement)
+#endif
+
+namespace david {
+
+/**
+ * Counters that tell why a search took the nodes it took: the branching
+ * factor of every iteration, how often cut-offs come from the first move,
+ * how much the transposition table, null move pruning and late move
+ * reductions help, and how many positions the ANN had to evaluate.
+ *
+ * Only written by the search thread that owns it, so the counters are plain
+ * integers. The search dumps them as JSON when it completes, for tuning the
+ * pruning parameters against nodes-to-depth.
+ */
+class SearchStats {
+ public:
+  // a completed iteration of iterative deepening
+  struct Iteration {
+    int depth;
+    uint64_t nodes; // nodes of this iteration alone
+    int time;       // milliseconds since the search started
+  };
+
+  SearchStats();
+
+  /**
+   * Clear all counters.
+   * @param maxPly deepest ply the nodes are counted for
+   */
+  void start(const int maxPly);
+
+  inline void addNode(const int ply) {
+    this->nodes += 1;
+    if (ply >= 0 && ply < static_cast<int>(this->nodesByPly.size())) {
+      this->nodesByPly[ply] += 1;
+    }
+  }
+
+  inline void addQuiescenceNode() {
+    this->qnodes += 1;
+  }
+
+  /**
+   * A move failed high.
+   * @param moveIndex place of the move in the sorted move list
+   */
+  inline void addBetaCutoff(const unsigned int moveIndex) {
+    this->betaCutoffs += 1;
+    if (moveIndex == 0) {
+      this->firstMoveCutoffs += 1;
+    }
+  }
+
+  inline void addNullMove(const bool cutoff) {
+    this->nullMoves += 1;
+    if (cutoff) {
+      this->nullMoveCutoffs += 1;
+    }
+  }
+
+  /**
+   * A move was searched with reduced depth.
+   * @param researched the reduced search beat alpha and was searched again at full depth
+   */
+  inline void addReduction(const bool researched) {
+    this->reductions += 1;
+    if (researched) {
+      this->reductionResearches += 1;
+    }
+  }
+
+  inline void addEvaluations(const uint64_t count) {
+    this->evaluations += count;
+  }
+
+  /**
+   * Copy the counters the transposition table keeps on its own.
+   */
+  void setTranspositionTable(const uint64_t probes, const uint64_t hits);
+
+  /**
+   * Copy the root re-searches the aspiration windows caused.
+   */
+  void setAspiration(const uint64_t failHighs, const uint64_t failLows);
+
+  /**
+   * Close an iteration, the nodes counted since the last one belong to it.
+   * @param depth of the iteration
+   * @param time milliseconds since the search started
+   */
+  void iterationComplete(const int depth, const int time);
+
+  uint64_t getNodes() const;
+  uint64_t getQuiescenceNodes() const;
+  uint64_t getEvaluations() const;
+  uint64_t getBetaCutoffs() const;
+  uint64_t getFirstMoveCutoffs() const;
+  uint64_t getNullMoves() const;
+  uint64_t getNullMoveCutoffs() const;
+  uint64_t getReductions() const;
+  uint64_t getReductionResearches() const;
+  const std::vector<Iteration>& getIterations() const;
+  const std::vector<uint64_t>& getNodesByPly() const;
+
+  /**
+   * Every counter, and the rates derived from them, as one JSON object.
+   * @return std::string JSON without line breaks
+   */
+  std::string toJSON() const;
+
+ private:
+  uint64_t nodes;
+  uint64_t qnodes;
+  uint64_t evaluations;
+  uint64_t betaCutoffs;
+  uint64_t firstMoveCutoffs;
+  uint64_t ttProbes;
+  uint64_t ttHits;
+  uint64_t aspirationFailHighs;
+  uint64_t aspirationFailLows;
+  uint64_t nullMoves;
+  uint64_t nullMoveCutoffs;
+  uint64_t reductions;
+  uint64_t reductionResearches;
+
+  std::vector<uint64_t> nodesByPly;
+  std::vector<Iteration> iterations;
+  uint64_t nodesBeforeIteration;
+};
+
+}
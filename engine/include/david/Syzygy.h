@@ -0,0 +1,132 @@
+#pragma once
+
+// local dependencies
+#include "david/david.h"
+#include "david/types.h"
+#include "david/bitboard.h"
+
+// system dependencies
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace david {
+
+/**
+ * Syzygy endgame tablebases, read from local .rtbw (win/draw/loss) and
+ * .rtbz (distance to zeroing) files.
+ *
+ * The files found in SyzygyPath are registered by their material, and a
+ * file is memory mapped the first time a position with that material is
+ * probed, so only the tables that are used take up memory.
+ *
+ * The tables don't store positions with castling rights, and don't know
+ * about en passant, so probes resolve captures with a small search before
+ * the table is read. Results are given from the side to move.
+ *
+ * Probing uses move buffers owned by the instance, so every search thread
+ * needs an instance of its own.
+ */
+class Syzygy {
+ public:
+  // win, draw or loss of the side to move
+  enum WDL : int {
+    LOSS          = -2,
+    BLESSED_LOSS  = -1, // lost, but saved by the fifty move rule
+    DRAW          = 0,
+    CURSED_WIN    = 1,  // won, but drawn by the fifty move rule
+    WIN           = 2
+  };
+
+  // largest number of pieces any table can have
+  static constexpr int MAX_PIECES = 7;
+
+  Syzygy();
+  ~Syzygy();
+  Syzygy(const Syzygy&) = delete;
+  void operator=(const Syzygy&) = delete;
+
+  /**
+   * Forget the current tables, and register the ones found in a list of
+   * folders. Nothing is read until a table is probed.
+   * @param paths folders separated by ':', or ';' on windows, "<empty>" for none
+   * @return number of win/draw/loss tables found
+   */
+  unsigned int init(const std::string& paths);
+  void clear();
+
+  // number of win/draw/loss tables registered
+  unsigned int size() const;
+
+  // pieces of the largest table registered, 0 without tables
+  int getMaxPieces() const;
+
+  /**
+   * Check if a position can be in the tables: not too many pieces and no castling rights.
+   * @param gs gameState_t&
+   * @return true if a probe might succeed
+   */
+  bool canProbe(const type::gameState_t& gs) const;
+
+  /**
+   * Win, draw or loss of the side to move.
+   * @param gs position to probe
+   * @param wdl set to a value of WDL
+   * @return false if the position isn't in the tables
+   */
+  bool probeWDL(const type::gameState_t& gs, int& wdl);
+
+  /**
+   * Distance to zeroing, the plies until the next capture or pawn move of
+   * the best line. Positive if the side to move wins, negative if it loses,
+   * 0 if it's a draw. Cursed wins and blessed losses are 100 further away.
+   * @param gs position to probe
+   * @param dtz set to the distance in plies
+   * @return false if the position isn't in the tables
+   */
+  bool probeDTZ(const type::gameState_t& gs, int& dtz);
+
+  /**
+   * Distance to zeroing after a move, counted from the position before it.
+   * Used to rank the moves of the root, a mating move gets 1.
+   * @param parent position the move is played from
+   * @param child position after the move
+   * @param dtz set to the distance in plies, from the side that moved
+   * @return false if the position isn't in the tables
+   */
+  bool probeMove(const type::gameState_t& parent, const type::gameState_t& child, int& dtz);
+
+  static int nrOfPieces(const type::gameState_t& gs);
+
+  struct Table;
+
+ private:
+  enum ProbeState : int {
+    FAIL              = 0,  // no table, or the file is broken
+    OK                = 1,
+    CHANGE_STM        = -1, // the dtz table stores the other side to move
+    ZEROING_BEST_MOVE = 2   // the best move is a capture or pawn move
+  };
+
+  typedef std::array<type::gameState_t, constant::MAXMOVES> moves_t;
+
+  std::vector<std::unique_ptr<Table>> tables;
+  std::unordered_map<uint64_t, Table*> tablesByKey; // both colour orders of a table
+  int maxPieces;
+
+  // children of every recursion level of a probe
+  std::vector<std::unique_ptr<moves_t>> buffers;
+
+  void addTable(const std::string& name, const std::vector<std::string>& folders);
+  moves_t& buffer(const unsigned int level);
+  uint16_t generateMoves(const type::gameState_t& gs, const unsigned int level);
+
+  int probeTable(const type::gameState_t& gs, const bool dtz, const int wdl, ProbeState& result);
+  int search(const type::gameState_t& gs, const bool checkZeroingMoves, const unsigned int level, ProbeState& result);
+  int probeDTZ(const type::gameState_t& gs, const unsigned int level, ProbeState& result);
+};
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+// system dependencies
+#include <chrono>
+
+namespace david {
+
+/**
+ * Decides how long a search may run.
+ *
+ * Before a search starts, a soft and a hard budget is computed from the clock
+ * information given by the UCI go command. The soft budget tells the search
+ * when it should not start another iteration, while the hard budget is the
+ * absolute deadline. After every completed iteration the soft budget is
+ * extended or cut based on how stable the best move is and whether the score
+ * is dropping.
+ *
+ * All times are in milliseconds and measured with std::chrono::steady_clock.
+ */
+class TimeManager {
+ public:
+  typedef std::chrono::steady_clock::time_point timePoint_t;
+
+  TimeManager();
+
+  /**
+   * Compute the budgets for a new search and start the clock.
+   * If movetime is set it is used as a fixed budget. If neither movetime or
+   * timeLeft is set, the search has no time limit.
+   *
+   * @param timeLeft int ms left on the clock of the active colour
+   * @param increment int ms increment per move for the active colour
+   * @param movestogo int moves until the next time control, 0 if sudden death
+   * @param movetime int ms for this search exactly
+   */
+  void start(const int timeLeft, const int increment, const int movestogo, const int movetime);
+
+  /**
+   * Adjust the soft budget once an iteration has completed.
+   *
+   * @param bestMoveIndex int best root move index of the iteration
+   * @param score int score of the iteration
+   */
+  void iterationComplete(const int bestMoveIndex, const int score);
+
+  /**
+   * The opponent played the move that was pondered on, so the clock of the
+   * active colour starts now. The time spent pondering is credited against
+   * the soft budget, as that work doesn't have to be done again.
+   */
+  void ponderhit();
+
+  /**
+   * Time passed since start was called.
+   * @return int milliseconds
+   */
+  int elapsed() const;
+
+  bool softLimitReached() const;
+  bool hardLimitReached() const;
+  bool hasTimeLimit() const;
+
+  int getSoftLimit() const;
+  int getHardLimit() const;
+  timePoint_t getStartTime() const;
+  timePoint_t getHardDeadline() const;
+
+  /**
+   * Time reserved for communication lag between engine and GUI.
+   * @param overhead int milliseconds
+   */
+  void setMoveOverhead(const int overhead);
+
+ private:
+  timePoint_t startTime;
+
+  bool timeLimited;
+  bool fixedTime;
+
+  int optimum;
+  int softLimit;
+  int hardLimit;
+  int moveOverhead;
+
+  // iteration history used to scale the soft limit
+  int iterations;
+  int lastBestMoveIndex;
+  int stableIterations;
+  int lastScore;
+};
+
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// local dependencies
+#include "david/types.h"
+
+// system dependencies
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace david {
+
+/**
+ * A move together with the ANN score of the position it leads to.
+ */
+struct ScoredMove {
+  type::move_t move;
+  int score;
+};
+
+/**
+ * Hash table of positions the search has already expanded, keyed by the
+ * zobrist hash of the position.
+ *
+ * Every entry remembers the sorted move list of its position, so a later
+ * iteration, or a later search that reaches the same position, can skip the
+ * move generation and the ANN evaluation of every child.
+ *
+ * The table has a fixed number of slots, and a new position always replaces
+ * whatever was stored in its slot. Each search gets a new generation so it's
+ * possible to tell how much of the table the current search has written to.
+ *
+ * The move lists are written one after another into an arena allocated
+ * together with the slots, wrapping around when it's full. A slot whose list
+ * has been written over is treated as empty. Nothing is allocated after
+ * resize, so the requested size is a ceiling.
+ */
+class TranspositionTable {
+ public:
+  struct Entry {
+    uint64_t key;
+    uint64_t offset;          // moves written to the arena before this list
+    const ScoredMove* moves;  // the list in the arena
+    uint16_t nrOfMoves;
+    uint8_t generation;
+  };
+
+  static constexpr size_t DEFAULT_SIZE = 16; // MB
+
+  TranspositionTable(const size_t megabytes = DEFAULT_SIZE);
+  TranspositionTable(const TranspositionTable&) = delete;
+  void operator=(const TranspositionTable&) = delete;
+
+  /**
+   * Change the size of the table, this clears it.
+   * @param megabytes approximate memory use
+   */
+  void resize(const size_t megabytes);
+  void clear();
+
+  /**
+   * Start a new generation, call this once before each search.
+   */
+  void newSearch();
+
+  /**
+   * Find the entry of a position.
+   * @param key zobrist hash
+   * @return the entry, or nullptr if the position isn't stored
+   */
+  const Entry* probe(const uint64_t key);
+
+  /**
+   * Store the sorted move list of a position.
+   * @param key zobrist hash
+   * @param moves sorted moves
+   * @param len number of moves
+   */
+  void store(const uint64_t key, const ScoredMove* moves, const uint16_t len);
+
+  /**
+   * @return int permill of the entries written by the current search
+   */
+  int hashfull() const;
+
+  size_t size() const;
+  uint64_t getProbes() const;
+  uint64_t getHits() const;
+
+ private:
+  std::vector<Entry> entries;
+  size_t mask;
+  uint8_t generation;
+
+  // move lists of the entries, written moves is where the next one goes
+  std::vector<ScoredMove> arena;
+  uint64_t writtenMoves;
+
+  uint64_t probes;
+  uint64_t hits;
+};
+
+}
@@ -3,6 +3,8 @@
 #include "david/david.h"
 #include "david/types.h"
 #include <array>
+#include <string>
+#include <vector>
 #include "david/bitboard.h"
 
 namespace david {
@@ -11,27 +13,35 @@ namespace gameTree {
 /**
  * This class instance lives through the whole engine lifetime.
  *
- * Used to generate nodes from a gameState node.
+ * Holds the root node of the game, its children and the expected line of
+ * play. The search itself walks a SearchStack, so only the few levels that
+ * are kept between moves are stored here.
  *
- * Number of levels to be generated or nr of nodes can be specified.
- *
- * This class starts always on the leftmost node, generates children and then moves
- * to the neighbour node to his right. If there are no neighbour node at this level,
- * it's either skipped if the parent discovered chess mate or the generating is finished.
+ * Indexes are laid out as if every level had room for constant::MAXMOVES
+ * nodes, see getChildIndex, but each level only stores the nodes it has.
  */
 class TreeGen {
+ public:
+  // number of levels below the root: root children, the replies to the best move, and the replies to those
+  static constexpr unsigned int LEVELS = 3;
+
  private:
   const type::NeuralNetwork_t& neuralnet;
 
   // transposition table
   //std::array<NodeCache, constant::MAXMOVES>
 
-  // Game tree
-  std::array<type::gameState_t, (constant::MAXMOVES * constant::MAXDEPTH + /*root*/1)> tree;
+  // Game tree, level 0 only holds the root node
+  std::array<std::vector<type::gameState_t>, LEVELS + 1> tree;
   int maxDepth;
 
-  // Table to faster access child index of a parent node
-  std::array<int, (constant::MAXDEPTH + 1)> depthIndexes;
+  // game states are generated here before they are copied into a level
+  std::array<type::gameState_t, constant::MAXMOVES> children;
+
+  // Each level of the tree holds the children of one parent node. The parent index,
+  // and the position it had, is kept so generated children can be reused. -1 if unknown.
+  std::array<int, LEVELS + 1> levelParent;
+  std::array<type::gameState_t, LEVELS + 1> levelParentState;
 
   // keep track of game history
   std::string startposFEN;
@@ -42,6 +52,16 @@ class TreeGen {
   std::array<std::string, constant::MAXMOVES> EGNMoves; // calculate this after best move, dont waste time.
   int nrOfEGNMoves{-1}; // holds the number of moves generated after root to reduce loop check
 
+  // level 0 is the root node, level 1 its children, and so on
+  inline unsigned int level(const unsigned int index) const {
+    return index == 0 ? 0 : (index - 1) / constant::MAXMOVES + 1;
+  }
+
+  // position of the node within its level
+  inline unsigned int offset(const unsigned int index) const {
+    return index == 0 ? 0 : (index - 1) % constant::MAXMOVES;
+  }
+
  public:
 
   // Constructors
@@ -60,9 +80,12 @@ class TreeGen {
   void /************/ setMaxDepth(const int depth);
   void /************/ generateNode(const type::gameState_t& p, type::gameState_t& n, const type::gameState_t c);
   uint16_t /********/ generateChildren(const unsigned int index);
+  bool /************/ hasGeneratedChildren(const unsigned int index) const;
+  void /************/ generatePredictedLine(const unsigned int index);
   unsigned int /****/ treeIndex(const uint8_t depth, const uint8_t index) const;
   type::gameState_t   getGameStateCopy(const unsigned int index) const;
   type::gameState_t&  getGameState(const unsigned int index);
+  const type::NeuralNetwork_t& getNeuralNetwork() const;
 
   // generate EGN moves for root node
   void generateEGNMoves();
@@ -70,6 +93,9 @@ class TreeGen {
   // change root node based on EGN
   void applyEGNMove(const std::string& EGN);
 
+  // set the root node from a position and the moves played since
+  void setPosition(const std::string& FEN, const std::vector<std::string>& moves);
+
   // sync engine's board track with GUI
   //void syncGameRecord(); // should this take an array of strings, or just the uci param for moves?
 
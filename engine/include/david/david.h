@@ -76,14 +76,21 @@ static const type::bitboard_t EMPTY   = 0ULL;
 static const type::bitboard_t EMPTYBOARD = 0ULL;
 
 //! default values for board evaluations
+//! These are symmetric so negamax can negate a bound without overflowing.
 namespace boardScore {
 static const int HIGHEST  = std::numeric_limits<int>::max();
-static const int LOWEST   = std::numeric_limits<int>::min();
+static const int LOWEST   = -std::numeric_limits<int>::max();
+
+// a win proven by the endgame tablebases, far above any evaluation of the network
+static const int TABLEBASE_WIN = 20000;
 }
 
 static const int MAXMOVES = 256;
 static const int MAXDEPTH = 30;
 
+// default number of plies the search can go down, it can be changed with the MaxDepth uci option
+static const int MAXSEARCHDEPTH = 64;
+
 
 //! Neuralnet related constants.
 namespace nn {
@@ -30,7 +30,34 @@ auto uciok = [&]() {
  * Not required.
  */
 auto option = [&]() {
-  //::forwards::send("option name Hash type spin default 1 min 1 max 128");
+  uci::send("option name Hash type spin default 16 min 1 max 1024");
+  uci::send("option name NullMove type check default true");
+  uci::send("option name NullMoveReduction type spin default 2 min 1 max 4");
+  uci::send("option name NullMoveMinDepth type spin default 3 min 1 max 10");
+  uci::send("option name LMR type check default true");
+  uci::send("option name LMRMinDepth type spin default 3 min 1 max 10");
+  uci::send("option name LMRMinMoveIndex type spin default 4 min 1 max 64");
+  uci::send("option name LMRHistoryThreshold type spin default 0 min 0 max 100000");
+  uci::send("option name Quiescence type check default true");
+  uci::send("option name SEEPruning type check default true");
+  uci::send("option name SEEPruningDepth type spin default 2 min 1 max 10");
+  uci::send("option name SEEQuietMargin type spin default 60 min 0 max 1000");
+  uci::send("option name LazyEval type check default false");
+  uci::send("option name LazyEvalMargin type spin default 0 min 0 max 10000");
+  uci::send("option name MultiPV type spin default 1 min 1 max 256");
+  uci::send("option name AspirationWindow type spin default 25 min 0 max 1000");
+  uci::send("option name AspirationMinDepth type spin default 4 min 1 max 64");
+  uci::send("option name QuantizedNetwork type check default false");
+  uci::send("option name EvalCache type spin default 16 min 0 max 1024");
+  uci::send("option name MaxDepth type spin default 64 min 1 max 256");
+  uci::send("option name SyzygyPath type string default <empty>");
+  uci::send("option name SyzygyProbeLimit type spin default 7 min 0 max 7");
+  uci::send("option name OwnBook type check default false");
+  uci::send("option name BookFile type string default <empty>");
+  uci::send("option name BookBestMove type check default false");
+  uci::send("option name MoveOverhead type spin default 30 min 0 max 5000");
+  uci::send("option name Ponder type check default false");
+  uci::send("option name InfoInterval type spin default 1000 min 0 max 60000");
 };
 
 /**
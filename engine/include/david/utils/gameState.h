@@ -81,6 +81,34 @@ const std::string getEGN(const ::david::type::gameState_t &first, const ::david:
 void getEGN(const ::david::type::gameState_t &first, const ::david::type::gameState_t &second, std::string &EGN);
 void generateMergedBoardVersion(::david::type::gameState_t& gs);
 
+/**
+ * Create the game state that follows a null move (the active colour passes).
+ * Used by null move pruning, the pieces are left untouched.
+ *
+ * @param parent gameState_t& the node to pass from
+ * @param child gameState_t& the node where the opponent is to move
+ */
+void generateNullMove(const ::david::type::gameState_t& parent, ::david::type::gameState_t& child);
+
+/**
+ * Check if two game states describe the same position, ignoring the move
+ * counters and search data such as score, depth and number of children.
+ *
+ * @param a gameState_t&
+ * @param b gameState_t&
+ * @return true if the pieces, colour to move, castling and en passant rights are equal
+ */
+bool samePosition(const ::david::type::gameState_t& a, const ::david::type::gameState_t& b);
+
+/**
+ * Zobrist hash of a position. Positions that are samePosition get the same
+ * hash, the move counters and search data are not part of it.
+ *
+ * @param gs gameState_t&
+ * @return uint64_t hash
+ */
+uint64_t zobristHash(const ::david::type::gameState_t& gs);
+
 /**
  * Set default board values
  * @param node gameState_t&
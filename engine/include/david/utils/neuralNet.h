@@ -8,9 +8,33 @@ namespace utils {
 //! Utilities specific to the neural net.
 namespace neuralNet {
 
+/**
+ * Which feature goes in which input.
+ *
+ * The networks that ship, and the training data they were made from, use
+ * LAYOUT_TRAINED. There the attack counts of one colour overwrite the piece
+ * counts of both, and the inputs meant for the rest of the piece type
+ * features, the colour attacks and the mobility are always 0.
+ *
+ * LAYOUT_FULL has every feature in an input of its own, for networks
+ * trained from now on. It has the same number of inputs.
+ */
+enum InputLayout : int {
+  LAYOUT_TRAINED = 1,
+  LAYOUT_FULL = 2
+};
 
-std::array<float, ::david::constant::nn::INPUTSIZE> convertGameStateToInputs(::david::type::gameState_t &node);
+/**
+ * Write the network inputs of a position.
+ *
+ * @param gs position
+ * @param inputs ::david::constant::nn::INPUTSIZE floats
+ * @param layout which feature goes in which input
+ */
+void convertGameStateToInputs(const ::david::type::gameState_t& gs, float* inputs, const InputLayout layout = LAYOUT_TRAINED);
+
+std::array<float, ::david::constant::nn::INPUTSIZE> convertGameStateToInputs(const ::david::type::gameState_t &node);
 
 
 } // neuralNet
-} // utils
\ No newline at end of file
+} // utils
@@ -5,8 +5,9 @@
 #include "david/utils/gameState.h"
 
 // system dependencies
+#include <algorithm>
+#include <array>
 #include <sstream>
-#include <david/utils/neuralNet.h>
 
 namespace david {
 /**
@@ -15,7 +16,8 @@ namespace david {
  */
 ANN::ANN()
     : ANNFile(""),
-      ANNInstance(nullptr) {}
+      ANNInstance(nullptr),
+      inputLayout(::utils::neuralNet::LAYOUT_TRAINED) {}
 
 /**
  * Constructor
@@ -23,7 +25,8 @@ ANN::ANN()
  */
 ANN::ANN(const std::string filename)
     : ANNFile(utils::getAbsoluteProjectPath() + ::david::neuralNetworksFolder + filename),
-      ANNInstance(nullptr) {}
+      ANNInstance(nullptr),
+      inputLayout(::utils::neuralNet::LAYOUT_TRAINED) {}
 
 
 void ANN::guarenteeANNFile() const {
@@ -42,7 +45,7 @@ void ANN::guarenteeANNFile() const {
  * Destructor
  */
 ANN::~ANN() {
-  if (this->hasANNInstance()) {
+  if (this->ANNInstance != nullptr) {
     fann_destroy(this->ANNInstance);
   }
 }
@@ -100,7 +103,7 @@ bool ANN::hasANNFile() const {
  * Check if there exists a ANN instance
  */
 bool ANN::hasANNInstance() const {
-  return this->ANNInstance != nullptr;
+  return this->ANNInstance != nullptr || this->network.isLoaded();
 }
 
 /**
@@ -126,10 +129,40 @@ void ANN::createANNInstance() {
     return;
   }
 
+  this->cache.clear();
+
+  // the weights are run without FANN when the network is supported, and
+  // shared with every other engine in the process that loads the same file
+  if (this->network.load(this->getWeightFile())) {
+    this->inputLayout = static_cast<::utils::neuralNet::InputLayout>(this->network.inputLayout());
+    return;
+  }
+
   // create instance from file
+  this->inputLayout = ::utils::neuralNet::LAYOUT_TRAINED;
   this->ANNInstance = fann_create_from_file(this->ANNFile.c_str());
 }
 
+/**
+ * The file the network is loaded from, the binary network file when
+ * there is one.
+ * @return std::string absolute path
+ */
+std::string ANN::getWeightFile() const {
+  const auto binary = DenseNetwork::binaryPath(this->ANNFile);
+  return utils::fileExists(binary) ? binary : this->ANNFile;
+}
+
+/**
+ * Write the inputs of a board in the layout of the loaded network.
+ *
+ * @param board the position
+ * @param inputs ::david::constant::nn::INPUTSIZE floats
+ */
+void ANN::convert(const type::gameState_t& board, float* inputs) const {
+  ::utils::neuralNet::convertGameStateToInputs(board, inputs, this->inputLayout);
+}
+
 /**
  * Run the boards through the trained neural network to get a generated output.
  *
@@ -137,7 +170,20 @@ void ANN::createANNInstance() {
  * @return int board evaluation
  */
 int ANN::ANNEvaluate(type::gameState_t& board) const {
-  const auto arr = ::utils::neuralNet::convertGameStateToInputs(board); // float array of the inputs
+  const uint64_t key = this->cache.isEnabled() ? EvaluationCache::key(board) : 0;
+  int score;
+  if (this->cache.probe(key, score)) {
+    return score;
+  }
+
+  std::array<float, ::david::constant::nn::INPUTSIZE> arr; // float array of the inputs
+  this->convert(board, arr.data());
+
+  if (this->network.isLoaded()) {
+    score = static_cast<int>(this->network.run(arr.data()) * 1000);
+    this->cache.store(key, score);
+    return score;
+  }
 
   // populate array
   fann_type inputs[::david::constant::nn::INPUTSIZE];
@@ -146,9 +192,14 @@ int ANN::ANNEvaluate(type::gameState_t& board) const {
     inputs[i] = arr[i];
   }
 
-  fann_type* outputs = fann_run(this->ANNInstance, inputs); // float array
+  {
+    std::lock_guard<std::mutex> lock(this->fannMutex);
+    fann_type* outputs = fann_run(this->ANNInstance, inputs); // float array
 
-  return static_cast<int>(outputs[0] * 1000); // The expected output during training was multiplied by 0.001
+    score = static_cast<int>(outputs[0] * 1000); // The expected output during training was multiplied by 0.001
+  }
+  this->cache.store(key, score);
+  return score;
 }
 
 /**
@@ -164,4 +215,174 @@ int ANN::ANNEvaluate(const std::string& fen) const {
   return this->ANNEvaluate(gs);
 }
 
+/**
+ * Evaluate several boards at once, usually the children of a position.
+ * The network runs them as a batch, so the weights are read once for
+ * every DenseNetwork::BATCH boards instead of once per board.
+ *
+ * @param boards the game states
+ * @param n number of boards
+ * @param scores where the board evaluations are written, n of them
+ */
+void ANN::evaluateBatch(type::gameState_t* boards, const size_t n, int* scores) const {
+  if (!this->network.isLoaded()) {
+    for (size_t i = 0; i < n; i++) {
+      scores[i] = this->ANNEvaluate(boards[i]);
+    }
+    return;
+  }
+
+  constexpr auto len = ::david::constant::nn::INPUTSIZE;
+  std::array<float, DenseNetwork::BATCH * len> inputs;
+  std::array<float, DenseNetwork::BATCH> outputs;
+
+  // boards that weren't cached, waiting for the network
+  std::array<size_t, DenseNetwork::BATCH> pending;
+  std::array<uint64_t, DenseNetwork::BATCH> keys;
+  size_t count = 0;
+
+  const auto flush = [&]() {
+    this->network.run(inputs.data(), count, outputs.data());
+    for (size_t j = 0; j < count; j++) {
+      scores[pending[j]] = static_cast<int>(outputs[j] * 1000);
+      this->cache.store(keys[j], scores[pending[j]]);
+    }
+    count = 0;
+  };
+
+  for (size_t i = 0; i < n; i++) {
+    const uint64_t key = this->cache.isEnabled() ? EvaluationCache::key(boards[i]) : 0;
+    if (this->cache.probe(key, scores[i])) {
+      continue;
+    }
+
+    this->convert(boards[i], inputs.data() + count * len);
+    pending[count] = i;
+    keys[count++] = key;
+
+    if (count == DenseNetwork::BATCH) {
+      flush();
+    }
+  }
+
+  if (count > 0) {
+    flush();
+  }
+}
+
+/**
+ * Check if positions can be evaluated from the first layer of the position
+ * before them, which needs the float network of the in-house kernels.
+ */
+bool ANN::hasAccumulators() const {
+  return this->network.hasAccumulators();
+}
+
+/**
+ * Compute the first layer of a position from all of its inputs.
+ *
+ * @param board the position
+ * @param accumulator where the first layer is stored
+ */
+void ANN::refreshAccumulator(type::gameState_t& board, Accumulator& accumulator) const {
+  std::array<float, ::david::constant::nn::INPUTSIZE> arr;
+  this->convert(board, arr.data());
+  this->network.refresh(arr.data(), accumulator);
+}
+
+/**
+ * Compute the first layer of a position from the first layer of another
+ * position, usually the one before a move. Only the inputs that changed
+ * are added.
+ *
+ * @param from first layer of the other position
+ * @param board the position
+ * @param accumulator where the first layer is stored
+ */
+void ANN::updateAccumulator(const Accumulator& from, type::gameState_t& board, Accumulator& accumulator) const {
+  std::array<float, ::david::constant::nn::INPUTSIZE> arr;
+  this->convert(board, arr.data());
+  this->network.update(from, arr.data(), accumulator);
+}
+
+/**
+ * Run the rest of the network from the first layer of a position.
+ *
+ * @param accumulator filled by refreshAccumulator or updateAccumulator
+ * @return int board evaluation
+ */
+int ANN::ANNEvaluate(const Accumulator& accumulator) const {
+  return static_cast<int>(this->network.run(accumulator) * 1000);
+}
+
+/**
+ * Run the rest of the network for several positions as a batch.
+ *
+ * @param accumulators filled by refreshAccumulator or updateAccumulator
+ * @param n number of positions
+ * @param scores where the board evaluations are written, n of them
+ */
+void ANN::evaluateBatch(const Accumulator* accumulators, const size_t n, int* scores) const {
+  std::array<float, DenseNetwork::BATCH> outputs;
+
+  for (size_t start = 0; start < n; start += DenseNetwork::BATCH) {
+    const size_t count = std::min(DenseNetwork::BATCH, n - start);
+    this->network.run(accumulators + start, count, outputs.data());
+    for (size_t i = 0; i < count; i++) {
+      scores[start + i] = static_cast<int>(outputs[i] * 1000);
+    }
+  }
+}
+
+/**
+ * Name of the inference kernels, "avx2" or "scalar" with " int8" added
+ * when quantized, or "fann" when the network file could only be loaded by FANN.
+ */
+std::string ANN::getKernel() const {
+  return this->network.isLoaded() ? this->network.kernel() : "fann";
+}
+
+/**
+ * Switch between float and integer inference. The integer weights are
+ * converted from the float ones, switching back loads the file again.
+ * Must not be called while a search is running.
+ *
+ * @param quantized bool
+ * @return false if the network isn't run by the in-house kernels
+ */
+bool ANN::setQuantized(const bool quantized) {
+  if (!this->network.isLoaded()) {
+    return false;
+  }
+
+  if (quantized == this->network.isQuantized()) {
+    return true;
+  }
+
+  // the cached scores came from the other network
+  this->cache.clear();
+
+  return quantized ? this->network.quantize() : this->network.load(this->getWeightFile());
+}
+
+/**
+ * Scores of positions that were already evaluated. ANNEvaluate and
+ * evaluateBatch check it before a board is converted to inputs, the
+ * accumulator methods leave it to the caller since they don't see the board.
+ * The cache is safe to use from several search threads at once.
+ */
+EvaluationCache& ANN::getEvaluationCache() const {
+  return this->cache;
+}
+
+/**
+ * Change the size of the evaluation cache, this clears it.
+ * Must not be called while a search is running.
+ *
+ * @param megabytes approximate memory use, 0 turns the cache off
+ */
+void ANN::setEvaluationCacheSize(const size_t megabytes) {
+  this->cache.resize(megabytes);
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,1519 @@
+#include "david/ANN/DenseNetwork.h"
+#include "david/utils/neuralNet.h"
+
+// system dependencies
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+// memory mapped network files
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define DAVID_DENSE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace david {
+
+namespace {
+
+// exp(x) = 2^n * e^r, where |r| <= ln(2)/2 and e^r comes from a polynomial
+constexpr float EXP_LIMIT = 88.0f;
+constexpr float LOG2E = 1.44269504088896341f;
+constexpr float LN2_HIGH = 0.693359375f;
+constexpr float LN2_LOW = -2.12194440e-4f;
+constexpr float EXP_P0 = 1.9875691500e-4f;
+constexpr float EXP_P1 = 1.3981999507e-3f;
+constexpr float EXP_P2 = 8.3334519073e-3f;
+constexpr float EXP_P3 = 4.1665795894e-2f;
+constexpr float EXP_P4 = 1.6666665459e-1f;
+constexpr float EXP_P5 = 5.0000001201e-1f;
+
+size_t roundUp(const size_t n, const size_t multiple) {
+  return (n + multiple - 1) / multiple * multiple;
+}
+
+float expApprox(float x) {
+  x = std::min(std::max(x, -EXP_LIMIT), EXP_LIMIT);
+
+  const float n = std::floor(x * LOG2E + 0.5f);
+  x -= n * LN2_HIGH;
+  x -= n * LN2_LOW;
+
+  float y = EXP_P0;
+  y = y * x + EXP_P1;
+  y = y * x + EXP_P2;
+  y = y * x + EXP_P3;
+  y = y * x + EXP_P4;
+  y = y * x + EXP_P5;
+  y = y * x * x + x + 1.0f;
+
+  const int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+  float pow2n;
+  std::memcpy(&pow2n, &bits, sizeof(pow2n));
+
+  return y * pow2n;
+}
+
+float activate(const int activation, const float x) {
+  switch (activation) {
+    case DenseNetwork::SIGMOID:
+      return 1.0f / (1.0f + expApprox(-2.0f * x));
+    case DenseNetwork::SIGMOID_SYMMETRIC:
+      return 2.0f / (1.0f + expApprox(-2.0f * x)) - 1.0f;
+    default:
+      return x;
+  }
+}
+
+/**
+ * Read the tuples after the '=' of a line like "neurons (a, b, c)=(1, 2, 3) (4, 5, 6) ",
+ * every value is parsed as a double.
+ */
+bool parseTuples(const std::string& line, const size_t width, std::vector<double>& values) {
+  const auto start = line.find(")=");
+  if (start == std::string::npos) {
+    return false;
+  }
+
+  const char* cursor = line.c_str() + start + 2;
+  while (true) {
+    cursor = std::strchr(cursor, '(');
+    if (cursor == nullptr) {
+      break;
+    }
+    cursor++;
+
+    for (size_t i = 0; i < width; i++) {
+      char* end = nullptr;
+      values.push_back(std::strtod(cursor, &end));
+      if (end == cursor) {
+        return false;
+      }
+      cursor = end;
+      while (*cursor == ',' || *cursor == ' ') {
+        cursor++;
+      }
+    }
+  }
+
+  return true;
+}
+
+//
+// Binary network files, see DenseNetwork::save. Both structs are written
+// as they are in memory, the static asserts keep them free of padding.
+//
+constexpr char MAGIC[8] = {'D', 'A', 'V', 'I', 'D', 'N', 'E', 'T'};
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t SECTION_ALIGNMENT = 64;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byteOrder;
+  uint32_t inputLayout;
+  uint32_t nrOfLayers;
+  uint64_t columnsOffset;
+  uint64_t columnStride;
+  uint64_t fileSize;
+};
+static_assert(sizeof(FileHeader) == 48, "FileHeader has padding");
+
+struct FileLayer {
+  uint32_t inputs;
+  uint32_t outputs;
+  uint32_t stride;
+  uint32_t activation;
+  float steepness;
+  uint32_t reserved;
+  uint64_t weightsOffset;
+  uint64_t biasesOffset;
+};
+static_assert(sizeof(FileLayer) == 40, "FileLayer has padding");
+
+// an array in a mapped file must be inside it and aligned for the AVX loads
+bool inFile(const uint64_t offset, const uint64_t bytes, const size_t size) {
+  return offset % 32 == 0 && offset <= size && bytes <= size - offset;
+}
+
+bool cpuHasAVX2() {
+#ifdef DAVID_DENSE_AVX2
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+  return false;
+#endif
+}
+
+} // anonymous namespace
+
+/**
+ * Constructor
+ */
+DenseNetwork::DenseNetwork()
+    : runLayer(&DenseNetwork::runLayerScalar)
+    , runBatchLayer(&DenseNetwork::runBatchLayerScalar)
+    , runFirstLayer(&DenseNetwork::runFirstLayerScalar)
+    , runHiddenLayer(&DenseNetwork::runHiddenLayerScalar)
+    , activateLayer(&DenseNetwork::activateLayerScalar)
+    , dequantize(&DenseNetwork::dequantizeScalar)
+    , quantizeActivations(&DenseNetwork::quantizeScalar)
+    , addColumn(&DenseNetwork::addColumnScalar)
+    , vectorized(false)
+    , columns(nullptr)
+    , columnStride(0)
+    , widest(0)
+    , wideInputSize(0)
+    , activationSize(0)
+{}
+
+/**
+ * The weights of a network file. They're never changed once loaded, so any
+ * number of networks can run on them.
+ */
+struct DenseNetwork::SharedWeights {
+  std::vector<Layer> layers;
+  const float* columns = nullptr;
+  size_t columnStride = 0;
+  int inputLayout = 0;
+
+  // what the weights point into, the buffers of a parsed file or a mapped file
+  std::vector<AlignedBuffer<float>> buffers;
+  void* address = nullptr;
+  size_t size = 0;
+
+  SharedWeights() = default;
+  SharedWeights(const SharedWeights&) = delete;
+  void operator=(const SharedWeights&) = delete;
+
+  ~SharedWeights() {
+    if (this->address != nullptr) {
+      munmap(this->address, this->size);
+    }
+  }
+
+  // owned buffer of zeroed floats
+  float* allocate(const size_t size) {
+    this->buffers.emplace_back(size);
+    return this->buffers.back().data();
+  }
+};
+
+/**
+ * Load the weights of a binary network file, or of a FANN float network
+ * file. Only layered, fully connected networks without input scaling,
+ * where every neuron of a layer has the same activation function, can be
+ * loaded. A file that's already loaded by another network is shared.
+ * @param path .dnet or .net file
+ * @param vectorize use the AVX2 kernels if the CPU supports them
+ * @return false if the file can't be read or has a network that isn't supported
+ */
+bool DenseNetwork::load(const std::string& path, const bool vectorize) {
+  this->shared.reset();
+  this->layers.clear();
+  this->quantizedLayers.clear();
+  this->columns = nullptr;
+  this->columnStride = 0;
+
+  auto weights = DenseNetwork::share(path);
+  if (weights == nullptr) {
+    return false;
+  }
+
+  this->shared = weights;
+  this->layers = weights->layers;
+  this->columns = weights->columns;
+  this->columnStride = weights->columnStride;
+
+  // room for the bias neuron of every layer, like a FANN layer
+  this->widest = 0;
+  for (const auto& layer : this->layers) {
+    this->widest = std::max({this->widest, roundUp(layer.inputs + 1, 32), roundUp(layer.outputs + 1, 32)});
+  }
+  this->selectKernels(vectorize);
+
+  return true;
+}
+
+/**
+ * The weights of a file, from the networks that already loaded it when
+ * there are any. A file is recognised by its inode, size and modification
+ * time, so a file that was replaced is loaded again.
+ * @param path .dnet or .net file
+ * @return nullptr if the file can't be read or has a network that isn't supported
+ */
+std::shared_ptr<const DenseNetwork::SharedWeights> DenseNetwork::share(const std::string& path) {
+  static std::mutex mutex;
+  static std::map<std::string, std::weak_ptr<const SharedWeights>> loaded;
+
+  struct stat statbuf;
+  if (stat(path.c_str(), &statbuf) != 0) {
+    return nullptr;
+  }
+
+  std::ostringstream key;
+  key << statbuf.st_dev << ':' << statbuf.st_ino << ':' << statbuf.st_size << ':'
+      << statbuf.st_mtim.tv_sec << '.' << statbuf.st_mtim.tv_nsec;
+
+  // networks loading the same file at once wait for the first one
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = loaded.begin(); it != loaded.end();) {
+    it = it->second.expired() ? loaded.erase(it) : std::next(it);
+  }
+
+  const auto found = loaded.find(key.str());
+  if (found != loaded.end()) {
+    return found->second.lock();
+  }
+
+  std::ifstream file(path, std::ios::binary);
+  std::array<char, sizeof(MAGIC)> magic{};
+  file.read(magic.data(), magic.size());
+  const bool binary = file.gcount() == static_cast<std::streamsize>(magic.size())
+                      && std::equal(magic.begin(), magic.end(), MAGIC);
+  file.close();
+
+  const auto weights = binary ? DenseNetwork::map(path) : DenseNetwork::parse(path);
+  if (weights != nullptr) {
+    loaded[key.str()] = weights;
+  }
+
+  return weights;
+}
+
+/**
+ * Read the weights of a FANN float network file.
+ * @param path .net file
+ * @return nullptr if the file can't be read or has a network that isn't supported
+ */
+std::shared_ptr<const DenseNetwork::SharedWeights> DenseNetwork::parse(const std::string& path) {
+  std::ifstream file(path);
+  std::string line;
+  if (!file || !std::getline(file, line) || line.compare(0, 8, "FANN_FLO") != 0) {
+    return nullptr;
+  }
+
+  std::vector<size_t> sizes; // with the bias neurons
+  std::vector<double> neurons;
+  std::vector<double> connections;
+  while (std::getline(file, line)) {
+    if (line.compare(0, 13, "network_type=") == 0 && line != "network_type=0") {
+      return nullptr; // shortcut connections
+    }
+    else if (line.compare(0, 16, "connection_rate=") == 0 && std::stod(line.substr(16)) != 1.0) {
+      return nullptr; // sparse
+    }
+    else if (line.compare(0, 15, "scale_included=") == 0 && line != "scale_included=0") {
+      return nullptr;
+    }
+    else if (line.compare(0, 12, "layer_sizes=") == 0) {
+      std::istringstream values(line.substr(12));
+      size_t size;
+      while (values >> size) {
+        sizes.push_back(size);
+      }
+    }
+    else if (line.compare(0, 8, "neurons ") == 0) {
+      if (!parseTuples(line, 3, neurons)) {
+        return nullptr;
+      }
+    }
+    else if (line.compare(0, 12, "connections ") == 0) {
+      if (!parseTuples(line, 2, connections)) {
+        return nullptr;
+      }
+    }
+  }
+
+  if (sizes.size() < 2) {
+    return nullptr;
+  }
+
+  size_t totalNeurons = 0;
+  for (const auto size : sizes) {
+    if (size < 2) {
+      return nullptr;
+    }
+    totalNeurons += size;
+  }
+  if (neurons.size() != totalNeurons * 3) {
+    return nullptr;
+  }
+
+  auto loaded = std::make_shared<SharedWeights>();
+  size_t previousFirst = 0; // global index of the first neuron in the previous layer
+  size_t neuron = sizes[0];
+  size_t connection = 0;
+  for (size_t l = 1; l < sizes.size(); l++) {
+    Layer layer;
+    layer.inputs = sizes[l - 1] - 1;
+    layer.outputs = sizes[l] - 1;
+    layer.stride = roundUp(layer.inputs, LANES);
+    layer.activation = static_cast<int>(neurons[neuron * 3 + 1]);
+    layer.steepness = static_cast<float>(neurons[neuron * 3 + 2]);
+    float* weights = loaded->allocate(layer.outputs * layer.stride);
+    float* biases = loaded->allocate(roundUp(layer.outputs, LANES));
+    layer.weights = weights;
+    layer.biases = biases;
+
+    if (layer.activation != LINEAR && layer.activation != SIGMOID && layer.activation != SIGMOID_SYMMETRIC) {
+      return nullptr;
+    }
+
+    for (size_t row = 0; row < sizes[l]; row++, neuron++) {
+      const auto nrOfInputs = static_cast<size_t>(neurons[neuron * 3]);
+
+      // the bias neuron of the layer
+      if (row == layer.outputs) {
+        if (nrOfInputs != 0) {
+          return nullptr;
+        }
+        continue;
+      }
+
+      if (nrOfInputs != sizes[l - 1]
+          || static_cast<int>(neurons[neuron * 3 + 1]) != layer.activation
+          || static_cast<float>(neurons[neuron * 3 + 2]) != layer.steepness
+          || connections.size() < (connection + nrOfInputs) * 2) {
+        return nullptr;
+      }
+
+      for (size_t i = 0; i < nrOfInputs; i++, connection++) {
+        const auto from = static_cast<size_t>(connections[connection * 2]);
+        const auto weight = static_cast<float>(connections[connection * 2 + 1]);
+        if (from < previousFirst || from >= previousFirst + sizes[l - 1]) {
+          return nullptr;
+        }
+
+        const size_t column = from - previousFirst;
+        if (column == layer.inputs) {
+          biases[row] = weight;
+        }
+        else {
+          weights[row * layer.stride + column] = weight;
+        }
+      }
+    }
+
+    previousFirst += sizes[l - 1];
+    loaded->layers.push_back(layer);
+  }
+
+  if (connection * 2 != connections.size()) {
+    return nullptr;
+  }
+
+  const auto& first = loaded->layers.front();
+  loaded->columnStride = roundUp(first.outputs, LANES);
+  float* columns = loaded->allocate(first.inputs * loaded->columnStride);
+  for (size_t r = 0; r < first.outputs; r++) {
+    for (size_t i = 0; i < first.inputs; i++) {
+      columns[i * loaded->columnStride + r] = first.weights[r * first.stride + i];
+    }
+  }
+  loaded->columns = columns;
+
+  // the training tool writes the FANN files
+  loaded->inputLayout = ::utils::neuralNet::LAYOUT_TRAINED;
+
+  return loaded;
+}
+
+/**
+ * Map the weights of a binary network file, see save. Every offset and size
+ * is checked against the file before the weights are used.
+ * @param path .dnet file
+ * @return nullptr if the file can't be mapped or is broken
+ */
+std::shared_ptr<const DenseNetwork::SharedWeights> DenseNetwork::map(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return nullptr;
+  }
+
+  struct stat statbuf;
+  if (fstat(fd, &statbuf) != 0 || static_cast<size_t>(statbuf.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    return nullptr;
+  }
+
+  const auto size = static_cast<size_t>(statbuf.st_size);
+  void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (address == MAP_FAILED) {
+    return nullptr;
+  }
+
+  // unmapped again if anything is wrong
+  auto mapped = std::make_shared<SharedWeights>();
+  mapped->address = address;
+  mapped->size = size;
+  const auto data = static_cast<const uint8_t*>(address);
+
+  FileHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (!std::equal(MAGIC, MAGIC + sizeof(MAGIC), header.magic)
+      || header.version != FORMAT_VERSION
+      || header.byteOrder != BYTE_ORDER_MARK
+      || header.fileSize != size
+      || (header.inputLayout != ::utils::neuralNet::LAYOUT_TRAINED && header.inputLayout != ::utils::neuralNet::LAYOUT_FULL)
+      || header.nrOfLayers == 0
+      || header.nrOfLayers > (size - sizeof(FileHeader)) / sizeof(FileLayer)) {
+    return nullptr;
+  }
+
+  for (uint32_t l = 0; l < header.nrOfLayers; l++) {
+    FileLayer record;
+    std::memcpy(&record, data + sizeof(FileHeader) + l * sizeof(FileLayer), sizeof(record));
+
+    Layer layer;
+    layer.inputs = record.inputs;
+    layer.outputs = record.outputs;
+    layer.stride = record.stride;
+    layer.activation = static_cast<int>(record.activation);
+    layer.steepness = record.steepness;
+
+    if (layer.inputs == 0 || layer.outputs == 0
+        || layer.stride != roundUp(layer.inputs, LANES)
+        || (l > 0 && layer.inputs != mapped->layers.back().outputs)
+        || (layer.activation != LINEAR && layer.activation != SIGMOID && layer.activation != SIGMOID_SYMMETRIC)
+        || !inFile(record.weightsOffset, layer.outputs * layer.stride * sizeof(float), size)
+        || !inFile(record.biasesOffset, roundUp(layer.outputs, LANES) * sizeof(float), size)) {
+      return nullptr;
+    }
+
+    layer.weights = reinterpret_cast<const float*>(data + record.weightsOffset);
+    layer.biases = reinterpret_cast<const float*>(data + record.biasesOffset);
+    mapped->layers.push_back(layer);
+  }
+
+  const auto& first = mapped->layers.front();
+  if (header.columnStride != roundUp(first.outputs, LANES)
+      || !inFile(header.columnsOffset, first.inputs * header.columnStride * sizeof(float), size)) {
+    return nullptr;
+  }
+  mapped->columns = reinterpret_cast<const float*>(data + header.columnsOffset);
+  mapped->columnStride = header.columnStride;
+  mapped->inputLayout = static_cast<int>(header.inputLayout);
+
+  return mapped;
+}
+
+/**
+ * Write the float weights as a binary network file, so they can be
+ * memory mapped by load. The file is in the byte order of the machine.
+ *
+ * A header and one record per layer come first, then the weights and the
+ * biases of every layer and the first layer weights by input. Every array
+ * starts on a 64 byte boundary and is padded like in memory, so the mapped
+ * file can be used as is.
+ *
+ * The file is written next to the path and renamed, networks that have the
+ * old file mapped keep it.
+ *
+ * @param path file to write, usually ending with BINARY_EXTENSION
+ * @param inputLayout how positions are converted to inputs, see utils::neuralNet::InputLayout
+ * @return false if nothing is loaded, the network is quantized or the file can't be written
+ */
+bool DenseNetwork::save(const std::string& path, const int inputLayout) const {
+  if (!this->isLoaded() || this->isQuantized()) {
+    return false;
+  }
+
+  FileHeader header{};
+  std::copy(MAGIC, MAGIC + sizeof(MAGIC), header.magic);
+  header.version = FORMAT_VERSION;
+  header.byteOrder = BYTE_ORDER_MARK;
+  header.inputLayout = static_cast<uint32_t>(inputLayout);
+  header.nrOfLayers = static_cast<uint32_t>(this->layers.size());
+
+  // where every array goes
+  std::vector<FileLayer> records(this->layers.size());
+  uint64_t offset = roundUp(sizeof(FileHeader) + records.size() * sizeof(FileLayer), SECTION_ALIGNMENT);
+  for (size_t l = 0; l < this->layers.size(); l++) {
+    const auto& layer = this->layers[l];
+    auto& record = records[l];
+    record.inputs = static_cast<uint32_t>(layer.inputs);
+    record.outputs = static_cast<uint32_t>(layer.outputs);
+    record.stride = static_cast<uint32_t>(layer.stride);
+    record.activation = static_cast<uint32_t>(layer.activation);
+    record.steepness = layer.steepness;
+    record.weightsOffset = offset;
+    offset += roundUp(layer.outputs * layer.stride * sizeof(float), SECTION_ALIGNMENT);
+    record.biasesOffset = offset;
+    offset += roundUp(roundUp(layer.outputs, LANES) * sizeof(float), SECTION_ALIGNMENT);
+  }
+
+  const auto& first = this->layers.front();
+  header.columnsOffset = offset;
+  header.columnStride = this->columnStride;
+  offset += roundUp(first.inputs * this->columnStride * sizeof(float), SECTION_ALIGNMENT);
+  header.fileSize = offset;
+
+  const std::string temporary = path + ".tmp";
+  std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+  const auto write = [&out](const uint64_t at, const void* bytes, const size_t n) {
+    const std::vector<char> padding(at - static_cast<uint64_t>(out.tellp()), 0);
+    out.write(padding.data(), padding.size());
+    out.write(static_cast<const char*>(bytes), n);
+  };
+
+  write(0, &header, sizeof(header));
+  write(sizeof(header), records.data(), records.size() * sizeof(FileLayer));
+  for (size_t l = 0; l < this->layers.size(); l++) {
+    const auto& layer = this->layers[l];
+    write(records[l].weightsOffset, layer.weights, layer.outputs * layer.stride * sizeof(float));
+    write(records[l].biasesOffset, layer.biases, roundUp(layer.outputs, LANES) * sizeof(float));
+  }
+  write(header.columnsOffset, this->columns, first.inputs * this->columnStride * sizeof(float));
+  write(header.fileSize, nullptr, 0);
+
+  out.close();
+  if (!out || std::rename(temporary.c_str(), path.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @param path of a FANN .net file
+ * @return std::string the same path, ending with BINARY_EXTENSION instead
+ */
+std::string DenseNetwork::binaryPath(const std::string& path) {
+  const std::string extension = ".net";
+  if (path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0) {
+    return path.substr(0, path.size() - extension.size()) + BINARY_EXTENSION;
+  }
+
+  return path + BINARY_EXTENSION;
+}
+
+/**
+ * How positions are converted to inputs, see utils::neuralNet::InputLayout.
+ * FANN files are always in the layout the networks were trained on.
+ * @return int the layout, 0 if nothing is loaded
+ */
+int DenseNetwork::inputLayout() const {
+  return this->shared != nullptr ? this->shared->inputLayout : 0;
+}
+
+/**
+ * @return true if the weights are mapped from a binary network file
+ */
+bool DenseNetwork::isMapped() const {
+  return this->shared != nullptr && this->shared->address != nullptr;
+}
+
+/**
+ * @param other network
+ * @return true if both networks run on the same weights in memory
+ */
+bool DenseNetwork::sharesWeightsWith(const DenseNetwork& other) const {
+  return this->shared != nullptr && this->shared == other.shared;
+}
+
+void DenseNetwork::selectKernels(const bool vectorize) {
+  this->vectorized = vectorize && cpuHasAVX2();
+
+  if (this->vectorized) {
+    this->runLayer = &DenseNetwork::runLayerAVX2;
+    this->runBatchLayer = &DenseNetwork::runBatchLayerAVX2;
+    this->runFirstLayer = &DenseNetwork::runFirstLayerAVX2;
+    this->runHiddenLayer = &DenseNetwork::runHiddenLayerAVX2;
+    this->activateLayer = &DenseNetwork::activateLayerAVX2;
+    this->dequantize = &DenseNetwork::dequantizeAVX2;
+    this->quantizeActivations = &DenseNetwork::quantizeAVX2;
+    this->addColumn = &DenseNetwork::addColumnAVX2;
+  }
+  else {
+    this->runLayer = &DenseNetwork::runLayerScalar;
+    this->runBatchLayer = &DenseNetwork::runBatchLayerScalar;
+    this->runFirstLayer = &DenseNetwork::runFirstLayerScalar;
+    this->runHiddenLayer = &DenseNetwork::runHiddenLayerScalar;
+    this->activateLayer = &DenseNetwork::activateLayerScalar;
+    this->dequantize = &DenseNetwork::dequantizeScalar;
+    this->quantizeActivations = &DenseNetwork::quantizeScalar;
+    this->addColumn = &DenseNetwork::addColumnScalar;
+  }
+}
+
+/**
+ * Convert the weights to integers, the first layer to int16 and the
+ * others to int8, with one scale per layer. The float weights aren't used
+ * any more, but stay in memory while other networks share them. Load the
+ * file again to go back to float inference.
+ * @return false if nothing is loaded
+ */
+bool DenseNetwork::quantize() {
+  if (!this->isLoaded()) {
+    return false;
+  }
+  if (this->isQuantized()) {
+    return true;
+  }
+
+  size_t widestStride = 0;
+  for (size_t l = 0; l < this->layers.size(); l++) {
+    auto& layer = this->layers[l];
+    const float* weights = layer.weights;
+
+    float largest = 0.0f;
+    float largestRow = 0.0f;
+    for (size_t r = 0; r < layer.outputs; r++) {
+      float row = 0.0f;
+      for (size_t i = 0; i < layer.inputs; i++) {
+        largest = std::max(largest, std::fabs(weights[r * layer.stride + i]));
+        row += std::fabs(weights[r * layer.stride + i]);
+      }
+      largestRow = std::max(largestRow, row);
+    }
+
+    QuantizedLayer quantized;
+    float scale;
+    if (l == 0) {
+      // the int16 inputs go up to 32767, so the weights of a row may add up
+      // to 2^16 before an int32 sum can overflow, rounding included
+      quantized.stride = roundUp(layer.inputs, 16);
+      scale = largest > 0.0f ? 32767.0f / largest : 1.0f;
+      if (largestRow > 0.0f) {
+        scale = std::min(scale, static_cast<float>(65535 - quantized.stride) / largestRow);
+      }
+
+      quantized.wideWeights = AlignedBuffer<int16_t>(layer.outputs * quantized.stride);
+      for (size_t r = 0; r < layer.outputs; r++) {
+        for (size_t i = 0; i < layer.inputs; i++) {
+          quantized.wideWeights.data()[r * quantized.stride + i] =
+              static_cast<int16_t>(std::lrint(weights[r * layer.stride + i] * scale));
+        }
+      }
+      quantized.offsets.resize(layer.outputs, 0);
+      quantized.scale = 1.0f / scale;
+    }
+    else {
+      // vpmaddubsw adds two products of at most 127 * 2 * ACTIVATION_ONE, which fits an int16
+      quantized.stride = roundUp(layer.inputs, 32);
+      scale = largest > 0.0f ? 127.0f / largest : 1.0f;
+
+      quantized.weights = AlignedBuffer<int8_t>(layer.outputs * quantized.stride);
+      quantized.offsets.resize(layer.outputs);
+      for (size_t r = 0; r < layer.outputs; r++) {
+        int32_t sum = 0;
+        for (size_t i = 0; i < layer.inputs; i++) {
+          const auto weight = static_cast<int8_t>(std::lrint(weights[r * layer.stride + i] * scale));
+          quantized.weights.data()[r * quantized.stride + i] = weight;
+          sum += weight;
+        }
+        quantized.offsets[r] = sum * ACTIVATION_ONE;
+      }
+      quantized.scale = 1.0f / (scale * ACTIVATION_ONE);
+    }
+
+    widestStride = std::max(widestStride, quantized.stride);
+    layer.weights = nullptr;
+    this->columns = nullptr;
+    this->quantizedLayers.push_back(std::move(quantized));
+  }
+
+  this->wideInputSize = this->quantizedLayers.front().stride;
+  this->activationSize = widestStride;
+
+  return true;
+}
+
+bool DenseNetwork::isQuantized() const {
+  return !this->quantizedLayers.empty();
+}
+
+/**
+ * The scratch buffers of the calling thread, grown when this network needs
+ * more room than the networks the thread ran before it.
+ * @return Scratch& buffers only this thread uses
+ */
+DenseNetwork::Scratch& DenseNetwork::scratch() const {
+  thread_local Scratch buffers;
+
+  if (buffers.widest < this->widest) {
+    buffers.input = AlignedBuffer<float>(this->widest);
+    buffers.output = AlignedBuffer<float>(this->widest);
+    buffers.batchInput = AlignedBuffer<float>(BATCH * this->widest);
+    buffers.batchOutput = AlignedBuffer<float>(BATCH * this->widest);
+    buffers.sums = AlignedBuffer<int32_t>(this->widest);
+    buffers.widest = this->widest;
+  }
+  if (buffers.wideInputSize < this->wideInputSize) {
+    buffers.wideInput = AlignedBuffer<int16_t>(this->wideInputSize);
+    buffers.wideInputSize = this->wideInputSize;
+  }
+  if (buffers.activationSize < this->activationSize) {
+    buffers.activations = AlignedBuffer<uint8_t>(this->activationSize);
+    buffers.activationSize = this->activationSize;
+  }
+
+  return buffers;
+}
+
+/**
+ * @return size_t bytes taken by the weights and biases
+ */
+size_t DenseNetwork::weightBytes() const {
+  size_t bytes = 0;
+  for (size_t l = 0; l < this->layers.size(); l++) {
+    const auto& layer = this->layers[l];
+    bytes += roundUp(layer.outputs, LANES) * sizeof(float);
+
+    if (!this->isQuantized()) {
+      bytes += layer.outputs * layer.stride * sizeof(float);
+      if (l == 0) {
+        bytes += layer.inputs * this->columnStride * sizeof(float);
+      }
+    }
+    else if (l == 0) {
+      bytes += layer.outputs * this->quantizedLayers[l].stride * sizeof(int16_t);
+    }
+    else {
+      bytes += layer.outputs * (this->quantizedLayers[l].stride * sizeof(int8_t) + sizeof(int32_t));
+    }
+  }
+
+  return bytes;
+}
+
+bool DenseNetwork::isLoaded() const {
+  return !this->layers.empty();
+}
+
+/**
+ * Neurons per layer, inputs first, not counting the bias neurons.
+ * @return std::vector<int> empty if nothing is loaded
+ */
+std::vector<int> DenseNetwork::topology() const {
+  std::vector<int> sizes;
+  if (this->layers.empty()) {
+    return sizes;
+  }
+
+  sizes.push_back(static_cast<int>(this->layers.front().inputs));
+  for (const auto& layer : this->layers) {
+    sizes.push_back(static_cast<int>(layer.outputs));
+  }
+
+  return sizes;
+}
+
+/**
+ * Run the network.
+ * @param inputs as many as the first layer has neurons
+ * @return float the first output neuron
+ */
+float DenseNetwork::run(const float* inputs) const {
+  if (this->isQuantized()) {
+    return this->runQuantized(this->scratch(), inputs);
+  }
+
+  auto& buffers = this->scratch();
+  const auto& first = this->layers.front();
+  float* in = buffers.input.data();
+  float* out = buffers.output.data();
+
+  // the padding of the input rows must be zero, the weights there are
+  std::copy(inputs, inputs + first.inputs, in);
+  std::fill(in + first.inputs, in + first.stride, 0.0f);
+
+  for (const auto& layer : this->layers) {
+    this->runLayer(layer, in, out);
+    std::swap(in, out);
+  }
+
+  return in[0];
+}
+
+/**
+ * Run the network for several positions at once.
+ * @param inputs n rows of as many inputs as the first layer has neurons
+ * @param n number of positions
+ * @param outputs the first output neuron of every position
+ */
+void DenseNetwork::run(const float* inputs, const size_t n, float* outputs) const {
+  const auto& first = this->layers.front();
+
+  auto& buffers = this->scratch();
+  if (this->isQuantized()) {
+    for (size_t b = 0; b < n; b++) {
+      outputs[b] = this->runQuantized(buffers, inputs + b * first.inputs);
+    }
+    return;
+  }
+
+  for (size_t start = 0; start < n; start += BATCH) {
+    const size_t count = std::min(BATCH, n - start);
+
+    float* values = buffers.batchInput.data();
+    for (size_t b = 0; b < count; b++) {
+      const float* row = inputs + (start + b) * first.inputs;
+      float* in = values + b * this->widest;
+      std::copy(row, row + first.inputs, in);
+      std::fill(in + first.inputs, in + first.stride, 0.0f);
+    }
+
+    this->runBatch(buffers, values, 0, count, outputs + start);
+  }
+}
+
+/**
+ * Accumulators need the float weights, they can't be used once quantized.
+ * @return true if the accumulator methods can be used
+ */
+bool DenseNetwork::hasAccumulators() const {
+  return this->isLoaded() && !this->isQuantized();
+}
+
+/**
+ * Compute the first layer of a position from all of its inputs.
+ * @param inputs as many as the first layer has neurons
+ * @param accumulator where the inputs and sums are stored
+ */
+void DenseNetwork::refresh(const float* inputs, Accumulator& accumulator) const {
+  const auto& first = this->layers.front();
+  accumulator.inputs.assign(inputs, inputs + first.inputs);
+  accumulator.sums.assign(this->columnStride, 0.0f);
+
+  for (size_t i = 0; i < first.inputs; i++) {
+    if (inputs[i] != 0.0f) {
+      this->addColumn(inputs[i], this->columns + i * this->columnStride, this->columnStride, accumulator.sums.data());
+    }
+  }
+}
+
+/**
+ * Compute the first layer of a position from the accumulator of another
+ * position, usually the one before a move, by only adding the weights of
+ * the inputs that differ.
+ * @param from accumulator of the other position
+ * @param inputs as many as the first layer has neurons
+ * @param accumulator where the inputs and sums are stored, may not be from
+ * @return size_t number of inputs that changed
+ */
+size_t DenseNetwork::update(const Accumulator& from, const float* inputs, Accumulator& accumulator) const {
+  const auto& first = this->layers.front();
+  accumulator.inputs.assign(inputs, inputs + first.inputs);
+  accumulator.sums = from.sums;
+
+  size_t changed = 0;
+  for (size_t i = 0; i < first.inputs; i++) {
+    const float difference = inputs[i] - from.inputs[i];
+    if (difference != 0.0f) {
+      this->addColumn(difference, this->columns + i * this->columnStride, this->columnStride, accumulator.sums.data());
+      changed++;
+    }
+  }
+
+  return changed;
+}
+
+/**
+ * Run the network from the first layer sums of a position.
+ * @param accumulator filled by refresh or update
+ * @return float the first output neuron
+ */
+float DenseNetwork::run(const Accumulator& accumulator) const {
+  auto& buffers = this->scratch();
+  float* values = buffers.output.data();
+  std::copy(accumulator.sums.begin(), accumulator.sums.end(), values);
+  this->activateLayer(this->layers.front(), values);
+
+  return this->runHiddenLayers(buffers, values);
+}
+
+/**
+ * Run the network for several positions from their first layer sums.
+ * @param accumulators n accumulators filled by refresh or update
+ * @param n number of positions
+ * @param outputs the first output neuron of every position
+ */
+void DenseNetwork::run(const Accumulator* accumulators, const size_t n, float* outputs) const {
+  const auto& first = this->layers.front();
+  auto& buffers = this->scratch();
+
+  for (size_t start = 0; start < n; start += BATCH) {
+    const size_t count = std::min(BATCH, n - start);
+
+    float* values = buffers.batchOutput.data();
+    for (size_t b = 0; b < count; b++) {
+      const auto& sums = accumulators[start + b].sums;
+      float* out = values + b * this->widest;
+      std::copy(sums.begin(), sums.end(), out);
+      this->activateLayer(first, out);
+    }
+
+    this->runBatch(buffers, values, 1, count, outputs + start);
+  }
+}
+
+/**
+ * Run every layer after the first.
+ * @param buffers scratch buffers of the calling thread
+ * @param values outputs of the first layer, in the output buffer
+ * @return float the first output neuron
+ */
+float DenseNetwork::runHiddenLayers(Scratch& buffers, float* values) const {
+  float* in = values;
+  float* out = values == buffers.output.data() ? buffers.input.data() : buffers.output.data();
+
+  for (size_t l = 1; l < this->layers.size(); l++) {
+    this->runLayer(this->layers[l], in, out);
+    std::swap(in, out);
+  }
+
+  return in[0];
+}
+
+/**
+ * Run the layers from firstLayer and up for a batch of positions.
+ * @param buffers scratch buffers of the calling thread
+ * @param values inputs of firstLayer, in one of the batch buffers
+ * @param firstLayer index of the first layer to run
+ * @param n positions in the batch, at most BATCH
+ * @param outputs the first output neuron of every position
+ */
+void DenseNetwork::runBatch(Scratch& buffers, float* values, const size_t firstLayer, const size_t n, float* outputs) const {
+  float* in = values;
+  float* out = values == buffers.batchOutput.data() ? buffers.batchInput.data() : buffers.batchOutput.data();
+
+  for (size_t l = firstLayer; l < this->layers.size(); l++) {
+    this->runBatchLayer(this->layers[l], in, n, this->widest, out);
+    std::swap(in, out);
+  }
+
+  for (size_t b = 0; b < n; b++) {
+    outputs[b] = in[b * this->widest];
+  }
+}
+
+/**
+ * Run the integer layers. The inputs get a scale of their own, since they
+ * range from hundredths to about a hundred.
+ * @param buffers scratch buffers of the calling thread
+ * @param inputs as many as the first layer has neurons
+ * @return float the first output neuron
+ */
+float DenseNetwork::runQuantized(Scratch& buffers, const float* inputs) const {
+  const auto& first = this->layers.front();
+
+  float largest = 0.0f;
+  for (size_t i = 0; i < first.inputs; i++) {
+    largest = std::max(largest, std::fabs(inputs[i]));
+  }
+  const float inputScale = largest > 0.0f ? 32767.0f / largest : 1.0f;
+
+  int16_t* wide = buffers.wideInput.data();
+  for (size_t i = 0; i < first.inputs; i++) {
+    const float value = inputs[i] * inputScale;
+    wide[i] = static_cast<int16_t>(value < 0.0f ? value - 0.5f : value + 0.5f);
+  }
+
+  float* values = buffers.output.data();
+  int32_t* integerSums = buffers.sums.data();
+
+  const auto& firstQuantized = this->quantizedLayers.front();
+  this->runFirstLayer(first, firstQuantized, wide, integerSums);
+  this->dequantize(integerSums, firstQuantized.offsets.data(), firstQuantized.scale / inputScale, first.outputs, values);
+  this->activateLayer(first, values);
+
+  uint8_t* activated = buffers.activations.data();
+  for (size_t l = 1; l < this->layers.size(); l++) {
+    const auto& layer = this->layers[l];
+    const auto& quantized = this->quantizedLayers[l];
+
+    this->quantizeActivations(values, this->layers[l - 1].outputs, activated);
+    this->runHiddenLayer(layer, quantized, activated, integerSums);
+    this->dequantize(integerSums, quantized.offsets.data(), quantized.scale, layer.outputs, values);
+    this->activateLayer(layer, values);
+  }
+
+  return values[0];
+}
+
+/**
+ * @return const char* name of the kernels in use, "avx2" or "scalar", with
+ * " int8" added when quantized
+ */
+const char* DenseNetwork::kernel() const {
+  if (this->isQuantized()) {
+    return this->vectorized ? "avx2 int8" : "scalar int8";
+  }
+
+  return this->vectorized ? "avx2" : "scalar";
+}
+
+void DenseNetwork::runLayerScalar(const Layer& layer, const float* input, float* output) {
+  const float* row = layer.weights;
+
+  for (size_t r = 0; r < layer.outputs; r++, row += layer.stride) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < layer.inputs; i++) {
+      sum += row[i] * input[i];
+    }
+    output[r] = sum;
+  }
+
+  activateLayerScalar(layer, output);
+}
+
+void DenseNetwork::runBatchLayerScalar(const Layer& layer, const float* input, const size_t n, const size_t pitch, float* output) {
+  const float* row = layer.weights;
+
+  for (size_t r = 0; r < layer.outputs; r++, row += layer.stride) {
+    for (size_t b = 0; b < n; b++) {
+      const float* x = input + b * pitch;
+      float sum = 0.0f;
+      for (size_t i = 0; i < layer.inputs; i++) {
+        sum += row[i] * x[i];
+      }
+      output[b * pitch + r] = sum;
+    }
+  }
+
+  for (size_t b = 0; b < n; b++) {
+    activateLayerScalar(layer, output + b * pitch);
+  }
+}
+
+void DenseNetwork::runFirstLayerScalar(const Layer& layer, const QuantizedLayer& quantized, const int16_t* input, int32_t* sums) {
+  const int16_t* row = quantized.wideWeights.data();
+
+  for (size_t r = 0; r < layer.outputs; r++, row += quantized.stride) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < layer.inputs; i++) {
+      sum += row[i] * input[i];
+    }
+    sums[r] = sum;
+  }
+}
+
+void DenseNetwork::runHiddenLayerScalar(const Layer& layer, const QuantizedLayer& quantized, const uint8_t* input, int32_t* sums) {
+  const int8_t* row = quantized.weights.data();
+
+  for (size_t r = 0; r < layer.outputs; r++, row += quantized.stride) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < layer.inputs; i++) {
+      sum += row[i] * input[i];
+    }
+    sums[r] = sum;
+  }
+}
+
+void DenseNetwork::addColumnScalar(const float factor, const float* column, const size_t n, float* sums) {
+  for (size_t i = 0; i < n; i++) {
+    sums[i] += factor * column[i];
+  }
+}
+
+void DenseNetwork::dequantizeScalar(const int32_t* sums, const int32_t* offsets, const float scale, const size_t n, float* values) {
+  for (size_t i = 0; i < n; i++) {
+    values[i] = static_cast<float>(sums[i] - offsets[i]) * scale;
+  }
+}
+
+void DenseNetwork::quantizeScalar(const float* values, const size_t n, uint8_t* activations) {
+  for (size_t i = 0; i < n; i++) {
+    const float value = std::min(std::max(values[i], -1.0f), 1.0f) * ACTIVATION_ONE + ACTIVATION_ONE;
+    activations[i] = static_cast<uint8_t>(value + 0.5f);
+  }
+}
+
+void DenseNetwork::activateLayerScalar(const Layer& layer, float* values) {
+  const float* biases = layer.biases;
+
+  for (size_t r = 0; r < layer.outputs; r++) {
+    values[r] = activate(layer.activation, (values[r] + biases[r]) * layer.steepness);
+  }
+
+  // padding, the next layer reads whole registers
+  std::fill(values + layer.outputs, values + roundUp(layer.outputs, LANES), 0.0f);
+}
+
+#ifdef DAVID_DENSE_AVX2
+
+namespace {
+
+__attribute__((target("avx2,fma")))
+inline __m256 expAVX2(__m256 x) {
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-EXP_LIMIT)), _mm256_set1_ps(EXP_LIMIT));
+
+  const __m256 n = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(LOG2E), _mm256_set1_ps(0.5f)));
+  x = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_HIGH), x);
+  x = _mm256_fnmadd_ps(n, _mm256_set1_ps(LN2_LOW), x);
+
+  __m256 y = _mm256_set1_ps(EXP_P0);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P1));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P2));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P3));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P4));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P5));
+  y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+
+  const __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvttps_epi32(n), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(bits));
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256 activateAVX2(const int activation, const __m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+
+  switch (activation) {
+    case DenseNetwork::SIGMOID:
+      return _mm256_div_ps(one, _mm256_add_ps(one, expAVX2(_mm256_mul_ps(x, _mm256_set1_ps(-2.0f)))));
+    case DenseNetwork::SIGMOID_SYMMETRIC:
+      return _mm256_sub_ps(
+          _mm256_div_ps(_mm256_set1_ps(2.0f), _mm256_add_ps(one, expAVX2(_mm256_mul_ps(x, _mm256_set1_ps(-2.0f))))),
+          one);
+    default:
+      return x;
+  }
+}
+
+__attribute__((target("avx2,fma")))
+inline float horizontalSum(const __m256 v) {
+  __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+  return _mm_cvtss_f32(sum);
+}
+
+__attribute__((target("avx2,fma")))
+inline int32_t horizontalSum(const __m256i v) {
+  __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(sum);
+}
+
+// lane i of the result is the sum of the i'th argument
+__attribute__((target("avx2,fma")))
+inline __m128 horizontalSums(const __m256 sum0, const __m256 sum1, const __m256 sum2, const __m256 sum3) {
+  const __m256 pairs = _mm256_hadd_ps(_mm256_hadd_ps(sum0, sum1), _mm256_hadd_ps(sum2, sum3));
+  return _mm_add_ps(_mm256_castps256_ps128(pairs), _mm256_extractf128_ps(pairs, 1));
+}
+
+// lane i of the result is the sum of the i'th argument
+__attribute__((target("avx2,fma")))
+inline __m128i horizontalSums(const __m256i sum0, const __m256i sum1, const __m256i sum2, const __m256i sum3) {
+  const __m256i pairs = _mm256_hadd_epi32(_mm256_hadd_epi32(sum0, sum1), _mm256_hadd_epi32(sum2, sum3));
+  return _mm_add_epi32(_mm256_castsi256_si128(pairs), _mm256_extracti128_si256(pairs, 1));
+}
+
+// products of unsigned activations and signed weights, added up in int32 pairs
+__attribute__((target("avx2,fma")))
+inline __m256i multiplyBytes(const __m256i activations, const __m256i weights) {
+  return _mm256_madd_epi16(_mm256_maddubs_epi16(activations, weights), _mm256_set1_epi16(1));
+}
+
+} // anonymous namespace
+
+__attribute__((target("avx2,fma")))
+void DenseNetwork::runLayerAVX2(const Layer& layer, const float* input, float* output) {
+  const size_t stride = layer.stride;
+  const float* weights = layer.weights;
+
+  // four rows at a time share the loads of the input
+  size_t r = 0;
+  for (; r + 4 <= layer.outputs; r += 4) {
+    const float* row = weights + r * stride;
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps();
+    __m256 sum3 = _mm256_setzero_ps();
+
+    for (size_t i = 0; i < stride; i += LANES) {
+      const __m256 x = _mm256_load_ps(input + i);
+      sum0 = _mm256_fmadd_ps(_mm256_load_ps(row + i), x, sum0);
+      sum1 = _mm256_fmadd_ps(_mm256_load_ps(row + stride + i), x, sum1);
+      sum2 = _mm256_fmadd_ps(_mm256_load_ps(row + 2 * stride + i), x, sum2);
+      sum3 = _mm256_fmadd_ps(_mm256_load_ps(row + 3 * stride + i), x, sum3);
+    }
+
+    _mm_storeu_ps(output + r, horizontalSums(sum0, sum1, sum2, sum3));
+  }
+
+  for (; r < layer.outputs; r++) {
+    const float* row = weights + r * stride;
+    __m256 sum = _mm256_setzero_ps();
+    for (size_t i = 0; i < stride; i += LANES) {
+      sum = _mm256_fmadd_ps(_mm256_load_ps(row + i), _mm256_load_ps(input + i), sum);
+    }
+    output[r] = horizontalSum(sum);
+  }
+
+  activateLayerAVX2(layer, output);
+}
+
+__attribute__((target("avx2,fma")))
+void DenseNetwork::runBatchLayerAVX2(const Layer& layer, const float* input, const size_t n, const size_t pitch, float* output) {
+  const size_t stride = layer.stride;
+  const float* weights = layer.weights;
+
+  // four rows are applied to every position of the batch before moving on,
+  // two positions at a time share the loads of the weights
+  size_t r = 0;
+  for (; r + 4 <= layer.outputs; r += 4) {
+    const float* row = weights + r * stride;
+
+    size_t b = 0;
+    for (; b + 2 <= n; b += 2) {
+      const float* x0 = input + b * pitch;
+      const float* x1 = x0 + pitch;
+      __m256 sum00 = _mm256_setzero_ps();
+      __m256 sum01 = _mm256_setzero_ps();
+      __m256 sum02 = _mm256_setzero_ps();
+      __m256 sum03 = _mm256_setzero_ps();
+      __m256 sum10 = _mm256_setzero_ps();
+      __m256 sum11 = _mm256_setzero_ps();
+      __m256 sum12 = _mm256_setzero_ps();
+      __m256 sum13 = _mm256_setzero_ps();
+
+      for (size_t i = 0; i < stride; i += LANES) {
+        const __m256 a = _mm256_load_ps(x0 + i);
+        const __m256 c = _mm256_load_ps(x1 + i);
+        __m256 w = _mm256_load_ps(row + i);
+        sum00 = _mm256_fmadd_ps(w, a, sum00);
+        sum10 = _mm256_fmadd_ps(w, c, sum10);
+        w = _mm256_load_ps(row + stride + i);
+        sum01 = _mm256_fmadd_ps(w, a, sum01);
+        sum11 = _mm256_fmadd_ps(w, c, sum11);
+        w = _mm256_load_ps(row + 2 * stride + i);
+        sum02 = _mm256_fmadd_ps(w, a, sum02);
+        sum12 = _mm256_fmadd_ps(w, c, sum12);
+        w = _mm256_load_ps(row + 3 * stride + i);
+        sum03 = _mm256_fmadd_ps(w, a, sum03);
+        sum13 = _mm256_fmadd_ps(w, c, sum13);
+      }
+
+      _mm_storeu_ps(output + b * pitch + r, horizontalSums(sum00, sum01, sum02, sum03));
+      _mm_storeu_ps(output + (b + 1) * pitch + r, horizontalSums(sum10, sum11, sum12, sum13));
+    }
+
+    for (; b < n; b++) {
+      const float* x = input + b * pitch;
+      __m256 sum0 = _mm256_setzero_ps();
+      __m256 sum1 = _mm256_setzero_ps();
+      __m256 sum2 = _mm256_setzero_ps();
+      __m256 sum3 = _mm256_setzero_ps();
+
+      for (size_t i = 0; i < stride; i += LANES) {
+        const __m256 a = _mm256_load_ps(x + i);
+        sum0 = _mm256_fmadd_ps(_mm256_load_ps(row + i), a, sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_load_ps(row + stride + i), a, sum1);
+        sum2 = _mm256_fmadd_ps(_mm256_load_ps(row + 2 * stride + i), a, sum2);
+        sum3 = _mm256_fmadd_ps(_mm256_load_ps(row + 3 * stride + i), a, sum3);
+      }
+
+      _mm_storeu_ps(output + b * pitch + r, horizontalSums(sum0, sum1, sum2, sum3));
+    }
+  }
+
+  for (; r < layer.outputs; r++) {
+    const float* row = weights + r * stride;
+    for (size_t b = 0; b < n; b++) {
+      const float* x = input + b * pitch;
+      __m256 sum = _mm256_setzero_ps();
+      for (size_t i = 0; i < stride; i += LANES) {
+        sum = _mm256_fmadd_ps(_mm256_load_ps(row + i), _mm256_load_ps(x + i), sum);
+      }
+      output[b * pitch + r] = horizontalSum(sum);
+    }
+  }
+
+  for (size_t b = 0; b < n; b++) {
+    activateLayerAVX2(layer, output + b * pitch);
+  }
+}
+
+__attribute__((target("avx2,fma")))
+void DenseNetwork::runFirstLayerAVX2(const Layer& layer, const QuantizedLayer& quantized, const int16_t* input, int32_t* sums) {
+  const size_t stride = quantized.stride;
+  const int16_t* weights = quantized.wideWeights.data();
+
+  size_t r = 0;
+  for (; r + 4 <= layer.outputs; r += 4) {
+    const int16_t* row = weights + r * stride;
+    __m256i sum0 = _mm256_setzero_si256();
+    __m256i sum1 = _mm256_setzero_si256();
+    __m256i sum2 = _mm256_setzero_si256();
+    __m256i sum3 = _mm256_setzero_si256();
+
+    for (size_t i = 0; i < stride; i += 16) {
+      const __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(input + i));
+      sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(row + i)), x));
+      sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(row + stride + i)), x));
+      sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(row + 2 * stride + i)), x));
+      sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(row + 3 * stride + i)), x));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + r), horizontalSums(sum0, sum1, sum2, sum3));
+  }
+
+  for (; r < layer.outputs; r++) {
+    const int16_t* row = weights + r * stride;
+    __m256i sum = _mm256_setzero_si256();
+    for (size_t i = 0; i < stride; i += 16) {
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(row + i)),
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(input + i))));
+    }
+    sums[r] = horizontalSum(sum);
+  }
+}
+
+__attribute__((target("avx2,fma")))
+void DenseNetwork::runHiddenLayerAVX2(const Layer& layer, const QuantizedLayer& quantized, const uint8_t* input, int32_t* sums) {
+  const size_t stride = quantized.stride;
+  const int8_t* weights = quantized.weights.data();
+
+  size_t r = 0;
+  for (; r + 4 <= layer.outputs; r += 4) {
+    const int8_t* row = weights + r * stride;
+    __m256i sum0 = _mm256_setzero_si256();
+    __m256i sum1 = _mm256_setzero_si256();
+    __m256i sum2 = _mm256_setzero_si256();
+    __m256i sum3 = _mm256_setzero_si256();
+
+    for (size_t i = 0; i < stride; i += 32) {
+      const __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(input + i));
+      sum0 = _mm256_add_epi32(sum0, multiplyBytes(x, _mm256_load_si256(reinterpret_cast<const __m256i*>(row + i))));
+      sum1 = _mm256_add_epi32(sum1, multiplyBytes(x, _mm256_load_si256(reinterpret_cast<const __m256i*>(row + stride + i))));
+      sum2 = _mm256_add_epi32(sum2, multiplyBytes(x, _mm256_load_si256(reinterpret_cast<const __m256i*>(row + 2 * stride + i))));
+      sum3 = _mm256_add_epi32(sum3, multiplyBytes(x, _mm256_load_si256(reinterpret_cast<const __m256i*>(row + 3 * stride + i))));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(sums + r), horizontalSums(sum0, sum1, sum2, sum3));
+  }
+
+  for (; r < layer.outputs; r++) {
+    const int8_t* row = weights + r * stride;
+    __m256i sum = _mm256_setzero_si256();
+    for (size_t i = 0; i < stride; i += 32) {
+      sum = _mm256_add_epi32(sum, multiplyBytes(
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(input + i)),
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(row + i))));
+    }
+    sums[r] = horizontalSum(sum);
+  }
+}
+
+__attribute__((target("avx2,fma")))
+void DenseNetwork::activateLayerAVX2(const Layer& layer, float* values) {
+  const size_t padded = roundUp(layer.outputs, LANES);
+  std::fill(values + layer.outputs, values + padded, 0.0f);
+
+  const __m256 steepness = _mm256_set1_ps(layer.steepness);
+  for (size_t i = 0; i < padded; i += LANES) {
+    const __m256 sum = _mm256_add_ps(_mm256_load_ps(values + i), _mm256_load_ps(layer.biases + i));
+    _mm256_store_ps(values + i, activateAVX2(layer.activation, _mm256_mul_ps(sum, steepness)));
+  }
+
+  // the activation of the padding isn't always zero
+  std::fill(values + layer.outputs, values + padded, 0.0f);
+}
+
+__attribute__((target("avx2,fma")))
+void DenseNetwork::addColumnAVX2(const float factor, const float* column, const size_t n, float* sums) {
+  const __m256 multiplier = _mm256_set1_ps(factor);
+
+  for (size_t i = 0; i < n; i += LANES) {
+    _mm256_storeu_ps(sums + i, _mm256_fmadd_ps(multiplier, _mm256_load_ps(column + i), _mm256_loadu_ps(sums + i)));
+  }
+}
+
+__attribute__((target("avx2,fma")))
+void DenseNetwork::dequantizeAVX2(const int32_t* sums, const int32_t* offsets, const float scale, const size_t n, float* values) {
+  const __m256 factor = _mm256_set1_ps(scale);
+
+  size_t i = 0;
+  for (; i + LANES <= n; i += LANES) {
+    const __m256i sum = _mm256_sub_epi32(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(sums + i)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(offsets + i)));
+    _mm256_store_ps(values + i, _mm256_mul_ps(_mm256_cvtepi32_ps(sum), factor));
+  }
+
+  dequantizeScalar(sums + i, offsets + i, scale, n - i, values + i);
+}
+
+__attribute__((target("avx2,fma")))
+void DenseNetwork::quantizeAVX2(const float* values, const size_t n, uint8_t* activations) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 minusOne = _mm256_set1_ps(-1.0f);
+  const __m256 scale = _mm256_set1_ps(ACTIVATION_ONE);
+  const __m256i offset = _mm256_set1_epi32(ACTIVATION_ONE);
+
+  // the packs interleave the 128 bit lanes, this puts the values back in order
+  const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+  // whole registers, the buffers are padded and the weights of the padding are zero
+  for (size_t i = 0; i < n; i += 32) {
+    __m256i quarters[4];
+    for (size_t q = 0; q < 4; q++) {
+      const __m256 value = _mm256_min_ps(_mm256_max_ps(_mm256_load_ps(values + i + q * LANES), minusOne), one);
+      quarters[q] = _mm256_add_epi32(_mm256_cvtps_epi32(_mm256_mul_ps(value, scale)), offset);
+    }
+
+    const __m256i words = _mm256_packus_epi16(
+        _mm256_packs_epi32(quarters[0], quarters[1]),
+        _mm256_packs_epi32(quarters[2], quarters[3]));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(activations + i), _mm256_permutevar8x32_epi32(words, order));
+  }
+}
+
+#else
+
+void DenseNetwork::runLayerAVX2(const Layer& layer, const float* input, float* output) {
+  runLayerScalar(layer, input, output);
+}
+
+void DenseNetwork::runBatchLayerAVX2(const Layer& layer, const float* input, const size_t n, const size_t pitch, float* output) {
+  runBatchLayerScalar(layer, input, n, pitch, output);
+}
+
+void DenseNetwork::runFirstLayerAVX2(const Layer& layer, const QuantizedLayer& quantized, const int16_t* input, int32_t* sums) {
+  runFirstLayerScalar(layer, quantized, input, sums);
+}
+
+void DenseNetwork::runHiddenLayerAVX2(const Layer& layer, const QuantizedLayer& quantized, const uint8_t* input, int32_t* sums) {
+  runHiddenLayerScalar(layer, quantized, input, sums);
+}
+
+void DenseNetwork::activateLayerAVX2(const Layer& layer, float* values) {
+  activateLayerScalar(layer, values);
+}
+
+void DenseNetwork::addColumnAVX2(const float factor, const float* column, const size_t n, float* sums) {
+  addColumnScalar(factor, column, n, sums);
+}
+
+void DenseNetwork::dequantizeAVX2(const int32_t* sums, const int32_t* offsets, const float scale, const size_t n, float* values) {
+  dequantizeScalar(sums, offsets, scale, n, values);
+}
+
+void DenseNetwork::quantizeAVX2(const float* values, const size_t n, uint8_t* activations) {
+  quantizeScalar(values, n, activations);
+}
+
+#endif
+
+}
@@ -0,0 +1,100 @@
+#include "david/Bench.h"
+#include "david/ANN/ANN.h"
+#include "david/Search.h"
+#include "david/TreeGen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace david {
+
+/**
+ * Constructor
+ * @param tg the tree the positions are set up in
+ * @param search searches the positions
+ */
+Bench::Bench(type::TreeGen_t& tg, type::Search_t& search)
+    : treeGen(tg)
+    , search(search)
+{}
+
+/**
+ * FEN strings of the built in positions: openings, middle games with
+ * tactics and a few endgames, so every part of the search is exercised.
+ */
+const std::vector<std::string>& Bench::positions() {
+  static const std::vector<std::string> fens = {
+      "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+      "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+      "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+      "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+      "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+      "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+      "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/8 b - - 0 1",
+      "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 80"
+  };
+
+  return fens;
+}
+
+/**
+ * Search every position, and print the totals.
+ * @param depth iterations of every search
+ * @param threads search threads, the search is single threaded so only 1 is used
+ * @param hash transposition table size in MB
+ * @param out where the totals are written
+ * @return the totals
+ */
+Bench::Result Bench::run(const int depth, const int threads, const int hash, std::ostream& out) {
+  if (threads != 1) {
+    out << "info string the search is single threaded, bench uses 1 thread" << std::endl;
+  }
+
+  this->search.setHashSize(hash);
+  if (depth > this->search.getMaxDepth()) {
+    this->search.setMaxDepth(depth);
+  }
+
+  // cached scores from before would make the timing depend on what ran first
+  auto& cache = this->treeGen.getNeuralNetwork().getEvaluationCache();
+  cache.clear();
+
+  Result result{0, 0, 0};
+  const auto start = std::chrono::steady_clock::now();
+
+  const auto& fens = positions();
+  for (size_t i = 0; i < fens.size(); i++) {
+    out << "position " << (i + 1) << "/" << fens.size() << ": " << fens[i] << std::endl;
+
+    // every position starts from nothing, like a new game
+    this->treeGen.reset();
+    this->search.clearHash();
+    this->treeGen.setPosition(fens[i], {});
+
+    this->search.resetTimeControls();
+    this->search.setDepth(depth);
+    this->search.setAbort(false);
+    this->search.searchInit();
+
+    result.nodes += this->search.getNodes();
+  }
+
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  result.time = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+  result.nps = result.nodes * 1000 / static_cast<uint64_t>(std::max(result.time, 1));
+
+  out << "===========================" << std::endl;
+  out << "Total time (ms) : " << result.time << std::endl;
+  out << "Nodes searched  : " << result.nodes << std::endl;
+  out << "Nodes/second    : " << result.nps << std::endl;
+  if (cache.getProbes() > 0) {
+    out << "Eval cache hits : " << cache.getHits() * 100 / cache.getProbes() << "% of " << cache.getProbes() << std::endl;
+  }
+
+  return result;
+}
+
+}
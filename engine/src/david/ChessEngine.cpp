@@ -5,6 +5,7 @@
 #include "david/david.h"
 #include "david/utils/utils.h"
 #include "david/MoveGen.h"
+#include "david/Bench.h"
 
 #include "david/types.h"
 #include "david/bitboard.h"
@@ -15,6 +16,7 @@
 #include "uci/events.h"
 
 // system dependencies
+#include <algorithm>
 #include <functional>
 #include <david/utils/gameState.h>
 
@@ -29,6 +31,10 @@ david::ChessEngine::ChessEngine()
     , player()
     , UCIProtocolActivated(false)
     , uciMode(false)
+    , ponderHitReceived(false)
+    , book()
+    , ownBook(false)
+    , bookBestMove(false)
 
 {
   this->createANNInstance();
@@ -47,6 +53,10 @@ david::ChessEngine::ChessEngine(Player self)
     , player(self)
     , UCIProtocolActivated(false)
     , uciMode(false)
+    , ponderHitReceived(false)
+    , book()
+    , ownBook(false)
+    , bookBestMove(false)
 
 {
   this->createANNInstance();
@@ -65,6 +75,10 @@ david::ChessEngine::ChessEngine(const std::string ANNFile)
     , player()
     , UCIProtocolActivated(false)
     , uciMode(false)
+    , ponderHitReceived(false)
+    , book()
+    , ownBook(false)
+    , bookBestMove(false)
 {
   this->createANNInstance();
 }
@@ -83,6 +97,10 @@ david::ChessEngine::ChessEngine(Player self, const std::string ANNFile)
     , player(self)
     , UCIProtocolActivated(false)
     , uciMode(false)
+    , ponderHitReceived(false)
+    , book()
+    , ownBook(false)
+    , bookBestMove(false)
 
 {
   this->createANNInstance();
@@ -111,6 +129,7 @@ void ::david::ChessEngine::linkUCICommands()
   using ::uci::event::BLACK;
   using ::uci::event::WHITE;
   using ::uci::event::PERFT;
+  using ::uci::event::SETOPTION;
   using ::uci::arguments_t;
 
   // set chess engine colour
@@ -129,33 +148,39 @@ void ::david::ChessEngine::linkUCICommands()
 
     bool startSearch = false;
     bool infinite = false;
-    bool movetime = false;
+    bool ponder = false;
+
+    // a ponder search that got its ponderhit may still be wrapping up
+    if (this->searchThread.joinable()) {
+      this->searchThread.join();
+    }
+
+    // clock parameters only apply to this go command
+    this->search.resetTimeControls();
+    this->ponderHitReceived = false;
+
     // All of the "go" parameters
     if (args.count("depth") > 0) {
       this->search.setDepth(utils::stoi(args["depth"]));
     }
+    else if (args.count("wtime") > 0 || args.count("btime") > 0 || args.count("movetime") > 0) {
+      // the clock decides when to stop, not the depth
+      this->search.setDepth(this->search.getMaxDepth());
+    }
     if (args.count("searchmoves") > 0) {
       this->search.setSearchMoves(args["searchmoves"]);
     }
     if (args.count("wtime") > 0) {
-      //this->searchPtr->setWTime(utils::stoi(args["wtime"]));
-      this->wtime = utils::stoi(args["wtime"]);
-      if (this->player.isWhite) {
-        this->timeLeft = this->wtime;
-      }
+      this->search.setWTime(utils::stoi(args["wtime"]));
     }
     if (args.count("btime") > 0) {
-      //this->searchPtr->setBTime(utils::stoi(args["btime"]));
-      this->btime = utils::stoi(args["btime"]);
-      if (!this->player.isWhite) {
-        this->timeLeft = this->btime;
-      }
+      this->search.setBTime(utils::stoi(args["btime"]));
     }
     if (args.count("winc") > 0) {
-      //this->searchPtr->setWinc(utils::stoi(args["winc"]));
+      this->search.setWinc(utils::stoi(args["winc"]));
     }
     if (args.count("binc") > 0) {
-      //this->searchPtr->setBinc(utils::stoi(args["binc"]));
+      this->search.setBinc(utils::stoi(args["binc"]));
     }
     if (args.count("movestogo") > 0) {
       this->search.setMovesToGo(utils::stoi(args["movestogo"]));
@@ -165,7 +190,6 @@ void ::david::ChessEngine::linkUCICommands()
     }
     if (args.count("movetime") > 0) {
       this->search.setMoveTime(utils::stoi(args["movetime"]));
-      movetime = true;
     }
     if (args.count("mate") > 0) {
       this->search.setMate(utils::stoi(args["mate"]));
@@ -177,37 +201,37 @@ void ::david::ChessEngine::linkUCICommands()
     }
     if (args.count("ponder") > 0) {
       this->search.setPonder(true);
+      ponder = true;
     }
     if (args.count("difficulty") > 0) {
       this->search.setDifficulty(utils::stoi(args["difficulty"]));
     }
 
-
-    // update time remaining for search class
-    if (!movetime) {
-      this->search.setMoveTime(this->timeLeft);
+    // a book move is played without searching, unless the GUI wants analysis
+    std::string bookMove;
+    if (this->ownBook && !infinite && !ponder && args.count("mate") == 0 && args.count("searchmoves") == 0
+        && this->book.probe(this->treeGen.getGameState(0), this->bookBestMove, bookMove)) {
+      std::cout << "info string book move " << bookMove << std::endl;
+      std::cout << "bestmove " << bookMove << std::endl;
+      return;
     }
 
-    if (infinite) {
+    // must happen before the search thread starts, otherwise a quick stop could be lost
+    this->search.setAbort(false);
+
+    if (infinite || ponder) {
       this->searchThread = std::thread([&]() {
         this->search.searchInit();
+
+        // after ponderhit the search is a normal timed search, and answers on its own
+        if (this->ponderHitReceived) {
+          this->sendBestMove();
+        }
       });
     }
     else {
       this->search.searchInit();
-    }
-
-    if (!infinite) {
-      // send best move
-      int bestIndex = this->search.getSearchResult();
-      auto EGN = utils::gameState::getEGN(this->treeGen.getGameState(0), this->treeGen.getGameState(bestIndex));
-      std::cout << "bestmove " << EGN << std::endl;
-#ifdef DAVID_DEVELOPMENT
-      ::utils::gameState::print(this->treeGen.getGameState(bestIndex));
-#endif
-      // update time used
-      this->timeLeft -= this->search.getTimeUsed();
-
+      this->sendBestMove();
     }
   };
   auto uci_stop = [&](arguments_t args) {
@@ -216,15 +240,12 @@ void ::david::ChessEngine::linkUCICommands()
     if (this->searchThread.joinable()) {
       this->searchThread.join();
     }
-    int bestIndex = this->search.getSearchResult();
-    // TODO: infinite does not print best move
-    if (bestIndex > 0) {
-      // if a search hasn't been done, this stops us from a sigsegv.
-      auto EGN = utils::gameState::getEGN(this->treeGen.getGameState(0), this->treeGen.getGameState(bestIndex));
-#ifdef DAVID_DEVELOPMENT
-      ::utils::gameState::print(this->treeGen.getGameState(bestIndex));
-#endif
-      std::cout << "bestmove " << EGN << std::endl;
+
+    // the search thread has already answered if ponderhit was received.
+    // When stopping a ponder search the move is sent since the protocol requires one,
+    // but the GUI discards it.
+    if (!this->ponderHitReceived) {
+      this->sendBestMove();
     }
   };
   auto uci_quit = [&](arguments_t args) {
@@ -238,6 +259,8 @@ void ::david::ChessEngine::linkUCICommands()
 //     * ponderhit
 //	the user has played the expected move. This will be sent if the engine was told to ponder on the same move
 //	the user has played. The engine should continue searching but switch from pondering to normal search.
+    this->ponderHitReceived = true;
+    this->search.ponderHit();
   };
   auto uci_ucinewgame = [&](arguments_t args) {
 //    * ucinewgame
@@ -251,33 +274,26 @@ void ::david::ChessEngine::linkUCICommands()
 //    after "ucinewgame" to wait for the engine to finish its operation.
     // TODO: clear gameTree history
     this->treeGen.reset();
+    this->search.clearHash();
 
   };
 
   auto uci_position = [&](arguments_t args) {
+    std::string FEN;
     if (args.count("fen") > 0) {
-      this->treeGen.setRootNodeFromFEN(args["fen"]);
-
-#ifdef DAVID_DEVELOPMENT
-      std::cout << "Root node of game tree:" << std::endl;
-      utils::gameState::print(this->treeGen.getGameState(0));
-#endif
+      FEN = args["fen"];
     }
     else if (args.count("startpos") > 0) {
-      this->treeGen.setRootNodeFromFEN(constant::FENStartPosition);
+      FEN = constant::FENStartPosition;
     }
     else {
       std::cerr << "NOT SUPPORTED UCI PARAMETERS!" << std::endl;
+      return;
     }
 
-    // check for moves after given position
+    // get every egn string
+    std::vector<std::string> egns;
     if (args.count("moves") > 0) {
-      // replace by applyEGNMove,
-      // but since startpos / fen, resets the node to the default each time
-      // this command should run for every move in moves given to sync the engine correctly.
-
-      // get every egn string and apply it.
-      std::vector<std::string> egns;
       const std::string moves = args["moves"];
       const auto len = moves.length();
       std::string move = "";
@@ -291,8 +307,9 @@ void ::david::ChessEngine::linkUCICommands()
           }
 
           // a EGN has been registered
-          //egns.push_back(move);
-          this->treeGen.applyEGNMove(move);
+          if (!move.empty()) {
+            egns.push_back(move);
+          }
 
           // clear the move var
           move.clear();
@@ -302,7 +319,13 @@ void ::david::ChessEngine::linkUCICommands()
           move += m;
         }
       }
+    }
+
+    // only the moves that are new since the last position command are applied,
+    // so the tree kept from the previous search can be reused.
+    this->treeGen.setPosition(FEN, egns);
 
+    if (!egns.empty()) {
       // the root node should always have the same colour as the engine!
       bool whitePlayer = this->player.isWhite;
       if (whitePlayer != this->treeGen.getGameState(0).isWhite) {
@@ -319,6 +342,130 @@ void ::david::ChessEngine::linkUCICommands()
 #endif
   };
 
+  auto uci_setoption = [&](arguments_t args) {
+    if (args.count("name") == 0) {
+      return;
+    }
+
+    const std::string name = args["name"];
+    const std::string value = args.count("value") > 0 ? args["value"] : "";
+
+    // search pruning and reductions
+    if (name == "NullMove") {
+      this->search.setNullMovePruning(value == "true");
+    }
+    else if (name == "NullMoveReduction") {
+      this->search.setNullMoveReduction(utils::stoi(value));
+    }
+    else if (name == "NullMoveMinDepth") {
+      this->search.setNullMoveMinDepth(utils::stoi(value));
+    }
+    else if (name == "LMR") {
+      this->search.setLateMoveReductions(value == "true");
+    }
+    else if (name == "LMRMinDepth") {
+      this->search.setLMRMinDepth(utils::stoi(value));
+    }
+    else if (name == "LMRMinMoveIndex") {
+      this->search.setLMRMinMoveIndex(utils::stoi(value));
+    }
+    else if (name == "LMRHistoryThreshold") {
+      this->search.setLMRHistoryThreshold(utils::stoi(value));
+    }
+    else if (name == "Quiescence") {
+      this->search.setQuiescence(value == "true");
+    }
+    else if (name == "SEEPruning") {
+      this->search.setSEEPruning(value == "true");
+    }
+    else if (name == "SEEPruningDepth") {
+      this->search.setSEEPruningDepth(utils::stoi(value));
+    }
+    else if (name == "SEEQuietMargin") {
+      this->search.setSEEQuietMargin(utils::stoi(value));
+    }
+    else if (name == "LazyEval") {
+      this->search.setLazyEvaluation(value == "true");
+    }
+    else if (name == "LazyEvalMargin") {
+      this->search.setLazyEvalMargin(utils::stoi(value));
+    }
+
+    // analysis
+    else if (name == "MultiPV") {
+      this->search.setMultiPV(utils::stoi(value));
+    }
+
+    // aspiration windows
+    else if (name == "AspirationWindow") {
+      this->search.setAspirationWindow(utils::stoi(value));
+    }
+    else if (name == "AspirationMinDepth") {
+      this->search.setAspirationMinDepth(utils::stoi(value));
+    }
+
+    // evaluation
+    else if (name == "QuantizedNetwork") {
+      if (this->neuralNet.setQuantized(value == "true")) {
+        // the stored move lists were scored by the other network
+        this->search.clearHash();
+      }
+      std::cout << "info string network kernel " << this->neuralNet.getKernel() << std::endl;
+    }
+    else if (name == "EvalCache") {
+      this->neuralNet.setEvaluationCacheSize(static_cast<size_t>(std::max(utils::stoi(value), 0)));
+    }
+
+    // search limits
+    else if (name == "MaxDepth") {
+      this->search.setMaxDepth(utils::stoi(value));
+    }
+    else if (name == "Hash") {
+      this->search.setHashSize(utils::stoi(value));
+    }
+
+    // endgame tablebases
+    else if (name == "SyzygyPath") {
+      const unsigned int tables = this->search.setSyzygyPath(value);
+      std::cout << "info string found " << tables << " tablebases" << std::endl;
+    }
+    else if (name == "SyzygyProbeLimit") {
+      this->search.setSyzygyProbeLimit(utils::stoi(value));
+    }
+
+    // opening book
+    else if (name == "OwnBook") {
+      this->ownBook = value == "true";
+    }
+    else if (name == "BookFile") {
+      if (this->book.open(value)) {
+        std::cout << "info string book has " << this->book.size() << " entries" << std::endl;
+      }
+      else if (value != "<empty>") {
+        std::cout << "info string could not open book " << value << std::endl;
+      }
+    }
+    else if (name == "BookBestMove") {
+      this->bookBestMove = value == "true";
+    }
+
+    // time management
+    else if (name == "MoveOverhead") {
+      this->search.setMoveOverhead(utils::stoi(value));
+    }
+    else if (name == "Ponder") {
+      // only tells us the GUI may send go ponder, which is always supported
+    }
+
+    // telemetry
+    else if (name == "InfoInterval") {
+      this->search.setInfoInterval(utils::stoi(value));
+    }
+    else {
+      std::cerr << "Unknown option: " << name << std::endl;
+    }
+  };
+
   auto perft = [&](arguments_t args) {
     std::string FEN = "";
     int depth = 5;
@@ -355,6 +502,7 @@ void ::david::ChessEngine::linkUCICommands()
   this->UCI.addListener(PONDERHIT, uci_ponderhit);
   this->UCI.addListener(UCINEWGAME, uci_ucinewgame);
   this->UCI.addListener(POSITION, uci_position);
+  this->UCI.addListener(SETOPTION, uci_setoption);
 }
 
 
@@ -527,6 +675,7 @@ void david::ChessEngine::findBestMove() {
   // update currentGameState
   // TODO: something is very wrong here
   this->search.setInfinite(false); // must be false, or a incorrect index is returned.
+  this->search.setAbort(false);
   int index = this->search.searchInit(); // maybe store the index and then idk? why is this sigsegv..
 
   auto& gs = this->treeGen.getGameState(index);
@@ -537,6 +686,62 @@ void david::ChessEngine::findBestMove() {
   //this->engineContextPtr->gameTreePtr->updateRootNodeTo(index);
 }
 
+/**
+ * Search the built in benchmark positions, see Bench.
+ * The tree and the transposition table are cleared afterwards.
+ *
+ * @param depth iterations of every search
+ * @param threads search threads
+ * @param hash transposition table size in MB
+ * @return uint64_t nodes of all the searches, the signature of the build
+ */
+uint64_t david::ChessEngine::bench(const int depth, const int threads, const int hash) {
+  Bench bench{this->treeGen, this->search};
+  const auto result = bench.run(depth, threads, hash, std::cout);
+
+  this->treeGen.reset();
+  this->search.clearHash();
+
+  return result.nodes;
+}
+
+
+/**
+ * Send the best move of the last search to the GUI.
+ * If the search was stopped by the deadline or a stop command, the time it took
+ * from then until bestmove is reported as well.
+ */
+void david::ChessEngine::sendBestMove() {
+  int bestIndex = this->search.getSearchResult();
+
+  // TODO: infinite does not print best move
+  if (bestIndex <= 0) {
+    // if a search hasn't been done, this stops us from a sigsegv.
+    return;
+  }
+
+  auto EGN = utils::gameState::getEGN(this->treeGen.getGameState(0), this->treeGen.getGameState(bestIndex));
+#ifdef DAVID_DEVELOPMENT
+  ::utils::gameState::print(this->treeGen.getGameState(bestIndex));
+#endif
+
+  // ponder on the reply of the principal variation, or the expected reply kept in the tree
+  std::string ponder = this->search.getPonderMove();
+  if (!ponder.empty()) {
+    ponder = " ponder " + ponder;
+  }
+  else if (this->treeGen.hasGeneratedChildren(bestIndex) && this->treeGen.getGameState(bestIndex).possibleSubMoves > 0) {
+    const auto replyIndex = this->treeGen.getChildIndex(bestIndex, 0);
+    ponder = " ponder " + utils::gameState::getEGN(this->treeGen.getGameState(bestIndex), this->treeGen.getGameState(replyIndex));
+  }
+
+  const int latency = this->search.bestMoveSent();
+  if (latency >= 0) {
+    std::cout << "info string stop latency " << latency << "us" << std::endl;
+  }
+  std::cout << "bestmove " << EGN << ponder << std::endl;
+}
+
 
 /**
  * Used to reset old data, and construct a new fresh game for this engine.
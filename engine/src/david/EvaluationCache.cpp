@@ -0,0 +1,158 @@
+#include "david/EvaluationCache.h"
+#include "david/utils/gameState.h"
+
+namespace david {
+
+namespace {
+constexpr uint64_t USED = 1ULL << 32;
+
+// spread the move counters over the key, the zobrist hash doesn't have them
+constexpr uint64_t HALF_MOVES = 0x9E3779B97F4A7C15ULL;
+constexpr uint64_t FULL_MOVES = 0xC2B2AE3D27D4EB4FULL;
+
+// a counter written by one thread only, a shared slot may lose a count
+inline void increment(std::atomic<uint64_t>& counter) {
+  counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+}
+
+/**
+ * Constructor
+ * @param megabytes approximate memory use, 0 turns the cache off
+ */
+EvaluationCache::EvaluationCache(const size_t megabytes)
+    : mask(0)
+{
+  this->resize(megabytes);
+}
+
+/**
+ * Change the size of the table, this clears it.
+ * The number of slots is rounded down to a power of two.
+ *
+ * @param megabytes approximate memory use, 0 turns the cache off
+ */
+void EvaluationCache::resize(const size_t megabytes) {
+  this->slots.reset();
+  this->mask = 0;
+
+  if (megabytes > 0) {
+    const size_t wanted = megabytes * 1024 * 1024 / sizeof(Slot);
+
+    size_t nrOfSlots = 1;
+    while (nrOfSlots * 2 <= wanted) {
+      nrOfSlots *= 2;
+    }
+
+    this->slots.reset(new Slot[nrOfSlots]);
+    this->mask = nrOfSlots - 1;
+  }
+
+  this->clear();
+}
+
+/**
+ * Forget every stored score.
+ */
+void EvaluationCache::clear() {
+  for (size_t i = 0; this->slots != nullptr && i <= this->mask; i++) {
+    this->slots[i].check.store(0, std::memory_order_relaxed);
+    this->slots[i].data.store(0, std::memory_order_relaxed);
+  }
+
+  this->resetCounters();
+}
+
+/**
+ * @param gs position
+ * @return uint64_t key of the position, zobrist hash and move counters
+ */
+uint64_t EvaluationCache::key(const type::gameState_t& gs) {
+  return ::utils::gameState::zobristHash(gs)
+      ^ (static_cast<uint64_t>(gs.halfMoves) * HALF_MOVES)
+      ^ (static_cast<uint64_t>(gs.fullMoves) * FULL_MOVES);
+}
+
+/**
+ * Find the score of a position.
+ *
+ * @param key from EvaluationCache::key
+ * @param score set on a hit
+ * @return true if the position is stored
+ */
+bool EvaluationCache::probe(const uint64_t key, int& score) {
+  if (this->slots == nullptr) {
+    return false;
+  }
+
+  auto& counters = this->counters[counterSlot()];
+  increment(counters.probes);
+
+  const auto& slot = this->slots[key & this->mask];
+  const uint64_t data = slot.data.load(std::memory_order_relaxed);
+  if ((data & USED) == 0 || (slot.check.load(std::memory_order_relaxed) ^ data) != key) {
+    return false;
+  }
+
+  increment(counters.hits);
+  score = static_cast<int32_t>(static_cast<uint32_t>(data));
+  return true;
+}
+
+/**
+ * Store the score of a position, replacing the slot content.
+ *
+ * @param key from EvaluationCache::key
+ * @param score ANN score
+ */
+void EvaluationCache::store(const uint64_t key, const int score) {
+  if (this->slots == nullptr) {
+    return;
+  }
+
+  const uint64_t data = USED | static_cast<uint32_t>(score);
+
+  auto& slot = this->slots[key & this->mask];
+  slot.check.store(key ^ data, std::memory_order_relaxed);
+  slot.data.store(data, std::memory_order_relaxed);
+}
+
+size_t EvaluationCache::size() const {
+  return this->slots == nullptr ? 0 : this->mask + 1;
+}
+
+uint64_t EvaluationCache::getProbes() const {
+  uint64_t probes = 0;
+  for (const auto& counters : this->counters) {
+    probes += counters.probes.load(std::memory_order_relaxed);
+  }
+  return probes;
+}
+
+uint64_t EvaluationCache::getHits() const {
+  uint64_t hits = 0;
+  for (const auto& counters : this->counters) {
+    hits += counters.hits.load(std::memory_order_relaxed);
+  }
+  return hits;
+}
+
+void EvaluationCache::resetCounters() {
+  for (auto& counters : this->counters) {
+    counters.probes.store(0, std::memory_order_relaxed);
+    counters.hits.store(0, std::memory_order_relaxed);
+  }
+}
+
+/**
+ * The counters of the calling thread, every thread gets the next slot the
+ * first time it probes.
+ * @return unsigned int index in counters
+ */
+unsigned int EvaluationCache::counterSlot() {
+  static std::atomic<unsigned int> nextSlot{0};
+  thread_local const unsigned int slot = nextSlot.fetch_add(1, std::memory_order_relaxed) % MAX_THREADS;
+  return slot;
+}
+
+}
@@ -0,0 +1,314 @@
+#include "david/MateSearch.h"
+#include "david/MoveGen.h"
+#include "david/utils/gameState.h"
+
+#include <algorithm>
+
+namespace david {
+
+namespace {
+// how often the stop flag is polled, in nodes
+constexpr uint64_t STOP_POLL_MASK = 1023;
+
+inline uint32_t saturatedAdd(const uint32_t a, const uint32_t b) {
+  return std::min<uint64_t>(static_cast<uint64_t>(a) + b, MateSearch::INFINITE);
+}
+}
+
+/**
+ * Constructor
+ * @param control stop flag of the search
+ * @param info where nodes are counted
+ * @param megabytes size of the transposition table
+ */
+MateSearch::MateSearch(const SearchControl& control, SearchInfo& info, const size_t megabytes)
+    : control(control)
+    , info(info)
+    , threadID(0)
+    , aborted(false)
+    , nodes(0)
+    , mask(0)
+{
+  this->resize(megabytes);
+}
+
+/**
+ * Change the size of the transposition table, this clears it.
+ * @param megabytes approximate memory use
+ */
+void MateSearch::resize(const size_t megabytes) {
+  const size_t wanted = std::max<size_t>(megabytes, 1) * 1024 * 1024 / sizeof(Entry);
+
+  size_t nrOfEntries = 1;
+  while (nrOfEntries * 2 <= wanted) {
+    nrOfEntries *= 2;
+  }
+
+  std::vector<Entry>(nrOfEntries).swap(this->table);
+  this->mask = nrOfEntries - 1;
+  this->clear();
+}
+
+/**
+ * Forget every proof and disproof.
+ */
+void MateSearch::clear() {
+  for (auto& entry : this->table) {
+    entry.key = 0;
+    entry.pn = 1;
+    entry.dn = 1;
+    entry.depth = 0xFF; // never matches a real depth
+  }
+}
+
+const std::vector<type::move_t>& MateSearch::getPV() const {
+  return this->pv;
+}
+
+/**
+ * Look for a mate of the side to move.
+ * @param root position to search from
+ * @param moves longest mate to look for, in moves of the side to move
+ * @param thread counter slot in info
+ * @return number of moves of the shortest mate, 0 if none was found
+ */
+int MateSearch::search(const type::gameState_t& root, const int moves, const unsigned int thread) {
+  this->threadID = thread;
+  this->aborted = false;
+  this->nodes = 0;
+  this->pv.clear();
+
+  // the attacker moves on every even ply, the last one delivers the mate
+  const int maxMoves = std::max(std::min(moves, (0xFF - 1) / 2), 0);
+  this->plies.resize(static_cast<size_t>(2 * maxMoves + 1));
+
+  for (int mateIn = 1; mateIn <= maxMoves; mateIn++) {
+    const int depth = 2 * mateIn - 1;
+
+    this->plies[0].position = root;
+    this->mid(0, INFINITE, INFINITE, depth);
+    if (this->aborted) {
+      return 0;
+    }
+
+    uint32_t pn = 1;
+    uint32_t dn = 1;
+    if (this->lookup(::utils::gameState::zobristHash(root), depth, pn, dn) && pn == 0) {
+      return this->extractPV(depth) ? mateIn : 0;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Generate the children of a ply. The attacker only gets moves that give
+ * check, the defender gets every legal move.
+ * @param ply int
+ */
+void MateSearch::generateChildren(const int ply) {
+  auto& node = this->plies[ply];
+  const bool attacker = ply % 2 == 0;
+
+  MoveGen gen{node.position};
+  const uint16_t len = gen.generateGameStates(node.children, 0, constant::MAXMOVES - 1, node.moves.data());
+
+  uint16_t kept = 0;
+  for (uint16_t i = 0; i < len; i++) {
+    if (attacker && !MoveGen{node.children[i]}.isInCheck()) {
+      continue;
+    }
+
+    if (kept != i) {
+      node.children[kept] = node.children[i];
+      node.moves[kept] = node.moves[i];
+    }
+    node.keys[kept] = ::utils::gameState::zobristHash(node.children[kept]);
+    kept += 1;
+  }
+
+  node.nrOfChildren = kept;
+}
+
+/**
+ * Multiple iterative deepening, expands the most proving child until the
+ * proof or disproof number of the node reaches its threshold.
+ *
+ * @param ply distance from the root, even plies are attacker nodes
+ * @param thpn proof number threshold
+ * @param thdn disproof number threshold
+ * @param depth plies left for the attacker to mate in
+ */
+void MateSearch::mid(const int ply, const uint32_t thpn, const uint32_t thdn, const int depth) {
+  auto& node = this->plies[ply];
+  const bool attacker = ply % 2 == 0;
+  const uint64_t key = ::utils::gameState::zobristHash(node.position);
+
+  this->info.addNode(this->threadID);
+  this->info.updateSelectiveDepth(this->threadID, ply);
+  if ((++this->nodes & STOP_POLL_MASK) == 0) {
+    this->aborted = this->control.stopped();
+    this->info.report();
+  }
+  if (this->aborted) {
+    return;
+  }
+
+  this->generateChildren(ply);
+
+  //
+  // Terminal nodes. An attacker without checks can't mate, a defender
+  // without moves is mated if it's in check and stalemated otherwise.
+  //
+  if (node.nrOfChildren == 0) {
+    const bool mated = !attacker && MoveGen{node.position}.isInCheck();
+    this->store(key, depth, mated ? 0 : INFINITE, mated ? INFINITE : 0);
+    return;
+  }
+
+  // the defender survived, and the attacker has no plies left
+  if (depth <= 0) {
+    this->store(key, depth, INFINITE, 0);
+    return;
+  }
+
+  while (true) {
+    //
+    // The attacker needs one proven child, the defender needs all of them.
+    // Children that haven't been searched yet count as 1.
+    //
+    uint32_t pn = attacker ? INFINITE : 0;
+    uint32_t dn = attacker ? 0 : INFINITE;
+    uint32_t best = INFINITE;
+    uint32_t secondBest = INFINITE;
+    uint16_t bestChild = 0;
+    uint32_t bestPn = 1;
+    uint32_t bestDn = 1;
+
+    for (uint16_t i = 0; i < node.nrOfChildren; i++) {
+      uint32_t cpn = 1;
+      uint32_t cdn = 1;
+      this->lookup(node.keys[i], depth - 1, cpn, cdn);
+
+      // the attacker follows the smallest proof number, the defender the smallest disproof number
+      const uint32_t value = attacker ? cpn : cdn;
+      if (value < best) {
+        secondBest = best;
+        best = value;
+        bestChild = i;
+        bestPn = cpn;
+        bestDn = cdn;
+      }
+      else if (value < secondBest) {
+        secondBest = value;
+      }
+
+      if (attacker) {
+        pn = std::min(pn, cpn);
+        dn = saturatedAdd(dn, cdn);
+      }
+      else {
+        pn = saturatedAdd(pn, cpn);
+        dn = std::min(dn, cdn);
+      }
+    }
+
+    if (pn >= thpn || dn >= thdn) {
+      this->store(key, depth, pn, dn);
+      return;
+    }
+
+    uint32_t childThpn;
+    uint32_t childThdn;
+    if (attacker) {
+      childThpn = std::min(thpn, saturatedAdd(secondBest, 1));
+      childThdn = saturatedAdd(thdn - dn, bestDn);
+    }
+    else {
+      childThpn = saturatedAdd(thpn - pn, bestPn);
+      childThdn = std::min(thdn, saturatedAdd(secondBest, 1));
+    }
+
+    this->plies[ply + 1].position = node.children[bestChild];
+    this->mid(ply + 1, childThpn, childThdn, depth - 1);
+
+    if (this->aborted) {
+      return;
+    }
+  }
+}
+
+/**
+ * Follow the proof from the root to the mate. A proven attacker node has a
+ * proven child, and every child of a proven defender node is proven. Parts
+ * of the proof that were replaced in the table are simply proven again.
+ *
+ * @param depth plies of the mate
+ * @return true if the whole line was found
+ */
+bool MateSearch::extractPV(const int depth) {
+  for (int ply = 0; ply <= depth; ply++) {
+    const int left = depth - ply;
+
+    // makes sure the children of this ply are in the table
+    this->mid(ply, INFINITE, INFINITE, left);
+    if (this->aborted) {
+      return false;
+    }
+
+    const auto& node = this->plies[ply];
+    if (node.nrOfChildren == 0) {
+      // the defender is mated
+      return ply % 2 == 1;
+    }
+
+    bool found = false;
+    for (uint16_t i = 0; i < node.nrOfChildren && !found; i++) {
+      uint32_t cpn = 1;
+      uint32_t cdn = 1;
+      if (this->lookup(node.keys[i], left - 1, cpn, cdn) && cpn == 0) {
+        this->pv.push_back(node.moves[i]);
+        this->plies[ply + 1].position = node.children[i];
+        found = true;
+      }
+    }
+
+    if (!found) {
+      return false;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @param key zobrist hash
+ * @param depth plies left
+ * @param pn set to the stored proof number
+ * @param dn set to the stored disproof number
+ * @return true if the position was found
+ */
+bool MateSearch::lookup(const uint64_t key, const int depth, uint32_t& pn, uint32_t& dn) const {
+  const auto& entry = this->table[this->slot(key, depth)];
+  if (entry.key != key || entry.depth != depth) {
+    return false;
+  }
+
+  pn = entry.pn;
+  dn = entry.dn;
+  return true;
+}
+
+void MateSearch::store(const uint64_t key, const int depth, const uint32_t pn, const uint32_t dn) {
+  auto& entry = this->table[this->slot(key, depth)];
+  entry.key = key;
+  entry.depth = static_cast<uint8_t>(depth);
+  entry.pn = pn;
+  entry.dn = dn;
+}
+
+size_t MateSearch::slot(const uint64_t key, const int depth) const {
+  return (key ^ (static_cast<uint64_t>(depth) * 0x9E3779B97F4A7C15ULL)) & this->mask;
+}
+
+}
@@ -15,7 +15,7 @@ std::array<::david::type::gameState_t, ::david::constant::MAXMOVES * ::david::co
  * Constructor
  * @param gs non-mutable gameState instance
  */
-MoveGen::MoveGen(type::gameState_t& gs)
+MoveGen::MoveGen(const type::gameState_t& gs)
     : state(gs)
 //, xRayRookPaths(0ULL)
 //, xRayDiagonalPaths(0ULL)
@@ -59,7 +59,7 @@ MoveGen::MoveGen(type::gameState_t& gs)
   //this->hostileAttackPaths_queen = this->generateXRay_queen(this->state.piecesArr[5][0]);
 }
 
-void MoveGen::setGameState(type::gameState_t& gs)
+void MoveGen::setGameState(const type::gameState_t& gs)
 {
   this->state = gs;
   this->index_moves = {{0}};
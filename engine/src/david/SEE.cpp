@@ -0,0 +1,266 @@
+#include "david/SEE.h"
+#include "david/utils/utils.h"
+
+#include <algorithm>
+#include <array>
+
+namespace david {
+namespace see {
+
+namespace {
+
+// ray directions as file and rank steps, the file index grows towards the a file.
+// Rays that walk to higher square indexes come first, their nearest blocker is the LSB.
+constexpr int DIRECTIONS = 8;
+constexpr int FILE_STEPS[DIRECTIONS] = {0, 1, 1, -1, 0, -1, -1, 1};
+constexpr int RANK_STEPS[DIRECTIONS] = {1, 0, 1, 1, -1, 0, -1, -1};
+constexpr int FIRST_DECREASING = 4;
+
+// orthogonal and diagonal directions
+constexpr bool ORTHOGONAL[DIRECTIONS] = {true, true, false, false, true, true, false, false};
+
+using rays_t = std::array<std::array<type::bitboard_t, 64>, DIRECTIONS>;
+
+constexpr rays_t compileRays() {
+  rays_t rays{};
+
+  for (int d = 0; d < DIRECTIONS; d++) {
+    for (int square = 0; square < 64; square++) {
+      type::bitboard_t ray = 0;
+      int file = square % 8 + FILE_STEPS[d];
+      int rank = square / 8 + RANK_STEPS[d];
+      while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+        ray |= 1ULL << (rank * 8 + file);
+        file += FILE_STEPS[d];
+        rank += RANK_STEPS[d];
+      }
+      rays[d][square] = ray;
+    }
+  }
+
+  return rays;
+}
+
+const rays_t RAYS = compileRays();
+
+using steps_t = std::array<type::bitboard_t, 64>;
+
+/**
+ * Squares one step away from every square, in the orthogonal or the
+ * diagonal directions or both.
+ */
+constexpr steps_t compileSteps(const bool orthogonal, const bool diagonal) {
+  steps_t steps{};
+
+  for (int d = 0; d < DIRECTIONS; d++) {
+    if ((ORTHOGONAL[d] && !orthogonal) || (!ORTHOGONAL[d] && !diagonal)) {
+      continue;
+    }
+
+    for (int square = 0; square < 64; square++) {
+      const int file = square % 8 + FILE_STEPS[d];
+      const int rank = square / 8 + RANK_STEPS[d];
+      if (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+        steps[square] |= 1ULL << (rank * 8 + file);
+      }
+    }
+  }
+
+  return steps;
+}
+
+const steps_t KING_STEPS = compileSteps(true, true);
+const steps_t DIAGONAL_STEPS = compileSteps(false, true);
+
+/**
+ * Squares a slider reaches from a square, up to and including the first
+ * occupied square of every ray.
+ */
+type::bitboard_t sliderAttacks(const uint8_t square, const type::bitboard_t occupied, const bool orthogonal) {
+  type::bitboard_t attacks = 0;
+
+  for (int d = 0; d < DIRECTIONS; d++) {
+    if (ORTHOGONAL[d] != orthogonal) {
+      continue;
+    }
+
+    const auto ray = RAYS[d][square];
+    const auto blockers = ray & occupied;
+    if (blockers == 0) {
+      attacks |= ray;
+      continue;
+    }
+
+    const auto nearest = d < FIRST_DECREASING ? ::utils::LSB(blockers) : ::utils::MSB(blockers);
+    attacks |= ray ^ RAYS[d][nearest];
+  }
+
+  return attacks;
+}
+
+
+/**
+ * Type of the piece of a colour on a square, -1 if it has none there.
+ */
+int pieceOn(const type::gameState_t& gs, const int colour, const type::bitboard_t square) {
+  for (int type = 0; type < 6; type++) {
+    if ((gs.piecesArr[type][colour] & square) != 0) {
+      return type;
+    }
+  }
+
+  return -1;
+}
+
+} // anonymous namespace
+
+type::bitboard_t attackersTo(const type::gameState_t& gs, const uint8_t square, const type::bitboard_t occupied) {
+  const auto& pieces = gs.piecesArr;
+  const auto below = (1ULL << square) - 1;
+  const auto diagonalSteps = DIAGONAL_STEPS[square];
+
+  // pawns of the active colour move up if it's white, so a white pawn attacks from below
+  const auto whitePawns = pieces[0][gs.isWhite ? 0 : 1];
+  const auto blackPawns = pieces[0][gs.isWhite ? 1 : 0];
+
+  const auto rooks = pieces[1][0] | pieces[1][1] | pieces[4][0] | pieces[4][1];
+  const auto bishops = pieces[3][0] | pieces[3][1] | pieces[4][0] | pieces[4][1];
+
+  type::bitboard_t attackers = 0;
+  attackers |= diagonalSteps & below & whitePawns;
+  attackers |= diagonalSteps & ~below & blackPawns;
+  attackers |= ::utils::constant::knightAttackPaths[square] & (pieces[2][0] | pieces[2][1]);
+  attackers |= KING_STEPS[square] & (pieces[5][0] | pieces[5][1]);
+  attackers |= sliderAttacks(square, occupied, true) & rooks;
+  attackers |= sliderAttacks(square, occupied, false) & bishops;
+
+  return attackers & occupied;
+}
+
+type::bitboard_t attacksBy(const type::gameState_t& gs, const unsigned int pieceType, const unsigned int colour) {
+  const auto occupied = gs.piecess[0] | gs.piecess[1];
+
+  // white pawns attack up
+  const bool white = (colour == 0) == gs.isWhite;
+
+  type::bitboard_t attacks = 0;
+  type::bitboard_t pieces = gs.piecesArr[pieceType][colour];
+  while (pieces != 0) {
+    const uint8_t square = ::utils::LSB(pieces);
+    pieces &= pieces - 1;
+
+    switch (pieceType) {
+      case 0: {
+        const auto below = (1ULL << square) - 1;
+        attacks |= DIAGONAL_STEPS[square] & (white ? ~below : below);
+        break;
+      }
+      case 1:
+        attacks |= sliderAttacks(square, occupied, true);
+        break;
+      case 2:
+        attacks |= ::utils::constant::knightAttackPaths[square];
+        break;
+      case 3:
+        attacks |= sliderAttacks(square, occupied, false);
+        break;
+      case 4:
+        attacks |= sliderAttacks(square, occupied, true) | sliderAttacks(square, occupied, false);
+        break;
+      default:
+        attacks |= KING_STEPS[square];
+        break;
+    }
+  }
+
+  return attacks;
+}
+
+bool isCapture(const type::gameState_t& gs, const type::move_t move) {
+  const uint8_t from = move & 63;
+  const uint8_t to = (move >> 6) & 63;
+
+  if ((gs.piecess[1] & (1ULL << to)) != 0) {
+    return true;
+  }
+
+  return gs.enPassant > 15 && to == gs.enPassant && (gs.piecesArr[0][0] & (1ULL << from)) != 0;
+}
+
+int evaluate(const type::gameState_t& gs, const type::move_t move) {
+  const uint8_t from = move & 63;
+  const uint8_t to = (move >> 6) & 63;
+  const int promotion = (move >> 12) & 7;
+  const auto toBoard = 1ULL << to;
+
+  type::bitboard_t occupied = gs.piecess[0] | gs.piecess[1];
+  const int moving = pieceOn(gs, 0, 1ULL << from);
+  if (moving < 0) {
+    return 0;
+  }
+
+  // material taken by the move itself
+  int captured = pieceOn(gs, 1, toBoard);
+  if (captured < 0 && moving == 0 && gs.enPassant > 15 && to == gs.enPassant) {
+    captured = 0;
+    occupied &= ~(1ULL << gs.enPassantPawn);
+  }
+
+  // gain[d] is what the colour taking at step d has won if the exchange ends there
+  std::array<int, 32> gain{};
+  gain[0] = captured < 0 ? 0 : value(captured);
+
+  // the piece standing on the square, and the next to be taken
+  int onSquare = moving;
+  if (promotion != 0) {
+    gain[0] += value(promotion) - value(0);
+    onSquare = promotion;
+  }
+
+  occupied &= ~(1ULL << from);
+  auto attackers = attackersTo(gs, to, occupied);
+
+  int d = 0;
+  int colour = 1;
+  while (d < static_cast<int>(gain.size()) - 1) {
+    const auto own = attackers & gs.piecess[colour];
+    if (own == 0) {
+      break;
+    }
+
+    // least valuable attacker
+    int type = 0;
+    type::bitboard_t attacker = 0;
+    for (; type < 6; type++) {
+      attacker = own & gs.piecesArr[type][colour];
+      if (attacker != 0) {
+        break;
+      }
+    }
+
+    // a king only takes when the square isn't defended anymore
+    if (type == 5 && (attackers & gs.piecess[colour ^ 1]) != 0) {
+      break;
+    }
+
+    d++;
+    gain[d] = value(onSquare) - gain[d - 1];
+    onSquare = type;
+
+    // sliders behind the attacker can now see the square
+    occupied &= ~(1ULL << ::utils::LSB(attacker));
+    attackers = attackersTo(gs, to, occupied);
+    colour ^= 1;
+  }
+
+  // either colour may stop taking when it would lose by continuing
+  while (d > 0) {
+    gain[d - 1] = -std::max(-gain[d - 1], gain[d]);
+    d--;
+  }
+
+  return gain[0];
+}
+
+}
+}
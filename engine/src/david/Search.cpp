@@ -1,13 +1,53 @@
 #include "david/Search.h"
 #include "david/utils/utils.h"
-#include <ctime>
+#include "david/MoveGen.h"
+#include "david/SEE.h"
 #include <david/EngineMaster.h>
 #include <fstream>
 #include "../../spike/EngineContext.h"
 
 namespace david {
 //Signals Signal; //Scrapped for now
-//clock_t startTime; // moved to a class member
+
+namespace {
+/**
+ * Move a window bound without overflowing past the lowest or highest board score.
+ */
+inline int widen(const int bound, const int delta) {
+  const int64_t widened = static_cast<int64_t>(bound) + delta;
+  return static_cast<int>(std::max<int64_t>(std::min<int64_t>(widened, constant::boardScore::HIGHEST),
+                                            constant::boardScore::LOWEST));
+}
+
+/**
+ * Score of a tablebase result, wins closer to the root are better.
+ * Wins and losses saved by the fifty move rule are scored next to a draw.
+ */
+inline int tablebaseScore(const int wdl, const int ply) {
+  if (wdl == Syzygy::WIN) {
+    return constant::boardScore::TABLEBASE_WIN - ply;
+  }
+  if (wdl == Syzygy::LOSS) {
+    return -constant::boardScore::TABLEBASE_WIN + ply;
+  }
+
+  return wdl;
+}
+
+/**
+ * Material of the active colour minus the material of the opponent, kings
+ * not counted.
+ */
+inline int materialBalance(const type::gameState_t& node) {
+  int balance = 0;
+  for (unsigned int type = 0; type < 5; type++) {
+    balance += see::value(type) * (::utils::nrOfActiveBits(node.piecesArr[type][0])
+                                   - ::utils::nrOfActiveBits(node.piecesArr[type][1]));
+  }
+
+  return balance;
+}
+}
 
 
 /**
@@ -15,12 +55,55 @@ namespace david {
  */
 Search::Search(type::TreeGen_t& tg)
     : treeGen(tg),
-      depth(3),
+      threadID(0),
+      stack(tg.getNeuralNetwork(), tt),
+      mateSearch(control, info),
+      syzygyProbeLimit(Syzygy::MAX_PIECES),
+      rootInTablebase(false),
+      rootTablebaseScore(0),
       uciMode(false),
-      isAborted(false),
+      depth(3),
+      movestogo(0),
+      movetime(1000),
+      timeUsed(0),
+      mate(0),
+      infinite(false),
+      ponder(false),
+      pondering(false),
+      ponderHitPending(false),
+      wtime(0),
+      btime(0),
+      winc(0),
+      binc(0),
+      stopPollInterval(64),
+      nodesUntilStopPoll(0),
+      stopping(false),
       isComplete(false),
-      movetime(1000)
-{}
+      nullMovePruning(true),
+      nullMoveReduction(2),
+      nullMoveMinDepth(3),
+      lateMoveReductions(true),
+      lmrMinDepth(3),
+      lmrMinMoveIndex(4),
+      lmrHistoryThreshold(0),
+      quiescenceSearch(true),
+      seePruning(true),
+      seePruningDepth(2),
+      seeQuietMargin(60),
+      lazyEvaluation(false),
+      lazyEvalMargin(0),
+      aspirationWindow(25),
+      aspirationMinDepth(4),
+      aspirationFailHighs(0),
+      aspirationFailLows(0),
+      multiPV(1)
+{
+  this->info.setHashfullProvider([this]() -> int {
+    return this->tt.hashfull();
+  });
+  this->stack.setStats(&this->stats);
+  this->stack.setHistory(&this->history);
+}
 
 void Search::uciSearchWaiter() {
   this->searchThread = std::thread([&](){
@@ -67,122 +150,155 @@ int Search::getSearchResult() {
  * @return
  */
 int Search::iterativeDeepening() {
-  int alpha = constant::boardScore::LOWEST;
-  int beta = constant::boardScore::HIGHEST;
-  int iterationScore[1000];
-  //int lastDepth = 0;
-  int aspirationDepth = 4;
   int bScore = constant::boardScore::LOWEST;
 
   this->resetSearchValues();
 
-  startTime = clock();              //Starting clock
+  //
+  // Start the clock for the active colour. Infinite searches are only stopped by the GUI.
+  //
+  // A ponder search runs like an infinite one, until ponderhit gives it a clock.
+  //
+  const bool whiteToMove = this->treeGen.getGameState(0).isWhite;
+  this->pondering = this->ponder;
+  if (this->infinite) {
+    this->timeManager.start(0, 0, 0, 0);
+  }
+  else {
+    this->timeManager.start(whiteToMove ? this->wtime : this->btime,
+                            whiteToMove ? this->winc : this->binc,
+                            this->movestogo,
+                            this->movetime);
+  }
+
+  // the timer thread raises the stop flag at the hard deadline, so negamax only has to poll a flag
+  if (this->timeManager.hasTimeLimit() && !this->pondering) {
+    this->control.startTimer(this->timeManager.getHardDeadline());
+  }
 
 
   //
   // Create move tree
   //
-  this->treeGen.generateChildren(0);
+  // The root children are kept between searches as long as the root is unchanged.
+  if (!this->treeGen.hasGeneratedChildren(0)) {
+    this->treeGen.generateChildren(0);
+  }
   auto nrOfPossibleMoves = this->treeGen.getGameState(0).possibleSubMoves;
+  this->stack.setPosition(0, this->treeGen.getGameState(0));
+  const int maxDepth = std::min(this->depth, this->stack.getMaxDepth());
+
+  // the root children are already sorted, which is a good first guess
+  this->rootMoves.clear();
+  for (unsigned int index = 1; index <= nrOfPossibleMoves; index++) {
+    this->rootMoves.push_back(RootMove{index, constant::boardScore::LOWEST, constant::boardScore::LOWEST, {}});
+  }
+
+  // in the tablebases only the moves keeping the best outcome are searched
+  this->rootInTablebase = this->probeRootTablebase();
+  const size_t lines = std::min(static_cast<size_t>(this->multiPV), this->rootMoves.size());
+
+  //
+  // go mate N, a proven mate can't be improved on by the main search
+  //
+  const bool mateFound = this->mate > 0 && this->searchMate();
+  if (mateFound) {
+    bScore = constant::boardScore::HIGHEST;
+    this->bestMoveIndex = this->rootMoves[0].index;
+  }
 
   //
   // Iterate down in the search tree for each search tree
   //
-  time_t initTimer = std::time(nullptr);
-  auto timeout = (initTimer * 1000) + movetime;
   for (
       int currentDepth = 1;
 
-      // Continue until max depth or timeout has been reached
-      (currentDepth <= this->depth && timeout > (std::time(nullptr) * 1000)) ||
+      !mateFound && (
+      // The first iteration always completes, so there's a move to play.
+      currentDepth == 1 ||
+      // Continue until max depth or the soft time limit has been reached
+      (currentDepth <= maxDepth && !this->timeManager.softLimitReached()) ||
           // Continue forever, or until max depth has been reached.
-      (this->infinite && currentDepth < ::david::constant::MAXDEPTH);
+      (this->infinite && currentDepth <= this->stack.getMaxDepth()) ||
+          // Pondering ignores the clock, it's not running yet.
+      (this->pondering && currentDepth <= this->stack.getMaxDepth()));
 
       currentDepth++) {
 
-    int aspirationDelta = 0;
+    this->checkPonderHit();
+    this->info.setDepth(currentDepth);
 
     //
     // If the UCI command "stop" is sent, the best move should be returned.
     //
-    if (this->isAborted.load()) {
+    if (this->control.stopped()) {
       break;
     }
 
-    //
-    // Aspiration window, used to limit alpha beta window, which will increase cut-offs
-    //
-    // Reset aspiration window starting size
-    // TODO: aspiration windows causes SLOWER searching. depth 5 takes several seconds...
-    if (currentDepth > 17) {
-      const int delta = iterationScore[currentDepth - 1] - iterationScore[currentDepth - 2];
-      aspirationDelta = std::max(delta, 10) + 5;
-      alpha = std::max(iterationScore[currentDepth - 1] - aspirationDelta, constant::boardScore::LOWEST);
-      beta = std::min(iterationScore[currentDepth - 1] + aspirationDelta, constant::boardScore::HIGHEST);
+    // an interrupted iteration falls back to this
+    const auto lastIteration = this->rootMoves;
+    for (auto& rootMove : this->rootMoves) {
+      rootMove.previousScore = rootMove.score;
     }
 
+    //
+    // Every line searches the root moves not already reported by an earlier
+    // line, so line k is the best move when the k-1 better ones are excluded.
+    // The move lists and best moves in the transposition table make the later
+    // lines cheap, most of their moves fail low right away.
+    //
+    bool completed = true;
+    bool improved = false;
+    for (size_t pvIndex = 0; pvIndex < lines && completed; pvIndex++) {
+      completed = this->searchRootLine(pvIndex, currentDepth, improved);
 
-    // find which possibility is the best option
-    //int leafScore = constant::boardScore::LOWEST;
-    //int childIndex = 0;
-    for (int index = 1; index <= nrOfPossibleMoves; index += 1) {
-      // Since every child is gone through, we need to verify that uci stop command
-      // has not been issued (!)
-      if (this->isAborted.load()) {
-        break;
+      //
+      // An interrupted iteration is only trusted if its best move beat the
+      // lower bound of the window, otherwise the last complete iteration wins.
+      //
+      if (!completed && pvIndex == 0 && !improved) {
+        this->rootMoves = lastIteration;
       }
+    }
 
-      // Start with a small aspiration window and, in the case of a fail
-      // high/low, re-search with a bigger window until we're not failing
-      // high/low anymore.
-      bool iDone = false;
-      while (!iDone) {
-
-        if (this->isAborted.load()) {
-          break;
-        }
-
-        int cScore = negamax(index, alpha, beta, 1, currentDepth);
-        iterationScore[currentDepth] = cScore;
-
-        //
-        // Update best score / move in case of a abort
-        //
-        if (cScore > bScore) {
-          bScore = cScore;
-          //leafScore = this->bestLeafScore;
-          //std::cout << cScore << std::endl;
-          this->bestMoveIndex = index;
-        }
-
-        if (this->isAborted.load()) {
-          break;
-        }
-
-        const bool fail       = bScore <= alpha || bScore >= beta;
-        const bool fullWidth  = alpha == constant::boardScore::LOWEST && beta == constant::boardScore::HIGHEST;
-        iDone = !fail || fullWidth || currentDepth < aspirationDepth;
-
-        if (!iDone) {
-          alpha = std::max(alpha - aspirationDelta, constant::boardScore::LOWEST);
-          beta = std::min(beta + aspirationDelta, constant::boardScore::HIGHEST);
-          aspirationDelta = std::max(aspirationDelta * 130 / 100, 15);
-        }
-      }
+    if (!this->rootMoves.empty()) {
+      bScore = this->rootMoves[0].score;
+      this->bestMoveIndex = this->rootMoves[0].index;
+    }
+
+    if (!completed) {
+      break;
     }
 
-    // store time used
-    this->timeUsed = static_cast<int>((std::time(nullptr) * 1000) - initTimer);
+    // store time used, and let the time manager scale the budget from how this iteration went
+    this->timeUsed = this->timeManager.elapsed();
+    DAVID_STATS(this->stats.iterationComplete(currentDepth, this->timeUsed));
+    this->timeManager.iterationComplete(this->bestMoveIndex, bScore);
 
     //lastDepth = currentDepth; // not accurate enough
 
-    // uci info updates
-    std::cout
-        << "info "
-        << "depth " << currentDepth << " "
-        << "nodes " << this->nodesSearched << " "
-        << std::endl
-        << std::flush;
+    // uci info updates, one line per principal variation. the tablebase outcome beats any search score
+    for (size_t pvIndex = 0; pvIndex < lines; pvIndex++) {
+      const int score = this->rootInTablebase ? this->rootTablebaseScore : this->rootMoves[pvIndex].score;
+      this->info.reportLine(static_cast<int>(pvIndex + 1), score, this->getPV(this->rootMoves[pvIndex]));
+    }
+  }
+
+  // stopped before the first iteration, the sorted root children are still a decent guess
+  if (this->bestMoveIndex <= 0 && !this->rootMoves.empty()) {
+    this->bestMoveIndex = this->rootMoves[0].index;
+  }
+
+  // the last info line is always sent, so the GUI gets the final numbers
+  this->info.report(true);
+  DAVID_STATS(this->stats.setTranspositionTable(this->tt.getProbes(), this->tt.getHits()));
+  DAVID_STATS(this->stats.setAspiration(this->aspirationFailHighs, this->aspirationFailLows));
+  DAVID_STATS(std::cout << "info string stats " << this->stats.toJSON() << std::endl);
+
+  // a ponder search must not return before ponderhit or stop, even if it ran out of depth
+  while (this->pondering && !this->control.stopped()) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    this->checkPonderHit();
   }
 
   // uci response
@@ -193,15 +309,314 @@ int Search::iterativeDeepening() {
 //  std::cout
 //      << "bestmove " << EGN;
 
+  this->control.stopTimer();
   this->searchScore = bScore;
 
+  // keep the expected line in the tree, so it can be reused when the opponent replies
+  if (this->bestMoveIndex > 0) {
+    this->treeGen.generatePredictedLine(this->bestMoveIndex);
+  }
+
   setComplete(true);
 
   return this->bestMoveIndex;
 }
 
+/**
+ * Search one line of the root, the root moves from pvIndex and on, inside an
+ * aspiration window around the score the line had in the last iteration.
+ * A fail low or fail high widens the failing side and searches the moves
+ * again. The moves from pvIndex are sorted by their new score afterwards.
+ *
+ * @param pvIndex number of better lines that are excluded
+ * @param iterativeDepthLimit depth of this iteration
+ * @param improved set if a move beat the window before the search was stopped
+ * @return false if the search was stopped before the line completed
+ */
+bool Search::searchRootLine(const size_t pvIndex, const int iterativeDepthLimit, bool& improved) {
+  const int previousScore = this->rootMoves[pvIndex].previousScore;
+  const auto first = this->rootMoves.begin() + pvIndex;
+  const auto byScore = [](const RootMove& a, const RootMove& b) -> bool {
+    return a.score > b.score;
+  };
+
+  //
+  // Aspiration window, a narrow window around the score of the last
+  // iteration. Most root moves then fail low quickly. If the best score
+  // falls outside the window the whole root is searched again with the
+  // window widened on the failing side.
+  //
+  int delta = this->aspirationWindow;
+  int alpha = constant::boardScore::LOWEST;
+  int beta = constant::boardScore::HIGHEST;
+  if (delta > 0 && iterativeDepthLimit >= this->aspirationMinDepth && previousScore > constant::boardScore::LOWEST) {
+    alpha = widen(previousScore, -delta);
+    beta = widen(previousScore, delta);
+  }
+
+  improved = false;
+  while (true) {
+    // the moves are sorted best first, so alpha is raised as early as possible
+    for (auto it = first; it != this->rootMoves.end(); ++it) {
+      it->score = constant::boardScore::LOWEST;
+    }
+
+    int windowAlpha = alpha;
+    int bestScore = constant::boardScore::LOWEST;
+    for (auto it = first; it != this->rootMoves.end(); ++it) {
+      // Since every child is gone through, we need to verify that uci stop command
+      // has not been issued (!)
+      if (this->control.stopped()) {
+        break;
+      }
+
+      this->info.setCurrentMove(
+          ::utils::gameState::getEGN(this->treeGen.getGameState(0), this->treeGen.getGameState(it->index)),
+          static_cast<int>(it - this->rootMoves.begin()) + 1);
+
+      // the root children are kept in the tree, the search continues from ply 1 of the stack.
+      // the child is scored from the opponent's side, like every other negamax call.
+      this->stack.setPosition(1, this->treeGen.getGameState(it->index));
+      const int cScore = -negamax(1, -beta, -windowAlpha, 1, iterativeDepthLimit);
+
+      if (this->stopping) {
+        break;
+      }
+
+      // only the first move and moves that raise alpha have a usable score and line
+      if (it == first || cScore > windowAlpha) {
+        it->score = cScore;
+        it->pv = this->stack.getPV(1);
+        improved = improved || cScore > alpha;
+      }
+
+      bestScore = std::max(bestScore, cScore);
+      windowAlpha = std::max(windowAlpha, cScore);
+      if (windowAlpha >= beta) {
+        break;
+      }
+    }
+
+    // a stable sort keeps the order of the moves that failed low
+    std::stable_sort(first, this->rootMoves.end(), byScore);
+
+    if (this->stopping || this->control.stopped()) {
+      return false;
+    }
+
+    if (bestScore <= alpha && alpha > constant::boardScore::LOWEST) {
+      // fail low, nothing reached the window. the old best move may still be the best
+      this->aspirationFailLows += 1;
+      alpha = widen(alpha, -delta);
+    }
+    else if (bestScore >= beta && beta < constant::boardScore::HIGHEST) {
+      // fail high, the move that failed high is now in front for the re-search
+      this->aspirationFailHighs += 1;
+      beta = widen(beta, delta);
+    }
+    else {
+      return true;
+    }
+
+    delta += delta / 2 + 1;
+  }
+}
+
+/**
+ * Run the mate search for "go mate N", and put the mating move in front of
+ * the root moves if a mate was found.
+ *
+ * @return true if the side to move mates in at most N moves
+ */
+bool Search::searchMate() {
+  const auto& root = this->treeGen.getGameState(0);
+  const int moves = this->mateSearch.search(root, this->mate, this->threadID);
+  if (moves == 0) {
+    return false;
+  }
+
+  const auto& pv = this->mateSearch.getPV();
+  type::gameState_t parent = root;
+  type::gameState_t child;
+  MoveGen gen{parent};
+  gen.applyMove(pv[0], child);
+
+  for (auto it = this->rootMoves.begin(); it != this->rootMoves.end(); ++it) {
+    if (!::utils::gameState::samePosition(child, this->treeGen.getGameState(it->index))) {
+      continue;
+    }
+
+    it->score = constant::boardScore::HIGHEST;
+    it->pv.assign(pv.begin() + 1, pv.end());
+    std::rotate(this->rootMoves.begin(), it, it + 1);
+
+    this->info.setDepth(2 * moves - 1);
+    this->info.reportMate(moves, this->getPV(this->rootMoves[0]));
+    return true;
+  }
+
+  return false;
+}
+
+/**
+ * Rank the root moves with the endgame tablebases, and drop every move that
+ * is worse than the best one. Wins go for the shortest distance to zeroing
+ * and losses for the longest, so the game makes progress even though the
+ * search can't see the fifty move rule. Without dtz files the moves are
+ * only ranked by win, draw or loss.
+ *
+ * @return true if the root position was found in the tablebases
+ */
+bool Search::probeRootTablebase() {
+  const auto& root = this->treeGen.getGameState(0);
+  if (this->rootMoves.empty()
+      || Syzygy::nrOfPieces(root) > this->syzygyProbeLimit
+      || !this->syzygy.canProbe(root)) {
+    return false;
+  }
+
+  // wins above cursed wins above draws, and so on
+  constexpr int MAX_DTZ = 1 << 18;
+  const auto rankDTZ = [](const int dtz) -> int {
+    if (dtz > 0) {
+      return (dtz <= 100 ? MAX_DTZ : MAX_DTZ / 2) - dtz;
+    }
+    if (dtz < 0) {
+      return (dtz >= -100 ? -MAX_DTZ : -MAX_DTZ / 2) - dtz;
+    }
+    return 0;
+  };
+
+  std::vector<int> ranks;
+  int bestWDL = Syzygy::LOSS;
+  int bestDTZ = 0;
+  bool dtzFound = true;
+  for (const auto& rootMove : this->rootMoves) {
+    int dtz = 0;
+    if (!this->syzygy.probeMove(root, this->treeGen.getGameState(rootMove.index), dtz)) {
+      dtzFound = false;
+      break;
+    }
+
+    ranks.push_back(rankDTZ(dtz));
+    if (ranks.size() == 1 || ranks.back() > rankDTZ(bestDTZ)) {
+      bestDTZ = dtz;
+    }
+  }
+
+  if (dtzFound) {
+    bestWDL = bestDTZ > 0 ? (bestDTZ <= 100 ? Syzygy::WIN : Syzygy::CURSED_WIN)
+        : bestDTZ < 0 ? (bestDTZ >= -100 ? Syzygy::LOSS : Syzygy::BLESSED_LOSS)
+        : Syzygy::DRAW;
+  }
+  else {
+    ranks.clear();
+    for (const auto& rootMove : this->rootMoves) {
+      int wdl = Syzygy::DRAW;
+      if (!this->syzygy.probeWDL(this->treeGen.getGameState(rootMove.index), wdl)) {
+        return false;
+      }
+
+      ranks.push_back(-wdl);
+      bestWDL = std::max(bestWDL, -wdl);
+    }
+  }
+
+  const int bestRank = *std::max_element(ranks.begin(), ranks.end());
+  std::vector<RootMove> kept;
+  for (size_t i = 0; i < this->rootMoves.size(); i++) {
+    if (ranks[i] == bestRank) {
+      kept.push_back(this->rootMoves[i]);
+    }
+  }
+
+  for (size_t i = 0; i < this->rootMoves.size(); i++) {
+    this->info.addTablebaseHit(this->threadID);
+  }
+  this->rootMoves = kept;
+
+  // the distance to zeroing orders wins and losses, it's not a distance to mate
+  this->rootTablebaseScore = tablebaseScore(bestWDL, 0);
+  if (dtzFound && (bestWDL == Syzygy::WIN || bestWDL == Syzygy::LOSS)) {
+    this->rootTablebaseScore -= bestDTZ;
+  }
+
+  return true;
+}
+
+/**
+ * Look a position up in the endgame tablebases. Only done right after a
+ * capture or pawn move, the fifty move counter is then reset so the stored
+ * outcome is exact, and the new material is the one worth looking up.
+ *
+ * @param ply distance from the root
+ * @param node position at ply
+ * @param score set to the tablebase score of the position
+ * @return true if the position was found
+ */
+bool Search::probeTablebase(const int ply, const type::gameState_t& node, int& score) {
+  if (Syzygy::nrOfPieces(node) > this->syzygyProbeLimit || !this->syzygy.canProbe(node)) {
+    return false;
+  }
+
+  const auto& parent = this->stack.getPosition(ply - 1);
+  const bool zeroing = parent.piecess[1] != node.piecess[0]
+      || parent.piecesArr[constant::index::pawn][0] != node.piecesArr[constant::index::pawn][1];
+  int wdl = Syzygy::DRAW;
+  if (!zeroing || !this->syzygy.probeWDL(node, wdl)) {
+    return false;
+  }
+
+  this->info.addTablebaseHit(this->threadID);
+  score = tablebaseScore(wdl, ply);
+  return true;
+}
+
+/**
+ * Principal variation of a root move in long algebraic notation.
+ *
+ * @param rootMove RootMove
+ * @return std::string moves separated by spaces
+ */
+std::string Search::getPV(const RootMove& rootMove) {
+  type::gameState_t parent = this->treeGen.getGameState(rootMove.index);
+  type::gameState_t child;
+  std::string pv = ::utils::gameState::getEGN(this->treeGen.getGameState(0), parent);
+
+  for (const auto move : rootMove.pv) {
+    MoveGen gen{parent};
+    gen.applyMove(move, child);
+    pv += " " + ::utils::gameState::getEGN(parent, child);
+    parent = child;
+  }
+
+  return pv;
+}
+
 bool Search::aborted() {
-  return this->isAborted.load();
+  return this->control.stopped();
+}
+
+/**
+ * Poll the stop flag every stopPollInterval nodes, and remember the answer in between.
+ * Once a stop has been seen, it sticks until the next search.
+ * @return true if the search must unwind
+ */
+inline bool Search::shouldStop() {
+  if (this->stopping) {
+    return true;
+  }
+
+  if (--this->nodesUntilStopPoll <= 0) {
+    this->nodesUntilStopPoll = this->stopPollInterval;
+    this->stopping = this->control.stopped();
+    this->checkPonderHit();
+
+    // periodic uci info, throttled by the info interval
+    this->info.report();
+  }
+
+  return this->stopping;
 }
 
 /**
@@ -210,15 +625,18 @@ bool Search::aborted() {
  * all nodes in the tree is searched trough.
  * Returns best move
  *
+ * Uses null move pruning and late move reductions when enabled, see the
+ * UCI options for tuning.
  *
  * Local int values need to be changed to gamestate pointers instead
  * @param node
  * @param alpha
  * @param beta
  * @param depth
+ * @param nullMoveAllowed false right after a null move, to avoid two passes in a row
  * @return
  */
-int Search::negamax(unsigned int index, int alpha, int beta, int iDepth, int iterativeDepthLimit) {
+int Search::negamax(int ply, int alpha, int beta, int iDepth, int iterativeDepthLimit, bool nullMoveAllowed) {
   int score = constant::boardScore::LOWEST;
   int bestScore = constant::boardScore::LOWEST;
 
@@ -227,37 +645,212 @@ int Search::negamax(unsigned int index, int alpha, int beta, int iDepth, int ite
   // If UCI aborts the search in the middle of a recursive negamax
   // return -infinity
   //
-  if (this->isAborted.load()) {
+  if (this->shouldStop()) {
     return constant::boardScore::LOWEST;
   }
 
+  this->info.addNode(this->threadID);
+  DAVID_STATS(this->stats.addNode(ply));
+
+  auto& node = this->stack.getPosition(ply);
+  this->stack.clearPV(ply);
+
+  //
+  // Endgame tablebases. A position in the tables has a known outcome, so it
+  // isn't searched any further.
+  //
+  if (this->probeTablebase(ply, node, score)) {
+    return score;
+  }
+
   //
-  // Should do a quiescence search after to ensure we are not encountering
-  // a danger move in the next depth in this branch
+  // The quiescence search resolves the captures left at the horizon, so a
+  // position isn't scored in the middle of an exchange.
   //
-  if (iDepth == iterativeDepthLimit) {
-    return this->treeGen.getGameStateScore(index);
+  // Reduced searches can jump past the limit, so this is not an equality check.
+  //
+  if (iDepth >= iterativeDepthLimit) {
+    if (this->quiescenceSearch) {
+      return this->quiescence(ply, alpha, beta);
+    }
+
+    this->info.updateSelectiveDepth(this->threadID, ply);
+    return this->evaluate(ply, alpha, beta);
+  }
+
+  const int remainingDepth = iterativeDepthLimit - iDepth;
+
+  // check detection is only worth the time when a pruning technique might kick in
+  bool inCheck = false;
+  if ((this->nullMovePruning && remainingDepth >= this->nullMoveMinDepth)
+      || (this->lateMoveReductions && remainingDepth >= this->lmrMinDepth)
+      || (this->seePruning && remainingDepth <= this->seePruningDepth)) {
+    inCheck = MoveGen{node}.isInCheck();
+  }
+
+  //
+  // Null move pruning. Let the opponent move twice, if a reduced search
+  // still fails high this node would most likely cause a cut-off anyways.
+  // Never done while in check, or when the active colour only has king
+  // and pawns left since zugzwang is common in those positions.
+  //
+  if (this->nullMovePruning
+      && nullMoveAllowed
+      && !inCheck
+      && remainingDepth >= this->nullMoveMinDepth
+      && beta < constant::boardScore::HIGHEST
+      && this->hasNonPawnMaterial(node)) {
+    const int reduction = this->nullMoveReduction + (remainingDepth > 6 ? 1 : 0);
+    this->stack.makeNullMove(ply);
+
+    score = -negamax(ply + 1, -beta, -beta + 1, iDepth + 1 + reduction, iterativeDepthLimit, false);
+
+    if (this->stopping) {
+      return constant::boardScore::LOWEST;
+    }
+
+    DAVID_STATS(this->stats.addNullMove(score >= beta));
+    if (score >= beta) {
+      return beta;
+    }
   }
 
   // generate children for this board
-  this->treeGen.generateChildren(index);
-  const uint16_t len = static_cast<uint16_t>(this->treeGen.getGameState(index).possibleSubMoves);
+  const uint16_t len = this->stack.generateMoves(ply);
+  uint16_t bestMove = 0;
 
   for (uint16_t i = 0; i < len; i++) { // uint8_t can cause issues if len == 256
-    if (this->isAborted.load()) {
+    if (this->stopping) {
       break;
     }
 
-    score = -negamax(this->treeGen.getChildIndex(/*parent*/index, /*child0..256*/i),
-                     -beta,
-                     -alpha,
-                     iDepth + 1,
-                     iterativeDepthLimit);
+    const auto move = this->stack.getMove(ply, i).move;
+    const auto& child = this->stack.makeMove(ply, i);
+    const bool quiet = this->isQuietMove(node, child);
 
-    this->nodesSearched += 1;
-    bestScore = std::max(score, bestScore);
+    //
+    // SEE pruning. Close to the horizon a quiet move that leaves a piece to
+    // be taken is not worth a search, once another move has been searched.
+    //
+    if (this->seePruning
+        && !inCheck
+        && quiet
+        && i > 0
+        && remainingDepth <= this->seePruningDepth
+        && see::evaluate(node, move) < -this->seeQuietMargin * remainingDepth) {
+      continue;
+    }
+
+    //
+    // Late move reductions. The children are sorted, so quiet moves late in
+    // the list are searched with less depth. Moves with a good history are
+    // reduced less.
+    //
+    int reduction = 0;
+    if (this->lateMoveReductions
+        && !inCheck
+        && quiet
+        && i >= this->lmrMinMoveIndex
+        && remainingDepth >= this->lmrMinDepth) {
+      reduction = 1;
+      if (i >= this->lmrMinMoveIndex * 3 && remainingDepth > 5) {
+        reduction += 1;
+      }
+      if (this->historyScore(node, move) > this->lmrHistoryThreshold) {
+        reduction -= 1;
+      }
+      reduction = std::min(reduction, remainingDepth - 1);
+    }
+
+    if (reduction > 0) {
+      score = -negamax(ply + 1, -alpha - 1, -alpha, iDepth + 1 + reduction, iterativeDepthLimit);
+
+      // the reduced search beat alpha, so it needs to be verified at full depth.
+      // the child position is still in the next ply, nothing below overwrites it.
+      DAVID_STATS(this->stats.addReduction(score > alpha && !this->stopping));
+      if (score > alpha && !this->stopping) {
+        score = -negamax(ply + 1, -beta, -alpha, iDepth + 1, iterativeDepthLimit);
+      }
+    }
+    else {
+      score = -negamax(ply + 1, -beta, -alpha, iDepth + 1, iterativeDepthLimit);
+    }
+
+    if (score > bestScore) {
+      bestScore = score;
+      bestMove = i;
+    }
+    if (score > alpha && !this->stopping) {
+      this->stack.updatePV(ply, i);
+    }
     alpha = std::max(score, alpha);
 
+    if (alpha >= beta) {
+      DAVID_STATS(this->stats.addBetaCutoff(i));
+
+      // quiet moves causing a cut-off are remembered for move ordering and reductions
+      if (quiet) {
+        this->historyScore(node, move) += remainingDepth * remainingDepth;
+      }
+      break;
+    }
+  }
+
+  // the best move is tried first by the next iteration, or the next visit of this position
+  if (!this->stopping) {
+    this->stack.promoteMove(ply, bestMove);
+  }
+
+  return bestScore;
+}
+
+/**
+ * Search the captures of a position past the horizon until it's quiet. The
+ * active colour may also stand pat, keep the score of the position, instead
+ * of taking. Only the moves of SearchStack::generateCaptures are searched,
+ * it leaves out the captures that lose material by exchange.
+ *
+ * The horizon node was already counted by negamax, so only the positions
+ * after a capture are counted as quiescence nodes.
+ *
+ * @param ply
+ * @param alpha
+ * @param beta
+ * @return int score of the position
+ */
+int Search::quiescence(int ply, int alpha, int beta) {
+  if (this->shouldStop()) {
+    return constant::boardScore::LOWEST;
+  }
+
+  this->info.updateSelectiveDepth(this->threadID, ply);
+  this->stack.clearPV(ply);
+
+  // stand pat
+  int bestScore = this->evaluate(ply, alpha, beta);
+  if (bestScore >= beta || ply >= this->stack.getMaxDepth()) {
+    return bestScore;
+  }
+  alpha = std::max(alpha, bestScore);
+
+  const uint16_t len = this->stack.generateCaptures(ply);
+  for (uint16_t i = 0; i < len; i++) {
+    this->stack.makeMove(ply, i);
+    this->info.addQuiescenceNode(this->threadID);
+    DAVID_STATS(this->stats.addQuiescenceNode());
+    const int score = -this->quiescence(ply + 1, -beta, -alpha);
+
+    if (this->stopping) {
+      break;
+    }
+
+    if (score > bestScore) {
+      bestScore = score;
+    }
+    if (score > alpha) {
+      alpha = score;
+      this->stack.updatePV(ply, i);
+    }
     if (alpha >= beta) {
       break;
     }
@@ -266,6 +859,86 @@ int Search::negamax(unsigned int index, int alpha, int beta, int iDepth, int ite
   return bestScore;
 }
 
+/**
+ * Score of a position at the horizon or in the quiescence search. With lazy
+ * evaluation the network hasn't scored it yet, and isn't run when the
+ * material balance is further than the margin outside the window. The
+ * balance plus or minus the margin is then a bound that fails the same way.
+ *
+ * @param ply
+ * @param alpha
+ * @param beta
+ * @return int score from the side of the active colour
+ */
+int Search::evaluate(int ply, int alpha, int beta) {
+  if (this->lazyEvalMargin > 0 && !this->stack.hasScore(ply)) {
+    const int material = materialBalance(this->stack.getPosition(ply));
+    if (material + this->lazyEvalMargin <= alpha) {
+      return material + this->lazyEvalMargin;
+    }
+    if (material - this->lazyEvalMargin >= beta) {
+      return material - this->lazyEvalMargin;
+    }
+  }
+
+  return this->stack.score(ply);
+}
+
+/**
+ * Switch a ponder search over to a timed search once the uci thread has
+ * received ponderhit. Runs on the search thread, so the time manager is
+ * never touched by two threads.
+ */
+void Search::checkPonderHit() {
+  if (!this->pondering || !this->ponderHitPending.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  this->pondering = false;
+  this->timeManager.ponderhit();
+
+  if (this->timeManager.hasTimeLimit()) {
+    this->control.startTimer(this->timeManager.getHardDeadline());
+  }
+}
+
+/**
+ * Check if the active colour has any pieces left other than king and pawns.
+ * Used as a zugzwang guard for null move pruning.
+ *
+ * @param node
+ * @return true if there's at least one rook, knight, bishop or queen
+ */
+bool Search::hasNonPawnMaterial(const type::gameState_t& node) const {
+  const auto& pieces = node.piecesArr;
+  return (node.piecess[0] ^ pieces[constant::index::pawn][0] ^ pieces[constant::index::king][0]) != 0ULL;
+}
+
+/**
+ * A move is quiet when nothing was captured and no pawn was promoted.
+ *
+ * @param parent
+ * @param child one of the children generated from parent
+ * @return true if the move is neither a capture or a promotion
+ */
+bool Search::isQuietMove(const type::gameState_t& parent, const type::gameState_t& child) const {
+  // the colour index is swapped in the child
+  return parent.piecess[1] == child.piecess[0]
+      && ::utils::nrOfActiveBits(parent.piecesArr[constant::index::pawn][0])
+          == ::utils::nrOfActiveBits(child.piecesArr[constant::index::pawn][1]);
+}
+
+/**
+ * History score of a move.
+ *
+ * @param parent the position the move is played from
+ * @param move encoded move, see MoveGen::encodeMove
+ * @return reference to the history table entry
+ */
+int& Search::historyScore(const type::gameState_t& parent, const type::move_t move) {
+  return this->history[parent.isWhite ? 0 : 1][move & 63][(move >> 6) & 63];
+}
+
 /**
  * Called by searchInit, reset/get settings from UCI
  * Mainly used for debugging and progress atm
@@ -273,8 +946,20 @@ int Search::negamax(unsigned int index, int alpha, int beta, int iDepth, int ite
 void Search::resetSearchValues() {
   //this->movetime = 1000; //Hardcoded variables as of now, need to switch to forwards later
   this->searchScore = 0;
-  this->nodesSearched = 0;
+  this->info.start();
+  this->tt.newSearch();
   this->bestMoveIndex = -1;
+  this->aspirationFailHighs = 0;
+  this->aspirationFailLows = 0;
+  this->nodesUntilStopPoll = this->stopPollInterval;
+  this->stopping = false;
+  DAVID_STATS(this->stats.start(this->stack.getMaxDepth() + 1));
+
+  for (auto& colour : this->history) {
+    for (auto& from : colour) {
+      from.fill(0);
+    }
+  }
 }
 
 /**
@@ -358,11 +1043,87 @@ void Search::setDepth(int depth) {
   this->depth = depth;
 }
 
+/**
+ * Deepest the search is allowed to go, this decides the size of the search stack.
+ * Can't be changed while searching.
+ * @param depth
+ */
+void Search::setMaxDepth(int depth) {
+  this->stack.setMaxDepth(depth);
+}
+
+int Search::getMaxDepth() const {
+  return this->stack.getMaxDepth();
+}
+
+/**
+ * Resize the transposition table, this clears it.
+ * Can't be changed while searching.
+ * @param megabytes
+ */
+void Search::setHashSize(int megabytes) {
+  this->tt.resize(static_cast<size_t>(std::max(megabytes, 1)));
+}
+
+/**
+ * Register the endgame tablebases of a list of folders, replacing the old ones.
+ * Can't be changed while searching.
+ * @param paths folders separated by ':', or ';' on windows, "<empty>" for none
+ * @return number of tables found
+ */
+unsigned int Search::setSyzygyPath(const std::string& paths) {
+  return this->syzygy.init(paths);
+}
+
+/**
+ * Positions with more pieces than this are never probed.
+ * @param pieces 0 turns probing off
+ */
+void Search::setSyzygyProbeLimit(int pieces) {
+  this->syzygyProbeLimit = std::max(std::min(pieces, Syzygy::MAX_PIECES), 0);
+}
+
+/**
+ * Forget all positions stored in the transposition table.
+ */
+void Search::clearHash() {
+  this->tt.clear();
+}
+
+
+/**
+ * Clear the clock related go parameters, as they only apply to one go command.
+ */
+void Search::resetTimeControls() {
+  this->mate = 0;
+  this->wtime = 0;
+  this->btime = 0;
+  this->winc = 0;
+  this->binc = 0;
+  this->movestogo = 0;
+  this->movetime = 0;
+  this->infinite = false;
+  this->ponder = false;
+  this->ponderHitPending.store(false);
+}
 
 void Search::setSearchMoves(std::string moves) {
   this->searchMoves = moves;
 }
 
+void Search::setWTime(int wtime) {
+  this->wtime = wtime;
+}
+void Search::setBTime(int btime) {
+  this->btime = btime;
+}
+void Search::setWinc(int winc) {
+  this->winc = winc;
+}
+void Search::setBinc(int binc) {
+  this->binc = binc;
+}
+
 void Search::setMovesToGo(int movestogo) {
   this->movestogo = movestogo;
 }
@@ -387,6 +1148,14 @@ void Search::setPonder(bool ponder) {
   this->ponder = ponder;
 } // bool ?
 
+/**
+ * The opponent played the expected move. The ponder search continues, but
+ * from now on with a time budget. Called from the uci thread.
+ */
+void Search::ponderHit() {
+  this->ponderHitPending.store(true);
+}
+
 /**
  * Used to set game difficulty
  * @param difficulty
@@ -433,13 +1202,226 @@ int Search::getTimeUsed() {
   return this->timeUsed;
 }
 
+/**
+ * Nodes visited by the last search.
+ * @return uint64_t
+ */
+uint64_t Search::getNodes() const {
+  return this->info.getNodes();
+}
+
+/**
+ * Time reserved for communication lag between engine and GUI
+ * @param overhead ms
+ */
+void Search::setMoveOverhead(int overhead) {
+  this->timeManager.setMoveOverhead(overhead);
+}
+
+/**
+ * Number of nodes between each check of the stop flag.
+ * Lower values stop faster at the cost of more atomic loads.
+ * @param nodes
+ */
+void Search::setStopPollInterval(int nodes) {
+  this->stopPollInterval = std::max(nodes, 1);
+}
+
+/**
+ * Minimum time between two periodic uci info lines.
+ * @param ms
+ */
+void Search::setInfoInterval(int ms) {
+  this->info.setInterval(ms);
+}
+
+/**
+ * Register that bestmove was sent to the GUI.
+ * @return int microseconds from the deadline or stop command until now, -1 if the search wasn't stopped
+ */
+int Search::bestMoveSent() {
+  return this->control.bestMoveSent();
+}
+
+
+/**
+ * Enable or disable null move pruning
+ * @param enabled
+ */
+void Search::setNullMovePruning(bool enabled) {
+  this->nullMovePruning = enabled;
+}
+
+/**
+ * Extra depth reduction R used for the null move search
+ * @param reduction
+ */
+void Search::setNullMoveReduction(int reduction) {
+  this->nullMoveReduction = reduction;
+}
+
+/**
+ * Minimum remaining depth before a null move is tried
+ * @param depth
+ */
+void Search::setNullMoveMinDepth(int depth) {
+  this->nullMoveMinDepth = depth;
+}
+
+/**
+ * Enable or disable late move reductions
+ * @param enabled
+ */
+void Search::setLateMoveReductions(bool enabled) {
+  this->lateMoveReductions = enabled;
+}
+
+/**
+ * Minimum remaining depth before late moves are reduced
+ * @param depth
+ */
+void Search::setLMRMinDepth(int depth) {
+  this->lmrMinDepth = depth;
+}
+
+/**
+ * Number of moves searched at full depth before reducing the rest
+ * @param index
+ */
+void Search::setLMRMinMoveIndex(int index) {
+  this->lmrMinMoveIndex = index;
+}
+
+/**
+ * Quiet moves with a history score above this are reduced one ply less
+ * @param threshold
+ */
+void Search::setLMRHistoryThreshold(int threshold) {
+  this->lmrHistoryThreshold = threshold;
+}
+
+/**
+ * Enable or disable the quiescence search, the horizon nodes are scored as is without it
+ * @param enabled
+ */
+void Search::setQuiescence(bool enabled) {
+  this->quiescenceSearch = enabled;
+}
+
+/**
+ * Enable or disable pruning of quiet moves that lose material by exchange
+ * @param enabled
+ */
+void Search::setSEEPruning(bool enabled) {
+  this->seePruning = enabled;
+}
+
+/**
+ * Maximum remaining depth where quiet moves are pruned by exchange
+ * @param depth
+ */
+void Search::setSEEPruningDepth(int depth) {
+  this->seePruningDepth = depth;
+}
+
+/**
+ * Material a quiet move may lose by exchange per remaining ply before it's pruned
+ * @param margin
+ */
+void Search::setSEEQuietMargin(int margin) {
+  this->seeQuietMargin = std::max(margin, 0);
+}
+
+/**
+ * Order the moves of interior nodes by exchange and history instead of the
+ * network, and only evaluate the horizon and quiescence nodes
+ * @param enabled
+ */
+void Search::setLazyEvaluation(bool enabled) {
+  if (enabled != this->lazyEvaluation) {
+    // the stored move lists were ordered by the other mode
+    this->clearHash();
+  }
+
+  this->lazyEvaluation = enabled;
+  this->stack.setLazyEvaluation(enabled);
+}
+
+/**
+ * Material balance outside the window where a lazy evaluation skips the network, 0 never skips it
+ * @param margin
+ */
+void Search::setLazyEvalMargin(int margin) {
+  this->lazyEvalMargin = std::max(margin, 0);
+}
+
+/**
+ * Half the width of the first aspiration window, 0 searches the root with a full window
+ * @param window
+ */
+void Search::setAspirationWindow(int window) {
+  this->aspirationWindow = std::max(window, 0);
+}
+
+/**
+ * First iteration that uses an aspiration window, the scores of shallower
+ * iterations jump around too much
+ * @param depth
+ */
+void Search::setAspirationMinDepth(int depth) {
+  this->aspirationMinDepth = depth;
+}
+
+/**
+ * Number of principal variations to search and report
+ * @param lines
+ */
+void Search::setMultiPV(int lines) {
+  this->multiPV = std::max(lines, 1);
+}
+
+/**
+ * The second move of the best principal variation.
+ * @return std::string long algebraic notation, empty if the line is too short
+ */
+std::string Search::getPonderMove() {
+  if (this->rootMoves.empty() || this->rootMoves[0].pv.empty()) {
+    return "";
+  }
+
+  type::gameState_t parent = this->treeGen.getGameState(this->rootMoves[0].index);
+  type::gameState_t child;
+  MoveGen gen{parent};
+  gen.applyMove(this->rootMoves[0].pv[0], child);
+
+  return ::utils::gameState::getEGN(parent, child);
+}
+
+/**
+ * @return int root re-searches of the last search caused by a fail high
+ */
+int Search::getAspirationFailHighs() const {
+  return this->aspirationFailHighs;
+}
+
+/**
+ * @return int root re-searches of the last search caused by a fail low
+ */
+int Search::getAspirationFailLows() const {
+  return this->aspirationFailLows;
+}
 
 /**
  * Set aborted search
  * @param isAborted
  */
 void Search::setAbort(bool isAborted) {
-  this->isAborted = isAborted;
+  if (isAborted) {
+    this->control.stop();
+  }
+  else {
+    this->control.reset();
+  }
 }
 
 /**
@@ -0,0 +1,111 @@
+#include "david/SearchControl.h"
+
+#include <algorithm>
+
+namespace david {
+
+/**
+ * Constructor
+ */
+SearchControl::SearchControl()
+    : stopFlag(false)
+    , stopTriggeredAt(0)
+    , timerCancelled(false)
+    , lastLatency(-1)
+    , maxLatency(-1)
+{}
+
+/**
+ * Destructor, makes sure the timer thread doesn't outlive the instance.
+ */
+SearchControl::~SearchControl() {
+  this->stopTimer();
+}
+
+/**
+ * Lower the stop flag and forget any earlier stop trigger.
+ */
+void SearchControl::reset() {
+  this->stopTriggeredAt.store(0, std::memory_order_relaxed);
+  this->stopFlag.store(false, std::memory_order_release);
+}
+
+/**
+ * Raise the stop flag, typically from the UCI stop command.
+ */
+void SearchControl::stop() {
+  this->trigger();
+}
+
+/**
+ * Record the first trigger time and raise the flag.
+ */
+void SearchControl::trigger() {
+  int64_t expected = 0;
+  const int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+  this->stopTriggeredAt.compare_exchange_strong(expected, now);
+  this->stopFlag.store(true, std::memory_order_release);
+}
+
+/**
+ * Start a timer thread that raises the stop flag at the deadline.
+ * @param deadline timePoint_t absolute time where the search must stop
+ */
+void SearchControl::startTimer(const timePoint_t deadline) {
+  this->stopTimer();
+
+  this->timerCancelled = false;
+  this->timer = std::thread([this, deadline]() {
+    std::unique_lock<std::mutex> lock(this->timerMutex);
+    const bool cancelled = this->timerCondition.wait_until(lock, deadline, [this]() {
+      return this->timerCancelled;
+    });
+
+    if (!cancelled) {
+      this->trigger();
+    }
+  });
+}
+
+/**
+ * Cancel and join the timer thread, if running.
+ */
+void SearchControl::stopTimer() {
+  {
+    std::lock_guard<std::mutex> lock(this->timerMutex);
+    this->timerCancelled = true;
+  }
+  this->timerCondition.notify_all();
+
+  if (this->timer.joinable()) {
+    this->timer.join();
+  }
+}
+
+/**
+ * Register that bestmove was sent to the GUI.
+ * @return int microseconds between the stop trigger and now, -1 if the search wasn't stopped
+ */
+int SearchControl::bestMoveSent() {
+  const int64_t triggeredAt = this->stopTriggeredAt.load(std::memory_order_relaxed);
+  if (triggeredAt == 0) {
+    return -1;
+  }
+
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  const auto diff = now - std::chrono::steady_clock::duration(triggeredAt);
+  this->lastLatency = static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(diff).count());
+  this->maxLatency = std::max(this->maxLatency, this->lastLatency);
+
+  return this->lastLatency;
+}
+
+int SearchControl::getLastLatency() const {
+  return this->lastLatency;
+}
+
+int SearchControl::getMaxLatency() const {
+  return this->maxLatency;
+}
+
+}
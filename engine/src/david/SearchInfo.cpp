@@ -0,0 +1,279 @@
+#include "david/SearchInfo.h"
+#include "david/david.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace david {
+
+namespace {
+
+/**
+ * Moves until the mate at the end of a principal variation, negative when
+ * the active colour is the one mated.
+ * @param winning the active colour mates
+ * @param pv moves of the line in long algebraic notation
+ * @return int UCI mate distance, never 0
+ */
+int mateDistance(const bool winning, const std::string& pv) {
+  std::istringstream moves(pv);
+  const auto plies = static_cast<int>(std::distance(std::istream_iterator<std::string>(moves), std::istream_iterator<std::string>()));
+
+  return winning ? std::max((plies + 1) / 2, 1) : -std::max(plies / 2, 1);
+}
+
+} // anonymous namespace
+
+/**
+ * Constructor
+ */
+SearchInfo::SearchInfo()
+    : startTime(std::chrono::steady_clock::now())
+    , lastReport(startTime)
+    , hasReported(false)
+    , interval(1000)
+    , depth(0)
+    , currentMove("")
+    , currentMoveNumber(0)
+    , hashfullProvider(nullptr)
+{
+  this->start();
+}
+
+/**
+ * Clear all counters and start the clock of a new search.
+ */
+void SearchInfo::start() {
+  for (auto& counter : this->counters) {
+    counter.nodes.store(0, std::memory_order_relaxed);
+    counter.qnodes.store(0, std::memory_order_relaxed);
+    counter.tbhits.store(0, std::memory_order_relaxed);
+    counter.seldepth.store(0, std::memory_order_relaxed);
+  }
+
+  this->startTime = std::chrono::steady_clock::now();
+  this->lastReport = this->startTime;
+  this->hasReported = false;
+  this->depth = 0;
+  this->currentMove = "";
+  this->currentMoveNumber = 0;
+}
+
+void SearchInfo::setHashfullProvider(std::function<int()> provider) {
+  this->hashfullProvider = provider;
+}
+
+/**
+ * Minimum time between two info lines.
+ * @param ms milliseconds, 0 reports every time
+ */
+void SearchInfo::setInterval(const int ms) {
+  this->interval = std::max(ms, 0);
+}
+
+void SearchInfo::setDepth(const int depth) {
+  this->depth = depth;
+}
+
+void SearchInfo::setCurrentMove(const std::string& move, const int number) {
+  this->currentMove = move;
+  this->currentMoveNumber = number;
+}
+
+/**
+ * Nodes of both the main and quiescence search, summed over all threads.
+ */
+uint64_t SearchInfo::getNodes() const {
+  uint64_t nodes = 0;
+  for (const auto& counter : this->counters) {
+    nodes += counter.nodes.load(std::memory_order_relaxed);
+    nodes += counter.qnodes.load(std::memory_order_relaxed);
+  }
+
+  return nodes;
+}
+
+uint64_t SearchInfo::getQuiescenceNodes() const {
+  uint64_t nodes = 0;
+  for (const auto& counter : this->counters) {
+    nodes += counter.qnodes.load(std::memory_order_relaxed);
+  }
+
+  return nodes;
+}
+
+uint64_t SearchInfo::getNodesPerSecond() const {
+  const auto diff = std::chrono::steady_clock::now() - this->startTime;
+  const auto us = std::chrono::duration_cast<std::chrono::microseconds>(diff).count();
+  if (us <= 0) {
+    return 0;
+  }
+
+  return this->getNodes() * 1000000 / static_cast<uint64_t>(us);
+}
+
+uint64_t SearchInfo::getTablebaseHits() const {
+  uint64_t tbhits = 0;
+  for (const auto& counter : this->counters) {
+    tbhits += counter.tbhits.load(std::memory_order_relaxed);
+  }
+
+  return tbhits;
+}
+
+int SearchInfo::getSelectiveDepth() const {
+  int seldepth = 0;
+  for (const auto& counter : this->counters) {
+    seldepth = std::max(seldepth, counter.seldepth.load(std::memory_order_relaxed));
+  }
+
+  return seldepth;
+}
+
+/**
+ * @return int permill of the transposition table in use, -1 if unknown
+ */
+int SearchInfo::getHashfull() const {
+  if (!this->hashfullProvider) {
+    return -1;
+  }
+
+  return this->hashfullProvider();
+}
+
+/**
+ * Time passed since start was called.
+ * @return int milliseconds
+ */
+int SearchInfo::elapsed() const {
+  const auto diff = std::chrono::steady_clock::now() - this->startTime;
+  return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(diff).count());
+}
+
+/**
+ * Print an info line if the interval has passed since the last one.
+ * @param force print no matter when the last line was sent
+ * @return true if a line was printed
+ */
+bool SearchInfo::report(const bool force) {
+  const auto now = std::chrono::steady_clock::now();
+  const auto sinceLast = std::chrono::duration_cast<std::chrono::milliseconds>(now - this->lastReport).count();
+
+  if (!force && this->hasReported && sinceLast < this->interval) {
+    return false;
+  }
+
+  this->lastReport = now;
+  this->hasReported = true;
+
+  std::cout << this->toString() << std::endl;
+  return true;
+}
+
+/**
+ * Build the info line without printing it.
+ * @return std::string the UCI info line
+ */
+std::string SearchInfo::toString() const {
+  std::stringstream line;
+  line << "info"
+       << " depth " << this->depth
+       << " seldepth " << this->getSelectiveDepth();
+  this->writeCounters(line);
+
+  if (!this->currentMove.empty()) {
+    line << " currmove " << this->currentMove
+         << " currmovenumber " << this->currentMoveNumber;
+  }
+
+  return line.str();
+}
+
+/**
+ * Print the result of a principal variation, never throttled.
+ * @param multipv line number, starting at 1
+ * @param score of the line
+ * @param pv moves of the line in long algebraic notation
+ */
+void SearchInfo::reportLine(const int multipv, const int score, const std::string& pv) {
+  this->lastReport = std::chrono::steady_clock::now();
+  this->hasReported = true;
+
+  std::cout << this->lineToString(multipv, score, pv) << std::endl;
+}
+
+/**
+ * Build a principal variation info line without printing it. Mates, scored
+ * as HIGHEST or LOWEST, are reported in moves.
+ * @param multipv line number, starting at 1
+ * @param score of the line
+ * @param pv moves of the line in long algebraic notation, ending in the mate
+ * @return std::string the UCI info line
+ */
+std::string SearchInfo::lineToString(const int multipv, const int score, const std::string& pv) const {
+  std::stringstream line;
+  line << "info"
+       << " depth " << this->depth
+       << " seldepth " << this->getSelectiveDepth()
+       << " multipv " << multipv;
+  if (score == constant::boardScore::HIGHEST || score == constant::boardScore::LOWEST) {
+    line << " score mate " << mateDistance(score == constant::boardScore::HIGHEST, pv);
+  }
+  else {
+    line << " score cp " << score;
+  }
+  this->writeCounters(line);
+  line << " pv " << pv;
+
+  return line.str();
+}
+
+/**
+ * Print a proven mate, never throttled.
+ * @param moves number of moves until mate
+ * @param pv moves of the mate in long algebraic notation
+ */
+void SearchInfo::reportMate(const int moves, const std::string& pv) {
+  this->lastReport = std::chrono::steady_clock::now();
+  this->hasReported = true;
+
+  std::cout << this->mateLineToString(moves, pv) << std::endl;
+}
+
+/**
+ * Build a mate info line without printing it.
+ * @param moves number of moves until mate
+ * @param pv moves of the mate in long algebraic notation
+ * @return std::string the UCI info line
+ */
+std::string SearchInfo::mateLineToString(const int moves, const std::string& pv) const {
+  std::stringstream line;
+  line << "info"
+       << " depth " << this->depth
+       << " seldepth " << this->getSelectiveDepth()
+       << " score mate " << moves;
+  this->writeCounters(line);
+  line << " pv " << pv;
+
+  return line.str();
+}
+
+/**
+ * Append nodes, nps, time, tbhits and hashfull to an info line.
+ * @param line std::ostream
+ */
+void SearchInfo::writeCounters(std::ostream& line) const {
+  line << " nodes " << this->getNodes()
+       << " nps " << this->getNodesPerSecond()
+       << " time " << this->elapsed()
+       << " tbhits " << this->getTablebaseHits();
+
+  const int hashfull = this->getHashfull();
+  if (hashfull >= 0) {
+    line << " hashfull " << hashfull;
+  }
+}
+
+}
@@ -0,0 +1,473 @@
+#include "david/SearchStack.h"
+#include "david/ANN/ANN.h"
+#include "david/MoveGen.h"
+#include "david/SEE.h"
+#include "david/utils/gameState.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace david {
+
+/**
+ * Constructor
+ * @param neuralNetwork used to score every generated move
+ * @param table where sorted move lists are kept between iterations
+ * @param maxDepth number of plies below the root
+ */
+SearchStack::SearchStack(const type::NeuralNetwork_t& neuralNetwork, TranspositionTable& table, const int maxDepth)
+    : neuralnet(neuralNetwork)
+    , tt(table)
+    , stats(nullptr)
+    , history(nullptr)
+    , lazy(false)
+{
+  this->setMaxDepth(maxDepth);
+}
+
+/**
+ * Change how many plies the search can go down, not counting the root.
+ * @param maxDepth int
+ */
+void SearchStack::setMaxDepth(const int maxDepth) {
+  // one extra ply so a leaf can always be created
+  this->plies.resize(static_cast<size_t>(std::max(maxDepth, 1)) + 2);
+
+  for (auto& ply : this->plies) {
+    ply.hasAccumulator = false;
+    ply.hasScore = true;
+    ply.pvLength = 0;
+    ply.pv.resize(this->plies.size());
+  }
+}
+
+int SearchStack::getMaxDepth() const {
+  return static_cast<int>(this->plies.size()) - 2;
+}
+
+/**
+ * Where the ANN evaluations are counted, only used by DAVID_SEARCH_STATS builds.
+ * @param searchStats SearchStats*, may be nullptr
+ */
+void SearchStack::setStats(SearchStats* searchStats) {
+  this->stats = searchStats;
+}
+
+/**
+ * Order new move lists without the network, and only score the positions
+ * the search asks for. Move lists stored in the transposition table by the
+ * other mode have the wrong scores, so it should be cleared.
+ * @param enabled bool
+ */
+void SearchStack::setLazyEvaluation(const bool enabled) {
+  this->lazy = enabled;
+}
+
+bool SearchStack::isLazyEvaluation() const {
+  return this->lazy;
+}
+
+/**
+ * History heuristic that orders the quiet moves of lazy move lists.
+ * @param table History*, may be nullptr
+ */
+void SearchStack::setHistory(const History* table) {
+  this->history = table;
+}
+
+/**
+ * Set the position of a ply, usually the root or a root child.
+ * @param ply int
+ * @param gs position to copy
+ */
+void SearchStack::setPosition(const int ply, const type::gameState_t& gs) {
+  this->plies[ply].position = gs;
+  this->plies[ply].nrOfMoves = 0;
+  this->plies[ply].hasAccumulator = false;
+  this->plies[ply].hasScore = true;
+  this->plies[ply].pvLength = 0;
+}
+
+/**
+ * Generate, evaluate and sort the moves of the position at ply, or
+ * reuse them from the transposition table. Lazy evaluation sorts them
+ * by history instead of evaluating them.
+ * @param ply int
+ * @return number of legal moves
+ */
+uint16_t SearchStack::generateMoves(const int ply) {
+  auto& current = this->plies[ply];
+  const uint64_t key = ::utils::gameState::zobristHash(current.position);
+  current.hash = key;
+
+  const auto entry = this->tt.probe(key);
+  if (entry != nullptr) {
+    std::memcpy(current.moves.data(), entry->moves, entry->nrOfMoves * sizeof(ScoredMove));
+    current.nrOfMoves = entry->nrOfMoves;
+    current.position.possibleSubMoves = entry->nrOfMoves;
+
+    return entry->nrOfMoves;
+  }
+
+  MoveGen gen{current.position};
+  const uint16_t len = gen.generateGameStates(this->children, 0, constant::MAXMOVES - 1, this->childMoves.data());
+
+  for (uint16_t i = 0; i < len; i++) {
+    current.moves[i].move = this->childMoves[i];
+  }
+
+  if (this->lazy) {
+    this->orderByHistory(current.position, current.moves.data(), len);
+  }
+  else {
+    this->evaluate(ply, this->children.data(), len, current.moves.data());
+    DAVID_STATS(if (this->stats != nullptr) this->stats->addEvaluations(len));
+
+    // the children are scored from the opponent's side, so the lowest score is the best move
+    std::sort(current.moves.begin(), current.moves.begin() + len,
+              [](const ScoredMove& a, const ScoredMove& b) -> bool {
+                return a.score < b.score;
+              });
+  }
+  this->orderByExchange(current.position, current.moves.data(), len);
+
+  current.nrOfMoves = len;
+  current.position.possibleSubMoves = len;
+  this->tt.store(key, current.moves.data(), len);
+
+  return len;
+}
+
+/**
+ * Captures and promotions of the position at ply that don't lose material
+ * by exchange, best exchange first, for the quiescence search. Never stored
+ * in the transposition table, a stored move list is reused when there is one.
+ * @param ply int
+ * @return number of moves
+ */
+uint16_t SearchStack::generateCaptures(const int ply) {
+  auto& current = this->plies[ply];
+  const auto& position = current.position;
+  current.hash = ::utils::gameState::zobristHash(position);
+
+  std::array<int, constant::MAXMOVES> exchange;
+  uint16_t len = 0;
+
+  // a stored move list already has the ANN scores
+  const auto entry = this->tt.probe(current.hash);
+  if (entry != nullptr) {
+    for (uint16_t i = 0; i < entry->nrOfMoves; i++) {
+      const auto move = entry->moves[i].move;
+      if (!see::isCapture(position, move) && (move >> 12) == 0) {
+        continue;
+      }
+
+      const int gain = see::evaluate(position, move);
+      if (gain >= 0) {
+        exchange[len] = gain;
+        current.moves[len++] = entry->moves[i];
+      }
+    }
+  }
+  else {
+    MoveGen gen{current.position};
+    const uint16_t nrOfChildren = gen.generateGameStates(this->children, 0, constant::MAXMOVES - 1, this->childMoves.data());
+
+    for (uint16_t i = 0; i < nrOfChildren; i++) {
+      const auto move = this->childMoves[i];
+      if (!see::isCapture(position, move) && (move >> 12) == 0) {
+        continue;
+      }
+
+      const int gain = see::evaluate(position, move);
+      if (gain >= 0) {
+        exchange[len] = gain;
+        current.moves[len].move = move;
+        current.moves[len++].score = this->lazy ? 0 : this->evaluate(ply, this->children[i]);
+      }
+    }
+    DAVID_STATS(if (this->stats != nullptr && !this->lazy) this->stats->addEvaluations(len));
+  }
+
+  // insertion sort, there are rarely more than a few captures
+  for (uint16_t i = 1; i < len; i++) {
+    const auto move = current.moves[i];
+    const int gain = exchange[i];
+    int j = i - 1;
+    for (; j >= 0 && exchange[j] < gain; j--) {
+      exchange[j + 1] = exchange[j];
+      current.moves[j + 1] = current.moves[j];
+    }
+    exchange[j + 1] = gain;
+    current.moves[j + 1] = move;
+  }
+
+  current.nrOfMoves = len;
+  return len;
+}
+
+/**
+ * Move the i'th move of ply to the front of its move list, also in the
+ * transposition table, so it's searched first the next time.
+ * @param ply int
+ * @param i index in the sorted move list
+ */
+void SearchStack::promoteMove(const int ply, const unsigned int i) {
+  auto& current = this->plies[ply];
+  if (i == 0 || i >= current.nrOfMoves) {
+    return;
+  }
+
+  std::rotate(current.moves.begin(), current.moves.begin() + i, current.moves.begin() + i + 1);
+  this->tt.store(current.hash, current.moves.data(), current.nrOfMoves);
+}
+
+/**
+ * Create the position after the i'th move of ply in the next ply.
+ * @param ply int
+ * @param i index in the sorted move list
+ * @return the new position
+ */
+type::gameState_t& SearchStack::makeMove(const int ply, const unsigned int i) {
+  auto& current = this->plies[ply];
+  auto& next = this->plies[ply + 1];
+
+  MoveGen gen{current.position};
+  gen.applyMove(current.moves[i].move, next.position);
+  next.position.score = current.moves[i].score;
+  next.hasScore = !this->lazy;
+  next.nrOfMoves = 0;
+  next.hasAccumulator = false;
+
+  return next.position;
+}
+
+/**
+ * Create the position after the active colour passes in the next ply.
+ * @param ply int
+ * @return the new position
+ */
+type::gameState_t& SearchStack::makeNullMove(const int ply) {
+  auto& next = this->plies[ply + 1];
+
+  ::utils::gameState::generateNullMove(this->plies[ply].position, next.position);
+  next.nrOfMoves = 0;
+  next.hasAccumulator = false;
+  next.hasScore = false;
+  if (!this->lazy) {
+    this->score(ply + 1);
+  }
+
+  return next.position;
+}
+
+/**
+ * ANN score of the position at ply, evaluated now if it wasn't when the
+ * move to it was generated.
+ * @param ply int, 1 or more
+ * @return int score from the side of the active colour
+ */
+int SearchStack::score(const int ply) {
+  auto& current = this->plies[ply];
+  if (!current.hasScore) {
+    current.position.score = this->evaluate(ply - 1, current.position);
+    current.hasScore = true;
+    DAVID_STATS(if (this->stats != nullptr) this->stats->addEvaluations(1));
+  }
+
+  return current.position.score;
+}
+
+/**
+ * Put the captures that win material by exchange in front of an ANN sorted
+ * move list, best exchange first, and the ones that lose material at the
+ * end. Everything else keeps its order.
+ * @param position the moves are played from
+ * @param moves sorted by ANN score
+ * @param len number of moves
+ */
+void SearchStack::orderByExchange(const type::gameState_t& position, ScoredMove* moves, const uint16_t len) const {
+  struct Ordered {
+    ScoredMove move;
+    int group; // 0 winning capture, 1 other, 2 losing capture
+    int exchange;
+  };
+
+  std::array<Ordered, constant::MAXMOVES> ordered;
+  for (uint16_t i = 0; i < len; i++) {
+    int gain = 0;
+    if (see::isCapture(position, moves[i].move)) {
+      gain = see::evaluate(position, moves[i].move);
+    }
+
+    ordered[i] = {moves[i], gain > 0 ? 0 : (gain < 0 ? 2 : 1), gain};
+  }
+
+  std::stable_sort(ordered.begin(), ordered.begin() + len,
+                   [](const Ordered& a, const Ordered& b) -> bool {
+                     return a.group < b.group || (a.group == 0 && b.group == 0 && a.exchange > b.exchange);
+                   });
+
+  for (uint16_t i = 0; i < len; i++) {
+    moves[i] = ordered[i].move;
+  }
+}
+
+/**
+ * Sort a move list by the history heuristic, for lazy evaluation. The scores
+ * become sort keys like the ANN scores, the lowest is the best move. Captures
+ * and promotions go before the quiet moves, orderByExchange sorts them after.
+ * @param position the moves are played from
+ * @param moves in generation order
+ * @param len number of moves
+ */
+void SearchStack::orderByHistory(const type::gameState_t& position, ScoredMove* moves, const uint16_t len) const {
+  const unsigned int colour = position.isWhite ? 0 : 1;
+  for (uint16_t i = 0; i < len; i++) {
+    const auto move = moves[i].move;
+    if (see::isCapture(position, move) || (move >> 12) != 0) {
+      moves[i].score = constant::boardScore::LOWEST;
+    }
+    else if (this->history != nullptr) {
+      moves[i].score = -(*this->history)[colour][move & 63][(move >> 6) & 63];
+    }
+    else {
+      moves[i].score = 0;
+    }
+  }
+
+  std::stable_sort(moves, moves + len,
+                   [](const ScoredMove& a, const ScoredMove& b) -> bool {
+                     return a.score < b.score;
+                   });
+}
+
+/**
+ * First layer of the network for the position of a ply. Made from the one of
+ * the ply before when it has one, since that's the position before the move.
+ * @param ply int
+ * @return the accumulator of the ply
+ */
+const DenseNetwork::Accumulator& SearchStack::accumulator(const int ply) {
+  auto& current = this->plies[ply];
+  if (!current.hasAccumulator) {
+    if (ply > 0 && this->plies[ply - 1].hasAccumulator) {
+      this->neuralnet.updateAccumulator(this->plies[ply - 1].accumulator, current.position, current.accumulator);
+    }
+    else {
+      this->neuralnet.refreshAccumulator(current.position, current.accumulator);
+    }
+    current.hasAccumulator = true;
+  }
+
+  return current.accumulator;
+}
+
+/**
+ * Score a position reached from the position of a ply.
+ * @param ply int
+ * @param child position after a move, or a null move, of ply
+ * @return int ANN score of the child
+ */
+int SearchStack::evaluate(const int ply, type::gameState_t& child) {
+  if (!this->neuralnet.hasAccumulators()) {
+    return this->neuralnet.ANNEvaluate(child);
+  }
+
+  auto& cache = this->neuralnet.getEvaluationCache();
+  const uint64_t key = cache.isEnabled() ? EvaluationCache::key(child) : 0;
+  int score;
+  if (cache.probe(key, score)) {
+    return score;
+  }
+
+  auto& childAccumulator = this->childAccumulators.front();
+  this->neuralnet.updateAccumulator(this->accumulator(ply), child, childAccumulator);
+  score = this->neuralnet.ANNEvaluate(childAccumulator);
+  cache.store(key, score);
+
+  return score;
+}
+
+/**
+ * Score the positions reached from the position of a ply, as batches.
+ * @param ply int
+ * @param children positions after the moves of ply
+ * @param n number of children
+ * @param moves where the scores are written, one for each child
+ */
+void SearchStack::evaluate(const int ply, type::gameState_t* children, const uint16_t n, ScoredMove* moves) {
+  std::array<int, constant::MAXMOVES> scores;
+
+  if (!this->neuralnet.hasAccumulators()) {
+    this->neuralnet.evaluateBatch(children, n, scores.data());
+  }
+  else {
+    auto& cache = this->neuralnet.getEvaluationCache();
+
+    // children that weren't cached, waiting for the network
+    std::array<uint16_t, DenseNetwork::BATCH> pending;
+    std::array<uint64_t, DenseNetwork::BATCH> keys;
+    std::array<int, DenseNetwork::BATCH> batchScores;
+    size_t count = 0;
+
+    const auto flush = [&]() {
+      this->neuralnet.evaluateBatch(this->childAccumulators.data(), count, batchScores.data());
+      for (size_t j = 0; j < count; j++) {
+        scores[pending[j]] = batchScores[j];
+        cache.store(keys[j], batchScores[j]);
+      }
+      count = 0;
+    };
+
+    for (uint16_t i = 0; i < n; i++) {
+      const uint64_t key = cache.isEnabled() ? EvaluationCache::key(children[i]) : 0;
+      if (cache.probe(key, scores[i])) {
+        continue;
+      }
+
+      this->neuralnet.updateAccumulator(this->accumulator(ply), children[i], this->childAccumulators[count]);
+      pending[count] = i;
+      keys[count++] = key;
+
+      if (count == DenseNetwork::BATCH) {
+        flush();
+      }
+    }
+
+    if (count > 0) {
+      flush();
+    }
+  }
+
+  for (uint16_t i = 0; i < n; i++) {
+    moves[i].score = scores[i];
+  }
+}
+
+/**
+ * The i'th move of ply raised alpha, so it's followed by the principal
+ * variation of the next ply.
+ * @param ply int
+ * @param i index in the sorted move list
+ */
+void SearchStack::updatePV(const int ply, const unsigned int i) {
+  auto& current = this->plies[ply];
+  const auto& next = this->plies[ply + 1];
+
+  current.pv[0] = current.moves[i].move;
+  const auto len = std::min<size_t>(next.pvLength, current.pv.size() - 1);
+  std::copy(next.pv.begin(), next.pv.begin() + len, current.pv.begin() + 1);
+  current.pvLength = static_cast<uint16_t>(len + 1);
+}
+
+/**
+ * @param ply int
+ * @return the principal variation from ply and down
+ */
+std::vector<type::move_t> SearchStack::getPV(const int ply) const {
+  const auto& current = this->plies[ply];
+  return std::vector<type::move_t>(current.pv.begin(), current.pv.begin() + current.pvLength);
+}
+
+}
@@ -0,0 +1,182 @@
+#include "david/SearchStats.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace david {
+
+namespace {
+/**
+ * Share of a total, 0 when there's nothing to share.
+ */
+inline double rate(const uint64_t part, const uint64_t total) {
+  return total == 0 ? 0.0 : static_cast<double>(part) / static_cast<double>(total);
+}
+}
+
+/**
+ * Constructor
+ */
+SearchStats::SearchStats() {
+  this->start(0);
+}
+
+/**
+ * Clear all counters.
+ * @param maxPly deepest ply the nodes are counted for
+ */
+void SearchStats::start(const int maxPly) {
+  this->nodes = 0;
+  this->qnodes = 0;
+  this->evaluations = 0;
+  this->betaCutoffs = 0;
+  this->firstMoveCutoffs = 0;
+  this->ttProbes = 0;
+  this->ttHits = 0;
+  this->aspirationFailHighs = 0;
+  this->aspirationFailLows = 0;
+  this->nullMoves = 0;
+  this->nullMoveCutoffs = 0;
+  this->reductions = 0;
+  this->reductionResearches = 0;
+
+  this->nodesByPly.assign(static_cast<size_t>(maxPly + 1), 0);
+  this->iterations.clear();
+  this->nodesBeforeIteration = 0;
+}
+
+/**
+ * Copy the counters the transposition table keeps on its own.
+ */
+void SearchStats::setTranspositionTable(const uint64_t probes, const uint64_t hits) {
+  this->ttProbes = probes;
+  this->ttHits = hits;
+}
+
+/**
+ * Copy the root re-searches the aspiration windows caused.
+ */
+void SearchStats::setAspiration(const uint64_t failHighs, const uint64_t failLows) {
+  this->aspirationFailHighs = failHighs;
+  this->aspirationFailLows = failLows;
+}
+
+/**
+ * Close an iteration, the nodes counted since the last one belong to it.
+ * @param depth of the iteration
+ * @param time milliseconds since the search started
+ */
+void SearchStats::iterationComplete(const int depth, const int time) {
+  this->iterations.push_back(Iteration{depth, this->nodes - this->nodesBeforeIteration, time});
+  this->nodesBeforeIteration = this->nodes;
+}
+
+uint64_t SearchStats::getNodes() const {
+  return this->nodes;
+}
+
+uint64_t SearchStats::getQuiescenceNodes() const {
+  return this->qnodes;
+}
+
+uint64_t SearchStats::getEvaluations() const {
+  return this->evaluations;
+}
+
+uint64_t SearchStats::getBetaCutoffs() const {
+  return this->betaCutoffs;
+}
+
+uint64_t SearchStats::getFirstMoveCutoffs() const {
+  return this->firstMoveCutoffs;
+}
+
+uint64_t SearchStats::getNullMoves() const {
+  return this->nullMoves;
+}
+
+uint64_t SearchStats::getNullMoveCutoffs() const {
+  return this->nullMoveCutoffs;
+}
+
+uint64_t SearchStats::getReductions() const {
+  return this->reductions;
+}
+
+uint64_t SearchStats::getReductionResearches() const {
+  return this->reductionResearches;
+}
+
+const std::vector<SearchStats::Iteration>& SearchStats::getIterations() const {
+  return this->iterations;
+}
+
+const std::vector<uint64_t>& SearchStats::getNodesByPly() const {
+  return this->nodesByPly;
+}
+
+/**
+ * Every counter, and the rates derived from them, as one JSON object.
+ *
+ * The branching factor of an iteration is its nodes divided by the nodes of
+ * the iteration before it. A reduction succeeds when it doesn't have to be
+ * searched again at full depth.
+ *
+ * @return std::string JSON without line breaks
+ */
+std::string SearchStats::toJSON() const {
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(4);
+
+  json << "{\"nodes\":" << this->nodes
+       << ",\"qnodes\":" << this->qnodes
+       << ",\"evaluations\":" << this->evaluations;
+
+  json << ",\"iterations\":[";
+  for (size_t i = 0; i < this->iterations.size(); i++) {
+    const auto& iteration = this->iterations[i];
+    json << (i > 0 ? "," : "")
+         << "{\"depth\":" << iteration.depth
+         << ",\"nodes\":" << iteration.nodes
+         << ",\"time\":" << iteration.time
+         << ",\"branching\":" << (i > 0 ? rate(iteration.nodes, this->iterations[i - 1].nodes) : 0.0)
+         << "}";
+  }
+  json << "]";
+
+  // trailing plies that were never reached are left out
+  size_t plies = this->nodesByPly.size();
+  while (plies > 0 && this->nodesByPly[plies - 1] == 0) {
+    plies--;
+  }
+  json << ",\"nodesByPly\":[";
+  for (size_t ply = 0; ply < plies; ply++) {
+    json << (ply > 0 ? "," : "") << this->nodesByPly[ply];
+  }
+  json << "]";
+
+  json << ",\"cutoffs\":{\"beta\":" << this->betaCutoffs
+       << ",\"firstMove\":" << this->firstMoveCutoffs
+       << ",\"firstMoveRate\":" << rate(this->firstMoveCutoffs, this->betaCutoffs) << "}";
+
+  json << ",\"tt\":{\"probes\":" << this->ttProbes
+       << ",\"hits\":" << this->ttHits
+       << ",\"hitRate\":" << rate(this->ttHits, this->ttProbes) << "}";
+
+  json << ",\"nullMove\":{\"tries\":" << this->nullMoves
+       << ",\"cutoffs\":" << this->nullMoveCutoffs
+       << ",\"successRate\":" << rate(this->nullMoveCutoffs, this->nullMoves) << "}";
+
+  json << ",\"lmr\":{\"reductions\":" << this->reductions
+       << ",\"researches\":" << this->reductionResearches
+       << ",\"successRate\":" << rate(this->reductions - this->reductionResearches, this->reductions) << "}";
+
+  json << ",\"aspiration\":{\"researches\":" << (this->aspirationFailHighs + this->aspirationFailLows)
+       << ",\"failHighs\":" << this->aspirationFailHighs
+       << ",\"failLows\":" << this->aspirationFailLows << "}";
+
+  json << "}";
+  return json.str();
+}
+
+}
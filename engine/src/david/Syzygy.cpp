@@ -0,0 +1,1339 @@
+#include "david/Syzygy.h"
+#include "david/MoveGen.h"
+#include "david/utils/utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
+
+// memory mapped files
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace david {
+
+namespace {
+
+//
+// The tables use their own square numbering, a1 = 0, b1 = 1 .. h8 = 63,
+// which is the square index of the gameState mirrored along the files.
+//
+inline int fileOf(const int sq) { return sq & 7; }
+inline int rankOf(const int sq) { return sq >> 3; }
+inline int offA1H8(const int sq) { return rankOf(sq) - fileOf(sq); }
+inline int flipFile(const int sq) { return sq ^ 7; }
+inline int flipRank(const int sq) { return sq ^ 56; }
+
+// piece codes used in the files, black pieces have bit 3 set
+constexpr uint8_t PAWN   = 1;
+constexpr uint8_t KNIGHT = 2;
+constexpr uint8_t BISHOP = 3;
+constexpr uint8_t ROOK   = 4;
+constexpr uint8_t QUEEN  = 5;
+constexpr uint8_t KING   = 6;
+constexpr uint8_t BLACK  = 8;
+
+// piece code of every piece type index of the gameState
+constexpr uint8_t PIECE_CODES[6] = {PAWN, ROOK, KNIGHT, BISHOP, QUEEN, KING};
+
+constexpr uint8_t WDL_MAGIC[4] = {0x71, 0xE8, 0x23, 0x5D};
+constexpr uint8_t DTZ_MAGIC[4] = {0xD7, 0x66, 0x0C, 0xA5};
+
+// flags of a compressed table
+constexpr uint8_t FLAG_STM          = 1;   // side to move of a dtz table
+constexpr uint8_t FLAG_MAPPED       = 2;   // dtz values go through a map
+constexpr uint8_t FLAG_WIN_PLIES    = 4;   // wins are stored in plies, not moves
+constexpr uint8_t FLAG_LOSS_PLIES   = 8;   // losses are stored in plies, not moves
+constexpr uint8_t FLAG_WIDE         = 16;  // the dtz map has 16 bit values
+constexpr uint8_t FLAG_SINGLE_VALUE = 128; // every position has the same value
+
+inline uint16_t readLE16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+inline uint32_t readLE32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+      | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+inline uint32_t readBE32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16)
+      | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+inline uint64_t readBE64(const uint8_t* p) {
+  return (static_cast<uint64_t>(readBE32(p)) << 32) | readBE32(p + 4);
+}
+
+inline const uint8_t* alignWord(const uint8_t* p) {
+  return p + (reinterpret_cast<uintptr_t>(p) & 1);
+}
+
+/**
+ * Lookup tables used to turn the piece squares into an index of a table.
+ * Filled once, the first time they're needed.
+ */
+struct IndexTables {
+  int mapPawns[64];          // squares a2-h7 to 0..47, the leading pawn has the highest value
+  int mapB1H1H7[64];         // squares below the a1-h8 diagonal to 0..27
+  int mapA1D1D4[64];         // squares of the a1-d1-d4 triangle to 0..9
+  int mapKK[10][64];         // the 462 legal king pairs, the first king in the triangle
+  int binomial[6][64];       // ways to choose k of n squares
+  int leadPawnIdx[6][64];    // [leading pawns][square]
+  int leadPawnsSize[6][4];   // [leading pawns][file a..d]
+
+  IndexTables() {
+    std::fill(&mapPawns[0], &mapPawns[0] + 64, 0);
+    std::fill(&mapB1H1H7[0], &mapB1H1H7[0] + 64, 0);
+    std::fill(&mapA1D1D4[0], &mapA1D1D4[0] + 64, 0);
+    std::fill(&mapKK[0][0], &mapKK[0][0] + 10 * 64, 0);
+    std::fill(&binomial[0][0], &binomial[0][0] + 6 * 64, 0);
+    std::fill(&leadPawnIdx[0][0], &leadPawnIdx[0][0] + 6 * 64, 0);
+    std::fill(&leadPawnsSize[0][0], &leadPawnsSize[0][0] + 6 * 4, 0);
+
+    int code = 0;
+    for (int sq = 0; sq < 64; sq++) {
+      if (offA1H8(sq) < 0) {
+        mapB1H1H7[sq] = code++;
+      }
+    }
+
+    // the diagonal squares of the triangle come last
+    std::vector<int> diagonal;
+    code = 0;
+    for (int sq = 0; sq <= 27; sq++) {
+      if (offA1H8(sq) < 0 && fileOf(sq) <= 3) {
+        mapA1D1D4[sq] = code++;
+      }
+      else if (offA1H8(sq) == 0 && fileOf(sq) <= 3) {
+        diagonal.push_back(sq);
+      }
+    }
+    for (const int sq : diagonal) {
+      mapA1D1D4[sq] = code++;
+    }
+
+    //
+    // King pairs. If the first king is on the a1-d4 diagonal the other one
+    // isn't above the a1-h8 diagonal, pairs with both on it come last.
+    //
+    std::vector<std::pair<int, int>> bothOnDiagonal;
+    code = 0;
+    for (int idx = 0; idx < 10; idx++) {
+      for (int s1 = 0; s1 <= 27; s1++) {
+        if (mapA1D1D4[s1] != idx || (idx == 0 && s1 != 1)) { // b1 is mapped to 0
+          continue;
+        }
+
+        for (int s2 = 0; s2 < 64; s2++) {
+          const bool touching = std::abs(fileOf(s1) - fileOf(s2)) <= 1 && std::abs(rankOf(s1) - rankOf(s2)) <= 1;
+          if (touching) {
+            continue;
+          }
+          else if (offA1H8(s1) == 0 && offA1H8(s2) > 0) {
+            continue;
+          }
+          else if (offA1H8(s1) == 0 && offA1H8(s2) == 0) {
+            bothOnDiagonal.emplace_back(idx, s2);
+          }
+          else {
+            mapKK[idx][s2] = code++;
+          }
+        }
+      }
+    }
+    for (const auto& pair : bothOnDiagonal) {
+      mapKK[pair.first][pair.second] = code++;
+    }
+
+    binomial[0][0] = 1;
+    for (int n = 1; n < 64; n++) {
+      for (int k = 0; k < 6 && k <= n; k++) {
+        binomial[k][n] = (k > 0 ? binomial[k - 1][n - 1] : 0) + (k < n ? binomial[k][n - 1] : 0);
+      }
+    }
+
+    //
+    // Leading pawns. Every file a..d has its own table, so the index starts
+    // over for each file, from the leading pawn on rank 2 and up.
+    //
+    int availableSquares = 47;
+    for (int leadPawnsCnt = 1; leadPawnsCnt <= 5; leadPawnsCnt++) {
+      for (int file = 0; file <= 3; file++) {
+        int idx = 0;
+        for (int rank = 1; rank <= 6; rank++) {
+          const int sq = rank * 8 + file;
+          if (leadPawnsCnt == 1) {
+            mapPawns[sq] = availableSquares--;
+            mapPawns[flipFile(sq)] = availableSquares--;
+          }
+          leadPawnIdx[leadPawnsCnt][sq] = idx;
+          idx += binomial[leadPawnsCnt - 1][mapPawns[sq]];
+        }
+        leadPawnsSize[leadPawnsCnt][file] = idx;
+      }
+    }
+  }
+};
+
+const IndexTables& indexTables() {
+  static const IndexTables tables;
+  return tables;
+}
+
+/**
+ * Decoding data of one compressed table. A file has one for every side to
+ * move it stores, and for every file of the leading pawn.
+ */
+struct PairsData {
+  uint8_t flags = 0;
+  uint64_t sizeofBlock = 0;                 // bytes of a compressed block
+  uint64_t span = 0;                        // positions between two sparse index entries
+  uint32_t numBlocks = 0;
+  int maxSymLen = 0;                        // longest huffman symbol, in bits
+  int minSymLen = 0;                        // shortest huffman symbol, or the value of a single value table
+  const uint8_t* lowestSym = nullptr;       // lowest symbol of every length, 16 bit
+  const uint8_t* btree = nullptr;           // the two symbols every symbol expands to, 3 bytes each
+  const uint8_t* blockLength = nullptr;     // positions in every block minus one, 16 bit
+  uint64_t blockLengthSize = 0;
+  const uint8_t* sparseIndex = nullptr;     // block and offset of every span, 6 bytes each
+  uint64_t sparseIndexSize = 0;
+  const uint8_t* data = nullptr;            // the compressed blocks
+  std::vector<uint64_t> base64;             // lowest symbol of every length, padded to 64 bits
+  std::vector<uint8_t> symlen;              // values a symbol expands to, minus one
+  uint8_t pieces[Syzygy::MAX_PIECES] = {};  // piece codes in the order they're encoded
+  uint64_t groupIdx[Syzygy::MAX_PIECES + 1] = {};
+  int groupLen[Syzygy::MAX_PIECES + 1] = {};
+  uint16_t mapIdx[4] = {};                  // dtz map offsets of win, loss, cursed win and blessed loss
+
+  inline uint16_t left(const uint16_t sym) const {
+    return static_cast<uint16_t>(((this->btree[3 * sym + 1] & 0xF) << 8) | this->btree[3 * sym]);
+  }
+  inline uint16_t right(const uint16_t sym) const {
+    return static_cast<uint16_t>((this->btree[3 * sym + 2] << 4) | (this->btree[3 * sym + 1] >> 4));
+  }
+};
+
+/**
+ * A file mapped into memory, unmapped when destroyed.
+ */
+struct MappedFile {
+  void* address = nullptr;
+  size_t size = 0;
+
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  void operator=(const MappedFile&) = delete;
+  ~MappedFile() {
+    if (this->address != nullptr) {
+      munmap(this->address, this->size);
+    }
+  }
+
+  /**
+   * Map a table file and check its magic number.
+   * @param path file to map
+   * @param magic the four first bytes of the file
+   * @return the data after the magic number, nullptr if the file is missing or broken
+   */
+  const uint8_t* map(const std::string& path, const uint8_t* magic) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+      return nullptr;
+    }
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) != 0 || statbuf.st_size % 64 != 16) {
+      ::close(fd);
+      return nullptr;
+    }
+
+    this->size = static_cast<size_t>(statbuf.st_size);
+    void* address = mmap(nullptr, this->size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+      return nullptr;
+    }
+    this->address = address;
+
+    const auto data = static_cast<const uint8_t*>(this->address);
+    if (!std::equal(magic, magic + 4, data)) {
+      return nullptr;
+    }
+
+    return data + 4;
+  }
+};
+
+/**
+ * Material of a position, the number of every piece code in 4 bits each.
+ */
+inline uint64_t materialKey(const int (&counts)[16]) {
+  uint64_t key = 0;
+  for (uint64_t code = 0; code < 16; code++) {
+    key |= static_cast<uint64_t>(counts[code]) << (4 * code);
+  }
+
+  return key;
+}
+
+/**
+ * A position converted to the squares and piece codes of the tables.
+ */
+struct Position {
+  uint8_t board[64] = {};
+  type::bitboard_t pieces[16] = {};
+  type::bitboard_t occupied = 0;
+  int stm = 0; // 0 white, 1 black
+  uint64_t key = 0;
+
+  explicit Position(const type::gameState_t& gs) {
+    this->stm = gs.isWhite ? 0 : 1;
+
+    int counts[16] = {};
+    for (int side = 0; side < 2; side++) {
+      const int colour = side == 0 ? this->stm : 1 - this->stm;
+      for (int pieceType = 0; pieceType < 6; pieceType++) {
+        const uint8_t code = PIECE_CODES[pieceType] | (colour == 1 ? BLACK : 0);
+        for (type::bitboard_t b = gs.piecesArr[pieceType][side]; b != 0; b &= b - 1) {
+          const int sq = flipFile(::utils::LSB(b));
+          this->board[sq] = code;
+          this->pieces[code] |= 1ULL << sq;
+          counts[code] += 1;
+        }
+      }
+    }
+
+    this->occupied = gs.piecess[0] | gs.piecess[1];
+    this->key = materialKey(counts);
+  }
+};
+
+inline bool isCapture(const type::gameState_t& parent, const type::gameState_t& child) {
+  // the colour index is swapped in the child
+  return ::utils::nrOfActiveBits(parent.piecess[1]) != ::utils::nrOfActiveBits(child.piecess[0]);
+}
+
+inline bool isPawnMove(const type::gameState_t& parent, const type::gameState_t& child) {
+  return parent.piecesArr[constant::index::pawn][0] != child.piecesArr[constant::index::pawn][1];
+}
+
+inline bool isInCheck(const type::gameState_t& gs) {
+  type::gameState_t node = gs;
+  return MoveGen{node}.isInCheck();
+}
+
+inline int signOf(const int value) {
+  return (value > 0) - (value < 0);
+}
+
+/**
+ * Distance to zeroing of a position whose best move is a capture or pawn move.
+ */
+inline int dtzBeforeZeroing(const int wdl) {
+  return wdl == Syzygy::WIN          ? 1
+       : wdl == Syzygy::CURSED_WIN   ? 101
+       : wdl == Syzygy::BLESSED_LOSS ? -101
+       : wdl == Syzygy::LOSS         ? -1
+       : 0;
+}
+
+} // anonymous namespace
+
+/**
+ * One material combination, like KRvK, and both of its files.
+ */
+struct Syzygy::Table {
+  std::string name;
+  std::string wdlPath;
+  std::string dtzPath; // empty without a .rtbz file
+  uint64_t key;        // white has the pieces left of the 'v'
+  uint64_t key2;       // black has the pieces left of the 'v'
+  int pieceCount;
+  bool hasPawns;
+  bool hasUniquePieces;
+  int pawnCount[2];    // pawns of the leading colour, and of the other one
+
+  // the files are mapped and parsed the first time they are probed
+  std::mutex mutex;
+  std::atomic<bool> wdlReady{false};
+  std::atomic<bool> dtzReady{false};
+  bool wdlFailed = false;
+  bool dtzFailed = false;
+  MappedFile wdlFile;
+  MappedFile dtzFile;
+
+  PairsData wdl[2][4]; // [side to move][file of the leading pawn]
+  PairsData dtz[4];    // dtz files only store one side to move
+  const uint8_t* dtzMap = nullptr;
+
+  PairsData* get(const bool isDTZ, const int stm, const int file) {
+    const int f = this->hasPawns ? file : 0;
+    return isDTZ ? &this->dtz[f] : &this->wdl[stm & 1][f];
+  }
+};
+
+namespace {
+
+/**
+ * Split the pieces of a table into groups, and find the factor every group
+ * is multiplied with in the index of a position.
+ */
+void setGroups(const Syzygy::Table& e, PairsData* d, const int order[2], const int file) {
+  const auto& tables = indexTables();
+
+  int n = 0;
+  int firstLen = e.hasPawns ? 0 : e.hasUniquePieces ? 3 : 2;
+  d->groupLen[n] = 1;
+
+  // equal pieces that follow each other are one group, the leading group may be bigger
+  for (int i = 1; i < e.pieceCount; i++) {
+    if (--firstLen > 0 || d->pieces[i] == d->pieces[i - 1]) {
+      d->groupLen[n]++;
+    }
+    else {
+      d->groupLen[++n] = 1;
+    }
+  }
+  d->groupLen[++n] = 0;
+
+  //
+  // The groups aren't encoded in the order of pieces[], order[0] is the
+  // position of the leading group and order[1] the one of the remaining
+  // pawns, when both colours have pawns.
+  //
+  const bool pp = e.hasPawns && e.pawnCount[1] > 0;
+  int next = pp ? 2 : 1;
+  int freeSquares = 64 - d->groupLen[0] - (pp ? d->groupLen[1] : 0);
+  uint64_t idx = 1;
+
+  for (int k = 0; next < n || k == order[0] || k == order[1]; k++) {
+    if (k == order[0]) {
+      d->groupIdx[0] = idx;
+      idx *= e.hasPawns ? tables.leadPawnsSize[d->groupLen[0]][file]
+          : e.hasUniquePieces ? 31332 : 462;
+    }
+    else if (k == order[1]) {
+      d->groupIdx[1] = idx;
+      idx *= tables.binomial[d->groupLen[1]][48 - d->groupLen[0]];
+    }
+    else {
+      d->groupIdx[next] = idx;
+      idx *= tables.binomial[d->groupLen[next]][freeSquares];
+      freeSquares -= d->groupLen[next++];
+    }
+  }
+
+  d->groupIdx[n] = idx;
+}
+
+/**
+ * Number of values a symbol expands to, minus one.
+ */
+uint8_t setSymlen(PairsData* d, const uint16_t sym, std::vector<bool>& visited) {
+  visited[sym] = true;
+
+  const uint16_t right = d->right(sym);
+  if (right == 0xFFF) {
+    return 0;
+  }
+
+  const uint16_t left = d->left(sym);
+  if (left >= d->symlen.size() || right >= d->symlen.size()) {
+    return 0; // broken file
+  }
+
+  if (!visited[left]) {
+    d->symlen[left] = setSymlen(d, left, visited);
+  }
+  if (!visited[right]) {
+    d->symlen[right] = setSymlen(d, right, visited);
+  }
+
+  return static_cast<uint8_t>(d->symlen[left] + d->symlen[right] + 1);
+}
+
+/**
+ * Read the header of a compressed table, the block sizes and the canonical
+ * huffman code.
+ * @return the data after the header
+ */
+const uint8_t* setSizes(PairsData* d, const uint8_t* data) {
+  d->flags = *data++;
+
+  if (d->flags & FLAG_SINGLE_VALUE) {
+    d->numBlocks = 0;
+    d->span = 0;
+    d->blockLengthSize = 0;
+    d->sparseIndexSize = 0;
+    d->minSymLen = *data++; // the value of every position
+    return data;
+  }
+
+  // the last group factor is the number of positions in the table
+  int groups = 0;
+  while (groups < Syzygy::MAX_PIECES && d->groupLen[groups] != 0) {
+    groups++;
+  }
+  const uint64_t tbSize = d->groupIdx[groups];
+
+  d->sizeofBlock = 1ULL << *data++;
+  d->span = 1ULL << *data++;
+  d->sparseIndexSize = (tbSize + d->span - 1) / d->span;
+  const uint8_t padding = *data++;
+  d->numBlocks = readLE32(data);
+  data += 4;
+  d->blockLengthSize = d->numBlocks + padding; // so the sparse index never points past the end
+  d->maxSymLen = *data++;
+  d->minSymLen = *data++;
+  d->lowestSym = data;
+
+  //
+  // Longer symbols have lower values in a canonical huffman code, so the
+  // length of a symbol at the front of a 64 bit buffer is found by comparing
+  // it to the lowest symbol of every length, padded to 64 bits.
+  //
+  d->base64.assign(static_cast<size_t>(std::max(d->maxSymLen - d->minSymLen + 1, 1)), 0);
+  for (int i = static_cast<int>(d->base64.size()) - 2; i >= 0; i--) {
+    d->base64[i] = (d->base64[i + 1] + readLE16(d->lowestSym + 2 * i) - readLE16(d->lowestSym + 2 * (i + 1))) / 2;
+  }
+  for (size_t i = 0; i < d->base64.size(); i++) {
+    d->base64[i] <<= 64 - i - d->minSymLen;
+  }
+  data += d->base64.size() * 2;
+
+  d->symlen.assign(readLE16(data), 0);
+  data += 2;
+  d->btree = data;
+
+  // symbols are pairs of other symbols, recursive pairing
+  std::vector<bool> visited(d->symlen.size());
+  for (size_t sym = 0; sym < d->symlen.size(); sym++) {
+    if (!visited[sym]) {
+      d->symlen[sym] = setSymlen(d, static_cast<uint16_t>(sym), visited);
+    }
+  }
+
+  return data + d->symlen.size() * 3 + (d->symlen.size() & 1);
+}
+
+/**
+ * DTZ files can map the stored values to the real distances, one map for
+ * every outcome.
+ * @return the data after the maps
+ */
+const uint8_t* setDTZMap(Syzygy::Table& e, const uint8_t* data, const int maxFile) {
+  e.dtzMap = data;
+
+  for (int f = 0; f <= maxFile; f++) {
+    auto d = e.get(true, 0, f);
+    if ((d->flags & FLAG_MAPPED) == 0) {
+      continue;
+    }
+
+    if (d->flags & FLAG_WIDE) {
+      data = alignWord(data);
+      for (int i = 0; i < 4; i++) {
+        d->mapIdx[i] = static_cast<uint16_t>((data - e.dtzMap) / 2 + 1);
+        data += 2 * readLE16(data) + 2;
+      }
+    }
+    else {
+      for (int i = 0; i < 4; i++) {
+        d->mapIdx[i] = static_cast<uint16_t>(data - e.dtzMap + 1);
+        data += *data + 1;
+      }
+    }
+  }
+
+  return alignWord(data);
+}
+
+/**
+ * Parse a mapped file, and point every PairsData to its part of it.
+ * @param e table
+ * @param isDTZ which of the two files
+ * @param data the file, after the magic number
+ */
+void setup(Syzygy::Table& e, const bool isDTZ, const uint8_t* data) {
+  data++; // split and has pawns flags, known from the name
+
+  const int sides = !isDTZ && e.key != e.key2 ? 2 : 1;
+  const int maxFile = e.hasPawns ? 3 : 0;
+  const bool pp = e.hasPawns && e.pawnCount[1] > 0;
+
+  for (int f = 0; f <= maxFile; f++) {
+    for (int i = 0; i < sides; i++) {
+      *e.get(isDTZ, i, f) = PairsData();
+    }
+
+    const int order[2][2] = {
+        {*data & 0xF, pp ? *(data + 1) & 0xF : 0xF},
+        {*data >> 4, pp ? *(data + 1) >> 4 : 0xF}
+    };
+    data += 1 + (pp ? 1 : 0);
+
+    for (int k = 0; k < e.pieceCount; k++, data++) {
+      for (int i = 0; i < sides; i++) {
+        e.get(isDTZ, i, f)->pieces[k] = static_cast<uint8_t>(i ? *data >> 4 : *data & 0xF);
+      }
+    }
+
+    for (int i = 0; i < sides; i++) {
+      setGroups(e, e.get(isDTZ, i, f), order[i], f);
+    }
+  }
+
+  data = alignWord(data);
+
+  for (int f = 0; f <= maxFile; f++) {
+    for (int i = 0; i < sides; i++) {
+      data = setSizes(e.get(isDTZ, i, f), data);
+    }
+  }
+
+  if (isDTZ) {
+    data = setDTZMap(e, data, maxFile);
+  }
+
+  for (int f = 0; f <= maxFile; f++) {
+    for (int i = 0; i < sides; i++) {
+      auto d = e.get(isDTZ, i, f);
+      d->sparseIndex = data;
+      data += d->sparseIndexSize * 6;
+    }
+  }
+
+  for (int f = 0; f <= maxFile; f++) {
+    for (int i = 0; i < sides; i++) {
+      auto d = e.get(isDTZ, i, f);
+      d->blockLength = data;
+      data += d->blockLengthSize * 2;
+    }
+  }
+
+  for (int f = 0; f <= maxFile; f++) {
+    for (int i = 0; i < sides; i++) {
+      data = reinterpret_cast<const uint8_t*>((reinterpret_cast<uintptr_t>(data) + 0x3F) & ~uintptr_t(0x3F));
+      auto d = e.get(isDTZ, i, f);
+      d->data = data;
+      data += d->numBlocks * d->sizeofBlock;
+    }
+  }
+}
+
+/**
+ * Map and parse a file of a table the first time it's needed.
+ * @return false if the file is missing or broken
+ */
+bool ensureMapped(Syzygy::Table& e, const bool isDTZ) {
+  auto& ready = isDTZ ? e.dtzReady : e.wdlReady;
+  if (ready.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock(e.mutex);
+  if (ready.load(std::memory_order_relaxed)) {
+    return true;
+  }
+
+  bool& failed = isDTZ ? e.dtzFailed : e.wdlFailed;
+  const std::string& path = isDTZ ? e.dtzPath : e.wdlPath;
+  if (failed || path.empty()) {
+    return false;
+  }
+
+  const uint8_t* data = (isDTZ ? e.dtzFile : e.wdlFile).map(path, isDTZ ? DTZ_MAGIC : WDL_MAGIC);
+  if (data == nullptr) {
+    failed = true;
+    return false;
+  }
+
+  setup(e, isDTZ, data);
+  ready.store(true, std::memory_order_release);
+  return true;
+}
+
+/**
+ * Find the value stored at an index of a compressed table.
+ *
+ * Every block stores blockLength + 1 values. The sparse index has the block
+ * and offset of every span'th value, so only a few blocks have to be walked
+ * to find the one holding idx. Inside the block the huffman symbols are
+ * read until the one covering idx, and it's expanded pair by pair.
+ */
+int decompressPairs(const PairsData* d, const uint64_t idx) {
+  if (d->flags & FLAG_SINGLE_VALUE) {
+    return d->minSymLen;
+  }
+
+  const uint64_t k = idx / d->span;
+  const uint8_t* entry = d->sparseIndex + 6 * k;
+  uint32_t block = readLE32(entry);
+  int offset = readLE16(entry + 4);
+
+  // the sparse index entry points at the middle of its span
+  offset += static_cast<int>(idx % d->span) - static_cast<int>(d->span / 2);
+
+  while (offset < 0) {
+    offset += readLE16(d->blockLength + 2 * (--block)) + 1;
+  }
+  while (offset > readLE16(d->blockLength + 2 * block)) {
+    offset -= readLE16(d->blockLength + 2 * (block++)) + 1;
+  }
+
+  const uint8_t* ptr = d->data + static_cast<uint64_t>(block) * d->sizeofBlock;
+  uint64_t buf64 = readBE64(ptr);
+  ptr += 8;
+  int buf64Size = 64;
+  uint16_t sym;
+
+  while (true) {
+    // symbol length, minus the shortest one
+    int len = 0;
+    while (buf64 < d->base64[len]) {
+      len++;
+    }
+
+    // symbols of the same length are consecutive
+    sym = static_cast<uint16_t>((buf64 - d->base64[len]) >> (64 - len - d->minSymLen));
+    sym = static_cast<uint16_t>(sym + readLE16(d->lowestSym + 2 * len));
+
+    if (offset < d->symlen[sym] + 1) {
+      break;
+    }
+
+    offset -= d->symlen[sym] + 1;
+    len += d->minSymLen;
+    buf64 <<= len;
+    buf64Size -= len;
+
+    if (buf64Size <= 32) {
+      buf64Size += 32;
+      buf64 |= static_cast<uint64_t>(readBE32(ptr)) << (64 - buf64Size);
+      ptr += 4;
+    }
+  }
+
+  // expand the symbol until the single value at offset is left
+  while (d->symlen[sym] != 0) {
+    const uint16_t left = d->left(sym);
+    if (offset < d->symlen[left] + 1) {
+      sym = left;
+    }
+    else {
+      offset -= d->symlen[left] + 1;
+      sym = d->right(sym);
+    }
+  }
+
+  return d->left(sym);
+}
+
+/**
+ * Turn a value of a dtz table into plies.
+ */
+int mapDTZ(Syzygy::Table& e, const int file, int value, const int wdl) {
+  static const int WDL_MAP[] = {1, 3, 0, 2, 0};
+
+  const auto d = e.get(true, 0, file);
+  if (d->flags & FLAG_MAPPED) {
+    const int idx = d->mapIdx[WDL_MAP[wdl + 2]] + value;
+    value = (d->flags & FLAG_WIDE) ? readLE16(e.dtzMap + 2 * idx) : e.dtzMap[idx];
+  }
+
+  if ((wdl == Syzygy::WIN && !(d->flags & FLAG_WIN_PLIES))
+      || (wdl == Syzygy::LOSS && !(d->flags & FLAG_LOSS_PLIES))
+      || wdl == Syzygy::CURSED_WIN
+      || wdl == Syzygy::BLESSED_LOSS) {
+    value *= 2;
+  }
+
+  return value + 1;
+}
+
+/**
+ * Index of the position in a table, and the value stored there.
+ *
+ * The tables are stored with white as the stronger side, so the colours
+ * are swapped when black is stronger. The board is mirrored so the leading
+ * pawn is on the a-d files, or for tables without pawns so the leading
+ * piece is in the a1-d1-d4 triangle.
+ */
+int doProbeTable(const Position& pos, Syzygy::Table& e, const bool isDTZ, const int wdl, bool& changeSTM) {
+  const auto& tables = indexTables();
+  const auto mapPawnsLess = [&tables](const int a, const int b) {
+    return tables.mapPawns[a] < tables.mapPawns[b];
+  };
+
+  int squares[Syzygy::MAX_PIECES];
+  uint8_t pieces[Syzygy::MAX_PIECES];
+  int size = 0;
+  int leadPawnsCnt = 0;
+  type::bitboard_t leadPawns = 0;
+  int tbFile = 0;
+  uint64_t idx;
+
+  // symmetric tables only store white to move, and every table has white as the stronger side
+  const bool symmetricBlackToMove = e.key == e.key2 && pos.stm == 1;
+  const bool blackStronger = pos.key != e.key;
+  const bool flip = symmetricBlackToMove || blackStronger;
+  const uint8_t flipColour = flip ? BLACK : 0;
+  const int flipSquares = flip ? 56 : 0;
+  const int stm = (flip ? 1 : 0) ^ pos.stm;
+
+  //
+  // The leading pawns all have the colour of the first piece, and the one
+  // closest to the edge decides which of the four file tables is used.
+  //
+  if (e.hasPawns) {
+    const uint8_t pawn = e.get(isDTZ, 0, 0)->pieces[0] ^ flipColour;
+    leadPawns = pos.pieces[pawn];
+    for (type::bitboard_t b = leadPawns; b != 0; b &= b - 1) {
+      squares[size++] = ::utils::LSB(b) ^ flipSquares;
+    }
+    leadPawnsCnt = size;
+
+    std::swap(squares[0], *std::max_element(squares, squares + leadPawnsCnt, mapPawnsLess));
+    tbFile = std::min(fileOf(squares[0]), 7 - fileOf(squares[0]));
+  }
+
+  // dtz files only store one side to move
+  if (isDTZ && (e.get(true, stm, tbFile)->flags & FLAG_STM) != stm && !(e.key == e.key2 && !e.hasPawns)) {
+    changeSTM = true;
+    return 0;
+  }
+
+  for (type::bitboard_t b = pos.occupied ^ leadPawns; b != 0; b &= b - 1) {
+    const int sq = ::utils::LSB(b);
+    squares[size] = sq ^ flipSquares;
+    pieces[size++] = pos.board[sq] ^ flipColour;
+  }
+
+  const PairsData* d = e.get(isDTZ, stm, tbFile);
+
+  // put the pieces in the order of the table
+  for (int i = leadPawnsCnt; i < size - 1; i++) {
+    for (int j = i + 1; j < size; j++) {
+      if (d->pieces[i] == pieces[j]) {
+        std::swap(pieces[i], pieces[j]);
+        std::swap(squares[i], squares[j]);
+        break;
+      }
+    }
+  }
+
+  if (fileOf(squares[0]) > 3) {
+    for (int i = 0; i < size; i++) {
+      squares[i] = flipFile(squares[i]);
+    }
+  }
+
+  if (e.hasPawns) {
+    idx = static_cast<uint64_t>(tables.leadPawnIdx[leadPawnsCnt][squares[0]]);
+
+    std::stable_sort(squares + 1, squares + leadPawnsCnt, mapPawnsLess);
+    for (int i = 1; i < leadPawnsCnt; i++) {
+      idx += tables.binomial[i][tables.mapPawns[squares[i]]];
+    }
+  }
+  else {
+    if (rankOf(squares[0]) > 3) {
+      for (int i = 0; i < size; i++) {
+        squares[i] = flipRank(squares[i]);
+      }
+    }
+
+    // the first piece of the leading group off the a1-h8 diagonal goes below it
+    for (int i = 0; i < d->groupLen[0]; i++) {
+      if (offA1H8(squares[i]) == 0) {
+        continue;
+      }
+
+      if (offA1H8(squares[i]) > 0) {
+        for (int j = i; j < size; j++) {
+          squares[j] = ((squares[j] >> 3) | (squares[j] << 3)) & 63;
+        }
+      }
+      break;
+    }
+
+    //
+    // Three unique pieces, kings included, are encoded together. Squares
+    // after an earlier piece of the group are moved down, since two pieces
+    // can't share a square. Otherwise only the kings are encoded, as one of
+    // the 462 legal king pairs.
+    //
+    if (e.hasUniquePieces) {
+      const int adjust1 = squares[1] > squares[0];
+      const int adjust2 = (squares[2] > squares[0]) + (squares[2] > squares[1]);
+
+      if (offA1H8(squares[0]) != 0) {
+        idx = static_cast<uint64_t>((tables.mapA1D1D4[squares[0]] * 63 + (squares[1] - adjust1)) * 62
+            + squares[2] - adjust2);
+      }
+      else if (offA1H8(squares[1]) != 0) {
+        idx = static_cast<uint64_t>((6 * 63 + rankOf(squares[0]) * 28 + tables.mapB1H1H7[squares[1]]) * 62
+            + squares[2] - adjust2);
+      }
+      else if (offA1H8(squares[2]) != 0) {
+        idx = static_cast<uint64_t>(6 * 63 * 62 + 4 * 28 * 62
+            + rankOf(squares[0]) * 7 * 28
+            + (rankOf(squares[1]) - adjust1) * 28
+            + tables.mapB1H1H7[squares[2]]);
+      }
+      else {
+        idx = static_cast<uint64_t>(6 * 63 * 62 + 4 * 28 * 62 + 4 * 7 * 28
+            + rankOf(squares[0]) * 7 * 6
+            + (rankOf(squares[1]) - adjust1) * 6
+            + (rankOf(squares[2]) - adjust2));
+      }
+    }
+    else {
+      idx = static_cast<uint64_t>(tables.mapKK[tables.mapA1D1D4[squares[0]]][squares[1]]);
+    }
+  }
+
+  //
+  // The remaining groups, sorted by square. A square is moved down for every
+  // piece of the earlier groups on a lower square.
+  //
+  idx *= d->groupIdx[0];
+  int* groupSq = squares + d->groupLen[0];
+  bool remainingPawns = e.hasPawns && e.pawnCount[1] > 0;
+
+  for (int next = 1; d->groupLen[next] != 0; next++) {
+    std::stable_sort(groupSq, groupSq + d->groupLen[next]);
+
+    uint64_t n = 0;
+    for (int i = 0; i < d->groupLen[next]; i++) {
+      const int sq = groupSq[i];
+      const auto adjust = std::count_if(squares, groupSq, [sq](const int s) { return sq > s; });
+      n += tables.binomial[i + 1][sq - adjust - (remainingPawns ? 8 : 0)];
+    }
+
+    remainingPawns = false;
+    idx += n * d->groupIdx[next];
+    groupSq += d->groupLen[next];
+  }
+
+  const int value = decompressPairs(d, idx);
+  return isDTZ ? mapDTZ(e, tbFile, value, wdl) : value - 2;
+}
+
+/**
+ * Piece counts of one side of a table name, like "KRP".
+ * @return false if the name has other letters, or not exactly one king
+ */
+bool parseSide(const std::string& side, const bool black, int (&counts)[16]) {
+  int kings = 0;
+  for (const char c : side) {
+    uint8_t code;
+    switch (c) {
+      case 'P': code = PAWN; break;
+      case 'N': code = KNIGHT; break;
+      case 'B': code = BISHOP; break;
+      case 'R': code = ROOK; break;
+      case 'Q': code = QUEEN; break;
+      case 'K': code = KING; kings++; break;
+      default: return false;
+    }
+    counts[code | (black ? BLACK : 0)] += 1;
+  }
+
+  return kings == 1;
+}
+
+bool fileExists(const std::string& path) {
+  struct stat statbuf;
+  return stat(path.c_str(), &statbuf) == 0 && S_ISREG(statbuf.st_mode);
+}
+
+} // anonymous namespace
+
+
+/**
+ * Constructor
+ */
+Syzygy::Syzygy()
+    : maxPieces(0)
+{}
+
+Syzygy::~Syzygy() = default;
+
+/**
+ * Forget the current tables, and register the ones found in a list of
+ * folders. Nothing is read until a table is probed.
+ * @param paths folders separated by ':', or ';' on windows, "<empty>" for none
+ * @return number of win/draw/loss tables found
+ */
+unsigned int Syzygy::init(const std::string& paths) {
+  this->clear();
+
+  if (paths.empty() || paths == "<empty>") {
+    return 0;
+  }
+
+#ifdef _WIN32
+  const char separator = ';';
+#else
+  const char separator = ':';
+#endif
+
+  std::vector<std::string> folders;
+  size_t start = 0;
+  while (start <= paths.size()) {
+    const size_t end = std::min(paths.find(separator, start), paths.size());
+    if (end > start) {
+      folders.push_back(paths.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+
+  // the names are sorted, so the tables are registered in the same order every time
+  std::set<std::string> names;
+  for (const auto& folder : folders) {
+    DIR* dir = opendir(folder.c_str());
+    if (dir == nullptr) {
+      continue;
+    }
+
+    while (const dirent* entry = readdir(dir)) {
+      const std::string file = entry->d_name;
+      if (file.size() > 5 && file.compare(file.size() - 5, 5, ".rtbw") == 0) {
+        names.insert(file.substr(0, file.size() - 5));
+      }
+    }
+    closedir(dir);
+  }
+
+  for (const auto& name : names) {
+    this->addTable(name, folders);
+  }
+
+  return this->size();
+}
+
+/**
+ * Register the table of a name like KRPvKR, if it's a valid one.
+ * @param name material of the table
+ * @param folders where the files are looked for, the first one found is used
+ */
+void Syzygy::addTable(const std::string& name, const std::vector<std::string>& folders) {
+  const size_t v = name.find('v');
+  if (v == std::string::npos || name.find('v', v + 1) != std::string::npos) {
+    return;
+  }
+
+  int counts[16] = {};
+  if (!parseSide(name.substr(0, v), false, counts) || !parseSide(name.substr(v + 1), true, counts)) {
+    return;
+  }
+
+  const int pieceCount = static_cast<int>(name.size()) - 1;
+  if (pieceCount > MAX_PIECES) {
+    return;
+  }
+
+  int swapped[16] = {};
+  for (int code = 0; code < 8; code++) {
+    swapped[code] = counts[code | BLACK];
+    swapped[code | BLACK] = counts[code];
+  }
+
+  auto table = std::unique_ptr<Table>(new Table());
+  table->name = name;
+  table->key = materialKey(counts);
+  table->key2 = materialKey(swapped);
+  table->pieceCount = pieceCount;
+  table->hasPawns = counts[PAWN] + counts[PAWN | BLACK] > 0;
+
+  table->hasUniquePieces = false;
+  for (int code = PAWN; code < KING; code++) {
+    if (counts[code] == 1 || counts[code | BLACK] == 1) {
+      table->hasUniquePieces = true;
+    }
+  }
+
+  // the colour with the fewest pawns leads, it compresses better
+  const bool whiteLeads = counts[PAWN | BLACK] == 0 || (counts[PAWN] > 0 && counts[PAWN | BLACK] >= counts[PAWN]);
+  table->pawnCount[0] = whiteLeads ? counts[PAWN] : counts[PAWN | BLACK];
+  table->pawnCount[1] = whiteLeads ? counts[PAWN | BLACK] : counts[PAWN];
+
+  for (const auto& folder : folders) {
+    const std::string base = folder + "/" + name;
+    if (table->wdlPath.empty() && fileExists(base + ".rtbw")) {
+      table->wdlPath = base + ".rtbw";
+    }
+    if (table->dtzPath.empty() && fileExists(base + ".rtbz")) {
+      table->dtzPath = base + ".rtbz";
+    }
+  }
+
+  if (table->wdlPath.empty() || this->tablesByKey.count(table->key) > 0) {
+    return;
+  }
+
+  this->tablesByKey[table->key] = table.get();
+  this->tablesByKey[table->key2] = table.get();
+  this->maxPieces = std::max(this->maxPieces, pieceCount);
+  this->tables.push_back(std::move(table));
+}
+
+/**
+ * Unregister and unmap every table.
+ */
+void Syzygy::clear() {
+  this->tablesByKey.clear();
+  this->tables.clear();
+  this->maxPieces = 0;
+}
+
+unsigned int Syzygy::size() const {
+  return static_cast<unsigned int>(this->tables.size());
+}
+
+int Syzygy::getMaxPieces() const {
+  return this->maxPieces;
+}
+
+int Syzygy::nrOfPieces(const type::gameState_t& gs) {
+  return ::utils::nrOfActiveBits(gs.piecess[0] | gs.piecess[1]);
+}
+
+/**
+ * Check if a position can be in the tables: not too many pieces and no castling rights.
+ * @param gs gameState_t&
+ * @return true if a probe might succeed
+ */
+bool Syzygy::canProbe(const type::gameState_t& gs) const {
+  return !this->tables.empty()
+      && nrOfPieces(gs) <= this->maxPieces
+      && !gs.kingCastlings[0] && !gs.kingCastlings[1]
+      && !gs.queenCastlings[0] && !gs.queenCastlings[1];
+}
+
+/**
+ * Win, draw or loss of the side to move.
+ * @param gs position to probe
+ * @param wdl set to a value of WDL
+ * @return false if the position isn't in the tables
+ */
+bool Syzygy::probeWDL(const type::gameState_t& gs, int& wdl) {
+  ProbeState result = OK;
+  wdl = this->search(gs, false, 0, result);
+  return result != FAIL;
+}
+
+/**
+ * Distance to zeroing, the plies until the next capture or pawn move of
+ * the best line.
+ * @param gs position to probe
+ * @param dtz set to the distance in plies
+ * @return false if the position isn't in the tables
+ */
+bool Syzygy::probeDTZ(const type::gameState_t& gs, int& dtz) {
+  ProbeState result = OK;
+  dtz = this->probeDTZ(gs, 0, result);
+  return result != FAIL;
+}
+
+/**
+ * Distance to zeroing after a move, counted from the position before it.
+ * @param parent position the move is played from
+ * @param child position after the move
+ * @param dtz set to the distance in plies, from the side that moved
+ * @return false if the position isn't in the tables
+ */
+bool Syzygy::probeMove(const type::gameState_t& parent, const type::gameState_t& child, int& dtz) {
+  ProbeState result = OK;
+
+  if (isCapture(parent, child) || isPawnMove(parent, child)) {
+    dtz = dtzBeforeZeroing(-this->search(child, false, 0, result));
+  }
+  else {
+    dtz = -this->probeDTZ(child, 0, result);
+    dtz = dtz > 0 ? dtz + 1 : dtz < 0 ? dtz - 1 : 0;
+  }
+
+  // a mate ends the game right away
+  if (dtz == 2 && isInCheck(child) && this->generateMoves(child, 0) == 0) {
+    dtz = 1;
+  }
+
+  return result != FAIL;
+}
+
+/**
+ * Children of a position, written to the buffer of a recursion level.
+ * @return number of children
+ */
+uint16_t Syzygy::generateMoves(const type::gameState_t& gs, const unsigned int level) {
+  auto& children = this->buffer(level);
+  type::gameState_t node = gs;
+  MoveGen gen{node};
+  return gen.generateGameStates(children, 0, constant::MAXMOVES - 1);
+}
+
+Syzygy::moves_t& Syzygy::buffer(const unsigned int level) {
+  while (this->buffers.size() <= level) {
+    this->buffers.emplace_back(new moves_t());
+  }
+
+  return *this->buffers[level];
+}
+
+/**
+ * Read the value of a position from its table, without looking at captures.
+ * @param gs position
+ * @param isDTZ read the dtz table in stead of the wdl one
+ * @param wdl outcome of the position, needed to decode a dtz value
+ * @param result FAIL if there's no table, CHANGE_STM if the dtz table stores the other side to move
+ * @return wdl or dtz value
+ */
+int Syzygy::probeTable(const type::gameState_t& gs, const bool isDTZ, const int wdl, ProbeState& result) {
+  // two kings
+  if (nrOfPieces(gs) == 2) {
+    return DRAW;
+  }
+
+  const Position pos{gs};
+  const auto it = this->tablesByKey.find(pos.key);
+  if (it == this->tablesByKey.end() || !ensureMapped(*it->second, isDTZ)) {
+    result = FAIL;
+    return 0;
+  }
+
+  bool changeSTM = false;
+  const int value = doProbeTable(pos, *it->second, isDTZ, wdl, changeSTM);
+  if (changeSTM) {
+    result = CHANGE_STM;
+  }
+
+  return value;
+}
+
+/**
+ * Win, draw or loss of a position, with captures resolved first. The tables
+ * don't know about en passant, and store "don't care" values for positions
+ * where a capture is the best move, so captures are searched before the
+ * table is read.
+ *
+ * @param gs position
+ * @param checkZeroingMoves search pawn moves too, needed before a dtz probe
+ * @param level recursion level, picks the move buffer
+ * @param result ZEROING_BEST_MOVE if a searched move is the best one
+ * @return WDL of the side to move
+ */
+int Syzygy::search(const type::gameState_t& gs, const bool checkZeroingMoves, const unsigned int level, ProbeState& result) {
+  int bestValue = LOSS;
+  const uint16_t total = this->generateMoves(gs, level);
+  const auto& children = this->buffer(level);
+  uint16_t moveCount = 0;
+
+  for (uint16_t i = 0; i < total; i++) {
+    const auto& child = children[i];
+    if (!isCapture(gs, child) && (!checkZeroingMoves || !isPawnMove(gs, child))) {
+      continue;
+    }
+
+    moveCount++;
+    const int value = -this->search(child, false, level + 1, result);
+    if (result == FAIL) {
+      return DRAW;
+    }
+
+    if (value > bestValue) {
+      bestValue = value;
+      if (value >= WIN) {
+        result = ZEROING_BEST_MOVE;
+        return value;
+      }
+    }
+  }
+
+  // every move was searched, the table might be wrong for this position
+  const bool noMoreMoves = moveCount > 0 && moveCount == total;
+
+  int value = bestValue;
+  if (!noMoreMoves) {
+    value = this->probeTable(gs, false, DRAW, result);
+    if (result == FAIL) {
+      return DRAW;
+    }
+  }
+
+  if (bestValue >= value) {
+    result = (bestValue > DRAW || noMoreMoves) ? ZEROING_BEST_MOVE : OK;
+    return bestValue;
+  }
+
+  result = OK;
+  return value;
+}
+
+/**
+ * Distance to zeroing of a position.
+ *
+ * The dtz files only store one side to move. For the other one every move
+ * is tried, and the best distance of the replies is used.
+ */
+int Syzygy::probeDTZ(const type::gameState_t& gs, const unsigned int level, ProbeState& result) {
+  result = OK;
+  const int wdl = this->search(gs, true, level, result);
+
+  // draws aren't stored in the dtz tables
+  if (result == FAIL || wdl == DRAW) {
+    return 0;
+  }
+
+  if (result == ZEROING_BEST_MOVE) {
+    return dtzBeforeZeroing(wdl);
+  }
+
+  int dtz = this->probeTable(gs, true, wdl, result);
+  if (result == FAIL) {
+    return 0;
+  }
+
+  if (result != CHANGE_STM) {
+    const bool fiftyMoveRule = wdl == BLESSED_LOSS || wdl == CURSED_WIN;
+    return (dtz + (fiftyMoveRule ? 100 : 0)) * signOf(wdl);
+  }
+
+  int minDTZ = 0xFFFF;
+  const uint16_t total = this->generateMoves(gs, level);
+  const auto& children = this->buffer(level);
+
+  for (uint16_t i = 0; i < total; i++) {
+    const auto& child = children[i];
+    const bool zeroing = isCapture(gs, child) || isPawnMove(gs, child);
+
+    // zeroing moves take the distance from before the move, the others from after it
+    dtz = zeroing
+        ? -dtzBeforeZeroing(this->search(child, false, level + 1, result))
+        : -this->probeDTZ(child, level + 1, result);
+
+    if (dtz == 1 && isInCheck(child) && this->generateMoves(child, level + 1) == 0) {
+      minDTZ = 1;
+    }
+
+    if (!zeroing) {
+      dtz += signOf(dtz);
+    }
+
+    if (dtz < minDTZ && signOf(dtz) == signOf(wdl)) {
+      minDTZ = dtz;
+    }
+
+    if (result == FAIL) {
+      return 0;
+    }
+  }
+
+  // no legal moves, mated
+  return minDTZ == 0xFFFF ? -1 : minDTZ;
+}
+
+}
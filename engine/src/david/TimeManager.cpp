@@ -0,0 +1,194 @@
+#include "david/TimeManager.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace david {
+
+/**
+ * Constructor
+ */
+TimeManager::TimeManager()
+    : startTime(std::chrono::steady_clock::now())
+    , timeLimited(false)
+    , fixedTime(false)
+    , optimum(std::numeric_limits<int>::max())
+    , softLimit(std::numeric_limits<int>::max())
+    , hardLimit(std::numeric_limits<int>::max())
+    , moveOverhead(30)
+    , iterations(0)
+    , lastBestMoveIndex(-1)
+    , stableIterations(0)
+    , lastScore(0)
+{}
+
+/**
+ * Compute the budgets for a new search and start the clock.
+ *
+ * @param timeLeft int ms left on the clock of the active colour
+ * @param increment int ms increment per move for the active colour
+ * @param movestogo int moves until the next time control, 0 if sudden death
+ * @param movetime int ms for this search exactly
+ */
+void TimeManager::start(const int timeLeft, const int increment, const int movestogo, const int movetime) {
+  this->startTime = std::chrono::steady_clock::now();
+  this->iterations = 0;
+  this->lastBestMoveIndex = -1;
+  this->stableIterations = 0;
+  this->lastScore = 0;
+
+  // fixed time per move, no reason to scale anything
+  if (movetime > 0) {
+    this->timeLimited = true;
+    this->fixedTime = true;
+    this->optimum = this->softLimit = this->hardLimit = std::max(movetime - this->moveOverhead, 1);
+    return;
+  }
+
+  // no clock information, search until depth or stop
+  if (timeLeft <= 0) {
+    this->timeLimited = false;
+    this->fixedTime = false;
+    this->optimum = this->softLimit = this->hardLimit = std::numeric_limits<int>::max();
+    return;
+  }
+
+  this->timeLimited = true;
+  this->fixedTime = false;
+
+  // expect 30 more moves in sudden death, and don't plan too far ahead otherwise
+  const int movesLeft = movestogo > 0 ? std::min(movestogo, 50) : 30;
+  const int usable = std::max(timeLeft - this->moveOverhead, 1);
+
+  // never use more than a share of the remaining clock on a single move,
+  // unless it's the last move before the time control.
+  const int maximum = movesLeft == 1 ? usable * 9 / 10 : usable * 3 / 5;
+
+  this->optimum = std::min(usable / movesLeft + increment * 3 / 4, maximum);
+  this->hardLimit = std::max(std::min(this->optimum * 5, maximum), 1);
+  this->softLimit = std::max(std::min(this->optimum, this->hardLimit), 1);
+}
+
+/**
+ * Adjust the soft budget once an iteration has completed.
+ * A best move that keeps changing, or a score that drops, gives more time.
+ * A best move that has been stable for a few iterations gives less time.
+ *
+ * @param bestMoveIndex int best root move index of the iteration
+ * @param score int score of the iteration
+ */
+void TimeManager::iterationComplete(const int bestMoveIndex, const int score) {
+  this->iterations += 1;
+
+  if (bestMoveIndex == this->lastBestMoveIndex) {
+    this->stableIterations += 1;
+  }
+  else {
+    this->stableIterations = 0;
+  }
+
+  const bool firstIteration = this->iterations == 1;
+  const int scoreDrop = firstIteration ? 0 : this->lastScore - score;
+
+  this->lastBestMoveIndex = bestMoveIndex;
+  this->lastScore = score;
+
+  if (!this->timeLimited || this->fixedTime || firstIteration) {
+    return;
+  }
+
+  int factor = 100; // percent of the optimum
+  if (this->stableIterations == 0) {
+    factor = 140;
+  }
+  else if (this->stableIterations >= 3) {
+    factor = 70;
+  }
+
+  // the ANN scores are given in thousands, so 50 is a noticeable drop
+  if (scoreDrop > 50) {
+    factor += 40;
+  }
+
+  const int64_t scaled = static_cast<int64_t>(this->optimum) * factor / 100;
+  this->softLimit = static_cast<int>(std::min<int64_t>(scaled, this->hardLimit));
+}
+
+/**
+ * The opponent played the move that was pondered on, so the clock of the
+ * active colour starts now. The time spent pondering is credited against
+ * the soft budget, as that work doesn't have to be done again. The hard
+ * budget is kept, since it protects the real clock.
+ */
+void TimeManager::ponderhit() {
+  const int pondered = this->elapsed();
+  this->startTime = std::chrono::steady_clock::now();
+
+  if (!this->timeLimited || this->fixedTime) {
+    return;
+  }
+
+  // always leave a quarter of the optimum, so the ponder move gets verified
+  const int credit = std::min(pondered, this->optimum * 3 / 4);
+  this->optimum = std::max(this->optimum - credit, 1);
+  this->softLimit = std::max(std::min(this->softLimit - credit, this->hardLimit), 1);
+}
+
+/**
+ * Time passed since start was called.
+ * @return int milliseconds
+ */
+int TimeManager::elapsed() const {
+  const auto diff = std::chrono::steady_clock::now() - this->startTime;
+  return static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(diff).count());
+}
+
+/**
+ * Should the search stop starting new iterations.
+ * @return true if the soft budget is used up
+ */
+bool TimeManager::softLimitReached() const {
+  return this->timeLimited && this->elapsed() >= this->softLimit;
+}
+
+/**
+ * Must the search stop right away.
+ * @return true if the hard budget is used up
+ */
+bool TimeManager::hardLimitReached() const {
+  return this->timeLimited && this->elapsed() >= this->hardLimit;
+}
+
+bool TimeManager::hasTimeLimit() const {
+  return this->timeLimited;
+}
+
+int TimeManager::getSoftLimit() const {
+  return this->softLimit;
+}
+
+int TimeManager::getHardLimit() const {
+  return this->hardLimit;
+}
+
+TimeManager::timePoint_t TimeManager::getStartTime() const {
+  return this->startTime;
+}
+
+/**
+ * The absolute point in time where the search must be stopped.
+ * Only meaningful when hasTimeLimit() is true.
+ */
+TimeManager::timePoint_t TimeManager::getHardDeadline() const {
+  return this->startTime + std::chrono::milliseconds(this->hardLimit);
+}
+
+/**
+ * Time reserved for communication lag between engine and GUI.
+ * @param overhead int milliseconds
+ */
+void TimeManager::setMoveOverhead(const int overhead) {
+  this->moveOverhead = std::max(overhead, 0);
+}
+
+}
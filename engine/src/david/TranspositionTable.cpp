@@ -0,0 +1,163 @@
+#include "david/TranspositionTable.h"
+
+#include <algorithm>
+
+namespace david {
+
+namespace {
+// move lists are stored in the arena, this is roughly what an average
+// position needs, used to split the requested size between slots and arena.
+constexpr size_t AVERAGE_MOVES = 40;
+}
+
+/**
+ * Constructor
+ * @param megabytes approximate memory use
+ */
+TranspositionTable::TranspositionTable(const size_t megabytes)
+    : mask(0)
+    , generation(0)
+    , writtenMoves(0)
+    , probes(0)
+    , hits(0)
+{
+  this->resize(megabytes);
+}
+
+/**
+ * Change the size of the table, this clears it.
+ * The number of entries is rounded down to a power of two, the arena gets
+ * room for AVERAGE_MOVES moves per entry.
+ *
+ * @param megabytes approximate memory use
+ */
+void TranspositionTable::resize(const size_t megabytes) {
+  const size_t bytesPerEntry = sizeof(Entry) + AVERAGE_MOVES * sizeof(ScoredMove);
+  const size_t wanted = std::max<size_t>(megabytes, 1) * 1024 * 1024 / bytesPerEntry;
+
+  size_t nrOfEntries = 1;
+  while (nrOfEntries * 2 <= wanted) {
+    nrOfEntries *= 2;
+  }
+
+  std::vector<Entry>(nrOfEntries).swap(this->entries);
+  std::vector<ScoredMove>(nrOfEntries * AVERAGE_MOVES).swap(this->arena);
+  this->mask = nrOfEntries - 1;
+  this->clear();
+}
+
+/**
+ * Forget every stored position.
+ */
+void TranspositionTable::clear() {
+  for (auto& entry : this->entries) {
+    entry.key = 0;
+    entry.offset = 0;
+    entry.moves = nullptr;
+    entry.nrOfMoves = 0;
+    entry.generation = 0;
+  }
+
+  this->generation = 1;
+  this->writtenMoves = 0;
+  this->probes = 0;
+  this->hits = 0;
+}
+
+/**
+ * Start a new generation, call this once before each search.
+ * Generation 0 is reserved for empty entries.
+ */
+void TranspositionTable::newSearch() {
+  this->generation = static_cast<uint8_t>(this->generation == 255 ? 1 : this->generation + 1);
+  this->probes = 0;
+  this->hits = 0;
+}
+
+/**
+ * Find the entry of a position. A hit moves the entry into the current
+ * generation since it's in use again. An entry whose move list has been
+ * written over by newer lists is a miss.
+ *
+ * @param key zobrist hash
+ * @return the entry, or nullptr if the position isn't stored
+ */
+const TranspositionTable::Entry* TranspositionTable::probe(const uint64_t key) {
+  this->probes += 1;
+
+  auto& entry = this->entries[key & this->mask];
+  if (entry.generation == 0 || entry.key != key || this->writtenMoves - entry.offset > this->arena.size()) {
+    return nullptr;
+  }
+
+  this->hits += 1;
+  entry.generation = this->generation;
+  return &entry;
+}
+
+/**
+ * Store the sorted move list of a position, replacing the slot content.
+ * A list that doesn't fit before the end of the arena starts over at the
+ * beginning. Storing the same position again with the same number of moves,
+ * like when a move is promoted, writes over its list in place.
+ *
+ * @param key zobrist hash
+ * @param moves sorted moves
+ * @param len number of moves
+ */
+void TranspositionTable::store(const uint64_t key, const ScoredMove* moves, const uint16_t len) {
+  const size_t capacity = this->arena.size();
+  if (len > capacity) {
+    return;
+  }
+
+  auto& entry = this->entries[key & this->mask];
+  const bool inPlace = entry.generation != 0 && entry.key == key && entry.nrOfMoves == len
+      && this->writtenMoves - entry.offset <= capacity;
+
+  if (!inPlace) {
+    uint64_t offset = this->writtenMoves;
+    const size_t start = static_cast<size_t>(offset % capacity);
+    if (start + len > capacity) {
+      offset += capacity - start;
+    }
+
+    entry.offset = offset;
+    entry.moves = this->arena.data() + offset % capacity;
+    this->writtenMoves = offset + len;
+  }
+
+  entry.key = key;
+  entry.generation = this->generation;
+  entry.nrOfMoves = len;
+  std::copy(moves, moves + len, this->arena.data() + entry.offset % capacity);
+}
+
+/**
+ * @return int permill of the entries written by the current search
+ */
+int TranspositionTable::hashfull() const {
+  const size_t sample = std::min<size_t>(1000, this->entries.size());
+  int used = 0;
+  for (size_t i = 0; i < sample; i++) {
+    if (this->entries[i].generation == this->generation) {
+      used += 1;
+    }
+  }
+
+  return static_cast<int>(used * 1000 / sample);
+}
+
+size_t TranspositionTable::size() const {
+  return this->entries.size();
+}
+
+uint64_t TranspositionTable::getProbes() const {
+  return this->probes;
+}
+
+uint64_t TranspositionTable::getHits() const {
+  return this->hits;
+}
+
+}
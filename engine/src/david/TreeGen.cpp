@@ -17,11 +17,8 @@ TreeGen::TreeGen(const type::NeuralNetwork_t& NeuralNetRef)
     , maxDepth(5)
     , startposFEN(constant::FENStartPosition)
 {
-  int i = 0;
-  int iAfterFirstMove = 0;
-  while (this->depthIndexes.end() == 0) {
-    this->depthIndexes[++i] = constant::MAXMOVES * iAfterFirstMove + 1;
-  }
+  this->tree[0].resize(1);
+  this->levelParent.fill(-1);
 }
 
 /**
@@ -36,7 +33,7 @@ TreeGen::~TreeGen() {}
  * @return Mutable gameState reference
  */
 type::gameState_t& TreeGen::getGameState(const unsigned int index) {
-  return this->tree[index];
+  return this->tree[this->level(index)][this->offset(index)];
 }
 
 /**
@@ -46,7 +43,7 @@ type::gameState_t& TreeGen::getGameState(const unsigned int index) {
  * @return Mutable gameState copy
  */
 type::gameState_t TreeGen::getGameStateCopy(const unsigned int index) const {
-  return this->tree[index];
+  return this->tree[this->level(index)][this->offset(index)];
 }
 
 /**
@@ -55,7 +52,7 @@ type::gameState_t TreeGen::getGameStateCopy(const unsigned int index) const {
  * @return
  */
 int TreeGen::getGameStateScore(const unsigned int index) const {
-  return this->tree[index].score;
+  return this->tree[this->level(index)][this->offset(index)].score;
 }
 
 /**
@@ -79,26 +76,97 @@ unsigned int TreeGen::treeIndex(const uint8_t depth, const uint8_t index) const
   return constant::MAXMOVES * depth + index + 1; // will never be below 0
 }
 
+/**
+ * Make a child of the root node the new root node.
+ *
+ * If the levels below hold the subtree of that child, they are moved one
+ * level up. That way the children, their scores and their ordering are
+ * reused rather than generated again.
+ *
+ * @param index int Index of a root child, 1 - 256
+ */
 void TreeGen::updateRootNodeTo(const int index) {
-  auto c = this->tree.front().isWhite;
-  this->tree[0] = std::move(this->tree[index]);
+  auto c = this->getGameState(0).isWhite;
+
+  // find how many levels hold the subtree of the new root, before anything is overwritten
+  unsigned int levels = 1;
+  if (this->hasGeneratedChildren(index)) {
+    levels = 2;
+    while (levels < LEVELS) {
+      const int parent = this->levelParent[levels + 1];
+      if (parent < 0 || this->level(parent) != levels || !this->hasGeneratedChildren(parent)) {
+        break;
+      }
+      levels += 1;
+    }
+  }
+
+  this->getGameState(0) = this->getGameState(index);
 
-  if (c == this->tree.front().isWhite) {
+  // move every reusable level one up, level 1 is replaced by the children of the new root
+  for (unsigned int l = 2; l <= levels; l++) {
+    const int parent = this->levelParent[l];
+    this->tree[l - 1].swap(this->tree[l]);
+
+    this->levelParent[l - 1] = l == 2 ? 0 : parent - constant::MAXMOVES;
+    this->levelParentState[l - 1] = this->levelParentState[l];
+  }
+
+  // anything below is now stale
+  for (unsigned int l = levels; l < this->levelParent.size(); l++) {
+    this->levelParent[l] = -1;
+  }
+
+  if (c == this->getGameState(0).isWhite) {
     std::cerr << "color was not changed!!!" << std::endl;
   }
 }
 
 void TreeGen::setRootNodeFromFEN(const std::string& FEN) {
   if (FEN == ::david::constant::FENStartPosition) {
-    ::utils::gameState::setDefaultChessLayout(this->tree.front());
+    ::utils::gameState::setDefaultChessLayout(this->getGameState(0));
   }
   else {
-    ::utils::gameState::generateFromFEN(this->tree.front(), FEN);
+    ::utils::gameState::generateFromFEN(this->getGameState(0), FEN);
   }
+
+  // a new start position, so the game record starts over
+  this->startposFEN = FEN;
+  this->historyIndex = 0;
 }
 
 void TreeGen::setRootNode(const type::gameState_t& gs) { // TODO: bad?
-  this->tree.front() = gs;
+  this->getGameState(0) = gs;
+
+  // the root no longer follows from the game record
+  this->startposFEN = "";
+  this->historyIndex = 0;
+}
+
+/**
+ * Set the root node from a position and the moves played since.
+ *
+ * The GUI sends the whole game on every move, so when the position and the
+ * start of the moves match what has already been applied only the new moves
+ * are applied. This keeps the subtree of the previous search when the
+ * opponent plays one of the moves that was looked at.
+ *
+ * @param FEN start position, constant::FENStartPosition for startpos
+ * @param moves EGN moves played from the start position
+ */
+void TreeGen::setPosition(const std::string& FEN, const std::vector<std::string>& moves) {
+  bool continuation = FEN == this->startposFEN && this->historyIndex <= moves.size();
+  for (unsigned int i = 0; continuation && i < this->historyIndex; i++) {
+    continuation = this->history[i] == moves[i];
+  }
+
+  if (!continuation) {
+    this->setRootNodeFromFEN(FEN);
+  }
+
+  for (auto i = this->historyIndex; i < moves.size(); i++) {
+    this->applyEGNMove(moves[i]);
+  }
 }
 
 /**
@@ -118,52 +186,106 @@ void TreeGen::reset() {
   this->EGNMoves.empty();
   this->nrOfEGNMoves = -1;
 
+  // forget any generated children
+  this->levelParent.fill(-1);
 }
 
 /**
  * Generates children for a given node, and sorts the children.
  *
- * @param node std::share_ptr<::bitboard::gameState>
+ * @param index unsigned int Index of the parent in the game tree
+ * @return number of children
  */
 uint16_t TreeGen::generateChildren(const unsigned int index) {
   using type::gameState_t;
 
-  auto& node = this->tree[index];
+  const auto childLevel = this->level(index) + 1;
+  if (childLevel > LEVELS) {
+    std::cerr << "TreeGen only keeps " << LEVELS << " levels below the root!" << std::endl;
+    return 0;
+  }
+
+  auto& node = this->getGameState(index);
 
   // Get ready to generate all potential moves based on given chess board
   MoveGen gen{node}; // new version
 
-  // uint8 has a max num of 255. Max nr of children is 256. perfect af.
-  unsigned int firstChildPos = index == 0 ? constant::MAXMOVES - 1 : (index - 1) % constant::MAXMOVES;
-  firstChildPos = index + (constant::MAXMOVES - firstChildPos);
-
   // create a holder for possible game outputs
-  const uint16_t len = gen.generateGameStates(this->tree, firstChildPos, firstChildPos + constant::MAXMOVES); // new version
+  const uint16_t len = gen.generateGameStates(this->children, 0, constant::MAXMOVES - 1); // new version
   node.possibleSubMoves = len;
 
-#ifdef DAVID_DEVELOPMENT
-  assert(firstChildPos != 0);
-#endif
+  // the level only holds as many nodes as there are children
+  auto& level = this->tree[childLevel];
+  level.assign(this->children.begin(), this->children.begin() + len);
 
+  // use ann to get the scores, all siblings as one batch
+  std::array<int, constant::MAXMOVES> scores;
+  this->neuralnet.evaluateBatch(level.data(), len, scores.data());
   for (uint16_t i = 0; i < len; i++) {
-    auto& n = this->tree[firstChildPos + i];
-
-    // use ann to get score
-    n.score = this->neuralnet.ANNEvaluate(n);
-    //if (this->NN != nullptr) {
-    //  n.score = this->engineContextPtr->neuralNetworkPtr->ANNEvaluate(n);
-    //}
+    level[i].score = scores[i];
   }
 
   // once all the nodes are set, we need to sort the children.
-  std::sort(this->tree.begin() + firstChildPos, this->tree.begin() + firstChildPos + len,
+  // they are scored from the opponent's side, so the lowest score is the best move.
+  std::sort(level.begin(), level.end(),
             [](const type::gameState_t& a, const type::gameState_t& b) -> bool {
-              return a.score > b.score;
+              return a.score < b.score;
             });
 
+  // remember whose children this level now holds
+  this->levelParent[childLevel] = index;
+  this->levelParentState[childLevel] = node;
+
   return len;
 }
 
+/**
+ * Check if the children of a node are already in the tree.
+ * They are as long as the level below still belongs to this node, and the
+ * node hasn't been changed since.
+ *
+ * @param index unsigned int Index of the parent in the game tree
+ * @return true if generateChildren can be skipped
+ */
+bool TreeGen::hasGeneratedChildren(const unsigned int index) const {
+  const auto childLevel = this->level(index) + 1;
+  if (childLevel > LEVELS || this->levelParent[childLevel] != static_cast<int>(index)) {
+    return false;
+  }
+
+  return ::utils::gameState::samePosition(this->tree[this->level(index)][this->offset(index)], this->levelParentState[childLevel]);
+}
+
+/**
+ * Make sure the children of a root child, and the children of its best
+ * scored reply, are in the tree. Used after a search so the line that is
+ * expected to be played can be reused as the next root.
+ *
+ * @param index unsigned int Index of a root child, usually the best move
+ */
+void TreeGen::generatePredictedLine(const unsigned int index) {
+  if (!this->hasGeneratedChildren(index)) {
+    this->generateChildren(index);
+  }
+
+  if (this->getGameState(index).possibleSubMoves == 0) {
+    return;
+  }
+
+  // children are sorted, so the first one is the expected reply
+  const auto reply = this->getChildIndex(index, 0);
+  if (!this->hasGeneratedChildren(reply)) {
+    this->generateChildren(reply);
+  }
+}
+
+/**
+ * The neural network used to score the nodes.
+ */
+const type::NeuralNetwork_t& TreeGen::getNeuralNetwork() const {
+  return this->neuralnet;
+}
+
 void TreeGen::setMaxDepth(int d)
 {
   bool timeToGrow = d > this->maxDepth;
@@ -177,14 +299,14 @@ void TreeGen::setMaxDepth(int d)
 
 void TreeGen::generateEGNMoves()
 {
-  // TODO: have a bool that tells whether or not moves have been generated
-  // TODO: This will avoid regenerating nodes that already exist.
-  this->generateChildren(0);
+  if (!this->hasGeneratedChildren(0)) {
+    this->generateChildren(0);
+  }
 
-  const auto& root = this->tree.front();
+  const auto& root = this->getGameState(0);
   const int len = this->nrOfEGNMoves = root.possibleSubMoves;
   for (int i = 0; i < len; i++) {
-    this->EGNMoves[i] = ::utils::gameState::getEGN(root, this->tree[i + 1]);
+    this->EGNMoves[i] = ::utils::gameState::getEGN(root, this->getGameState(i + 1));
   }
 }
 
@@ -215,7 +337,7 @@ void TreeGen::applyEGNMove(const std::string& EGN)
         << EGN
         << "] based on current board layout inside the engine.. Did you forget to update the layout?"
         << std::endl;
-    utils::gameState::print(this->tree.front());
+    utils::gameState::print(this->getGameState(0));
     return;
   }
 
@@ -13,6 +13,9 @@
 #include "david/utils/utils.h"
 #include "david/EngineMaster.h"
 #include "david/MoveGen.h"
+#include "david/Bench.h"
+#include "david/ANN/DenseNetwork.h"
+#include "david/utils/neuralNet.h"
 
 #include "david/utils/logger.h"
 
@@ -33,6 +36,57 @@ void fight() {
   std::cout << "lost" << std::endl;
 }
 
+/**
+ * Search the built in positions and print the node count and speed.
+ * Usage: bench [depth] [threads] [hash]
+ */
+void bench(int argc, char * argv[]) {
+  const int depth   = argc > 2 ? ::utils::stoi(argv[2]) : ::david::Bench::DEFAULT_DEPTH;
+  const int threads = argc > 3 ? ::utils::stoi(argv[3]) : ::david::Bench::DEFAULT_THREADS;
+  const int hash    = argc > 4 ? ::utils::stoi(argv[4]) : ::david::Bench::DEFAULT_HASH;
+
+  ::david::ChessEngine engine("float_ANNFile_6_83_1_1497360313.net");
+  engine.bench(depth, threads, hash);
+}
+
+/**
+ * Write a FANN float network as a binary network file, which the engines
+ * map at startup instead of parsing the .net file.
+ * Usage: convert <file.net> [file.dnet] [layout]
+ * A file name without a folder is looked up in the networks folder. The
+ * layout is 1 for the one the networks were trained on, 2 for the full one.
+ */
+int convert(int argc, char * argv[]) {
+  if (argc < 3) {
+    std::cerr << "usage: convert <file.net> [file.dnet] [layout]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::string from = argv[2];
+  if (from.find('/') == std::string::npos) {
+    from = ::utils::getAbsoluteProjectPath() + ::david::neuralNetworksFolder + from;
+  }
+  const std::string to = argc > 3 ? argv[3] : ::david::DenseNetwork::binaryPath(from);
+  const int layout = argc > 4 ? ::utils::stoi(argv[4]) : ::utils::neuralNet::LAYOUT_TRAINED;
+  if (layout != ::utils::neuralNet::LAYOUT_TRAINED && layout != ::utils::neuralNet::LAYOUT_FULL) {
+    std::cerr << "unknown input layout " << layout << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  ::david::DenseNetwork network;
+  if (!network.load(from)) {
+    std::cerr << "not a float network file: " << from << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (!network.save(to, layout)) {
+    std::cerr << "could not write " << to << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "wrote " << to << ", " << network.weightBytes() << " bytes of weights" << std::endl;
+  return EXIT_SUCCESS;
+}
+
 void gui() {
   std::cout << "David Chess Engine v1.0.0" << std::endl;
   ::david::ChessEngine engine("float_ANNFile_6_83_1_1497360313.net");
@@ -108,7 +162,7 @@ int juddperft (int argc, char * argv[])
 //  }
 //}
 
-// TODO: Should support changing mode without recompiling.
+// The mode is the first argument, the rest are given to the mode.
 int main (int argc, char * argv[])
 {
   // Make sure its not some weird "cpu architecture".
@@ -118,7 +172,7 @@ int main (int argc, char * argv[])
   assert(sizeof(uint64_t) == 8);
 
 
-  const std::string mode = "perft"; // uci, fight, train, perft, judd-perft. Default: "uci"
+  const std::string mode = argc > 1 ? argv[1] : "uci"; // uci, bench, convert, fight, train, perft, juddperft. Default: "uci"
 
 
   if (mode == "fight") {
@@ -127,6 +181,9 @@ int main (int argc, char * argv[])
   else if (mode == "uci") {
     gui();
   }
+  else if (mode == "bench") {
+    bench(argc, argv);
+  }
   else if (mode == "train") {
     train();
   }
@@ -141,8 +198,11 @@ int main (int argc, char * argv[])
     ::utils::perft_advanced(3, "r3k3/3N4/8/8/8/8/8/4K3 b q - 0 1");
     //::utils::perft(1, "r4k2/8/8/4N3/8/4K3/8/8 b - - 0 1");
   }
+  else if (mode == "convert") {
+    return convert(argc, argv);
+  }
   else if (mode == "juddperft") {
-    juddperft(argc, argv);
+    return juddperft(argc - 1, argv + 1);
   }
   else if (mode == "profiling") {
     ::david::type::gameState_t gs;
@@ -1,6 +1,7 @@
 #include <unistd.h>
 #include <string>
 #include <map>
+#include <array>
 #include "david/types.h"
 #include "david/david.h"
 #include "david/utils/utils.h"
@@ -485,6 +486,134 @@ void generateMergedBoardVersion(::david::type::gameState_t& gs) {
   gs.combinedPieces = gs.piecess[0] | gs.piecess[1];
 }
 
+/**
+ * Create the game state that follows a null move (the active colour passes).
+ * Mirrors the reversed state that MoveGen builds before generating children.
+ *
+ * @param parent gameState_t& the node to pass from
+ * @param child gameState_t& the node where the opponent is to move
+ */
+void generateNullMove(const ::david::type::gameState_t& parent, ::david::type::gameState_t& child) {
+  child = parent;
+
+  // swap the active piece side
+  for (uint8_t i = 0; i < 6; i++) {
+    child.piecesArr[i][0] = parent.piecesArr[i][1];
+    child.piecesArr[i][1] = parent.piecesArr[i][0];
+  }
+  child.piecess[0] = parent.piecess[1];
+  child.piecess[1] = parent.piecess[0];
+  child.queenCastlings[0] = parent.queenCastlings[1];
+  child.queenCastlings[1] = parent.queenCastlings[0];
+  child.kingCastlings[0] = parent.kingCastlings[1];
+  child.kingCastlings[1] = parent.kingCastlings[0];
+
+  // a pass can never be followed by an en passant capture
+  child.passant = false;
+  child.enPassant = 0;
+  child.enPassantPawn = 0;
+
+  child.isWhite = !parent.isWhite;
+  child.depth = parent.depth + 1;
+  child.possibleSubMoves = 0;
+}
+
+/**
+ * Check if two game states describe the same position, ignoring the move
+ * counters and search data such as score, depth and number of children.
+ *
+ * @param a gameState_t&
+ * @param b gameState_t&
+ * @return true if the pieces, colour to move, castling and en passant rights are equal
+ */
+bool samePosition(const ::david::type::gameState_t& a, const ::david::type::gameState_t& b) {
+  return a.isWhite == b.isWhite
+      && a.piecesArr == b.piecesArr
+      && a.queenCastlings == b.queenCastlings
+      && a.kingCastlings == b.kingCastlings
+      && a.passant == b.passant
+      && a.enPassant == b.enPassant;
+}
+
+namespace {
+//
+// Random keys for the zobrist hash, generated with splitmix64 so every run
+// and every build hashes a position the same way.
+//
+struct ZobristKeys {
+  std::array<std::array<std::array<uint64_t, 64>, 2>, 6> pieces;
+  std::array<uint64_t, 2> queenCastlings;
+  std::array<uint64_t, 2> kingCastlings;
+  std::array<uint64_t, 64> enPassant;
+  uint64_t black;
+
+  ZobristKeys() {
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    auto next = [&seed]() -> uint64_t {
+      uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    };
+
+    for (auto& piece : this->pieces) {
+      for (auto& colour : piece) {
+        for (auto& key : colour) {
+          key = next();
+        }
+      }
+    }
+    this->queenCastlings = {next(), next()};
+    this->kingCastlings = {next(), next()};
+    for (auto& key : this->enPassant) {
+      key = next();
+    }
+    this->black = next();
+  }
+};
+
+const ZobristKeys zobrist;
+}
+
+/**
+ * Zobrist hash of a position. Positions that are samePosition get the same
+ * hash, the move counters and search data are not part of it.
+ *
+ * The piece and castling arrays are relative to the active colour, which is
+ * fine since the colour to move is part of the hash as well.
+ *
+ * @param gs gameState_t&
+ * @return uint64_t hash
+ */
+uint64_t zobristHash(const ::david::type::gameState_t& gs) {
+  uint64_t hash = gs.isWhite ? 0ULL : zobrist.black;
+
+  for (uint8_t piece = 0; piece < gs.piecesArr.size(); piece++) {
+    for (uint8_t colour = 0; colour < 2; colour++) {
+      ::david::type::bitboard_t board = gs.piecesArr[piece][colour];
+      while (board != 0ULL) {
+        hash ^= zobrist.pieces[piece][colour][::utils::LSB(board)];
+        board &= board - 1;
+      }
+    }
+  }
+
+  for (uint8_t colour = 0; colour < 2; colour++) {
+    if (gs.queenCastlings[colour]) {
+      hash ^= zobrist.queenCastlings[colour];
+    }
+    if (gs.kingCastlings[colour]) {
+      hash ^= zobrist.kingCastlings[colour];
+    }
+  }
+
+  if (gs.passant) {
+    hash ^= zobrist.enPassant[gs.enPassant & 63];
+  }
+
+  return hash;
+}
+
 /**
  * Set default board values
  * @param node gameState_t&
@@ -1,102 +1,203 @@
-
 #include "david/utils/neuralNet.h"
 #include "david/utils/utils.h"
-#include "david/MoveGen.h"
+#include "david/SEE.h"
 
-#include <string>
-#include <map>
+#include <algorithm>
+#include <array>
 
 namespace utils {
 namespace neuralNet {
 
+namespace {
+
+// counts and square indexes are scaled down to hundredths
+constexpr float HUNDREDTH = 0.01f;
+
+// the first and last rank, pawn moves there were promotions and never counted
+constexpr ::david::type::bitboard_t PROMOTION_RANKS = 0xFF000000000000FFULL;
+
+inline float flag(const bool value) {
+  return value ? 1.0f : -1.0f;
+}
+
+inline float count(const ::david::type::bitboard_t board) {
+  return ::utils::nrOfActiveBits(board) * HUNDREDTH;
+}
+
 /**
- * Issue, what if there is more pieces of one type than the normal in a chess game?
- * Issue, should be floats and not doubles.
- *
- * @param node
- * @param player
- * @return
+ * Squares of the pieces of a board, from the lowest index, -1 for the
+ * pieces that are missing.
+ * @param firstMissing written instead of -1 when there are no pieces at all
+ * @return int the input after the last one written
+ */
+int writeSquares(::david::type::bitboard_t board, const int pieces, const float firstMissing, float* inputs, int offset) {
+  for (int piece = 0; piece < pieces && offset < ::david::constant::nn::INPUTSIZE; piece++) {
+    if (board == 0ULL) {
+      inputs[offset++] = piece == 0 ? firstMissing : -1.0f;
+      continue;
+    }
+
+    inputs[offset++] = ::utils::LSB(board) * HUNDREDTH;
+    board &= board - 1;
+  }
+
+  return offset;
+}
+
+/**
+ * Squares the pawns of a colour attack, the way MoveGen::generateAttacks
+ * found them for the networks that were trained. It only knew the active
+ * colour, so the other colour's pawns go the same way as the active ones.
  */
-// TODO: convert to the new node setup
-std::array<float, ::david::constant::nn::INPUTSIZE> convertGameStateToInputs(::david::type::gameState_t& gs) {
-  std::array<float, ::david::constant::nn::INPUTSIZE> boardInfo{};
+::david::type::bitboard_t pawnAttacksTrained(const ::david::type::gameState_t& gs, const uint8_t colour) {
+  const bool up = gs.isWhite;
 
-  uint8_t w = 1;
-  uint8_t b = 0;
-  int offset = 0;
+  ::david::type::bitboard_t attacks = 0;
+  ::david::type::bitboard_t pawns = gs.piecesArr[::david::constant::index::pawn][colour];
+  while (pawns != 0) {
+    const uint8_t square = ::utils::LSB(pawns);
+    pawns &= pawns - 1;
 
-  if (gs.isWhite) {
-    w = 0;
-    b = 1;
+    const auto below = (1ULL << square) - 1;
+    attacks |= ::utils::constant::pawnAttackPaths[square] & (up ? ~below : below);
   }
 
-  ::david::MoveGen moveGen{gs};
+  return attacks & ~PROMOTION_RANKS;
+}
 
-  // empty game state that holds all the attacks
-  ::david::type::gameState_t attacks = moveGen.generateAttacks();
+/**
+ * The piece type features of LAYOUT_TRAINED. Only what survived the
+ * overwrites is computed, the rest is 0.
+ */
+void writePieceTypesTrained(const ::david::type::gameState_t& gs, const uint8_t b, const uint8_t w, float* inputs) {
+  // does every black piece type exist? The king is overwritten
+  for (int i = 0; i < 5; i++) {
+    inputs[1 + i] = flag(gs.piecesArr[i][b] > 0);
+  }
 
+  // how many black pieces can each white piece type attack? MoveGen only
+  // wrote the attacks of the other piece types into the boards of the active
+  // colour, so they're 0 with black to move
+  inputs[6] = count(pawnAttacksTrained(gs, w) & gs.piecess[b]);
+  for (unsigned int i = 1; i < 6; i++) {
+    inputs[6 + i] = w == 0 ? count(::david::see::attacksBy(gs, i, 0) & gs.piecess[b]) : 0.0f;
+  }
 
-  // which colour is the active / currently playing
-  boardInfo[offset++] = gs.isWhite ? 1 : -1;
+  std::fill(inputs + 12, inputs + 25, 0.0f);
 
-  //
-  // Black pieces, then white pieces
-  //
-  for (uint8_t c = b, ii = 0; ii < 2; ii++, c = static_cast<uint8_t>((c + 1) % 2) ) {
-    uint8_t co = static_cast<uint8_t>((c + 1) % 2);
-    // Does every black piece type exist?
-    auto len = gs.piecesArr.size();
-    for (uint8_t i = 0; i < len; i++) {
-      boardInfo[i + offset] = static_cast<float>(gs.piecesArr[i][c] > 0 ? 1.0 : -1.0);
+  // does every white piece type exist?
+  for (int i = 0; i < 6; i++) {
+    inputs[25 + i] = flag(gs.piecesArr[i][w] > 0);
+  }
+
+  std::fill(inputs + 31, inputs + 49, 0.0f);
+}
+
+/**
+ * The piece type features of LAYOUT_FULL, black then white. Every attack map
+ * is computed once and used for both the attacked and the safe pieces.
+ */
+void writePieceTypesFull(const ::david::type::gameState_t& gs, const std::array<std::array<::david::type::bitboard_t, 2>, 6>& attacks,
+                         const std::array<::david::type::bitboard_t, 2>& attacked, const uint8_t b, float* inputs) {
+  int offset = 1;
+  for (uint8_t c = b, ii = 0; ii < 2; ii++, c ^= 1) {
+    const uint8_t co = c ^ 1;
+
+    // does every piece type exist?
+    for (int i = 0; i < 6; i++) {
+      inputs[offset++] = flag(gs.piecesArr[i][c] > 0);
     }
-    offset += len;
 
-    // nr of each black piece type
-    for (uint8_t i = 0; i < len; i++) {
-      boardInfo[i + len] = static_cast<float>(gs.piecesArr[i][c] / 100.0);
+    // nr of each piece type
+    for (int i = 0; i < 6; i++) {
+      inputs[offset++] = count(gs.piecesArr[i][c]);
     }
-    offset += len;
 
-    // How many white pieces can each black chess type attack?
-    for (uint8_t i = 0; i < len; i++) {
-      boardInfo[i + len] = static_cast<float>(utils::nrOfActiveBits(attacks.piecesArr[i][c] & gs.piecess[co])  / 100.0);
+    // how many hostile pieces can each piece type attack?
+    for (int i = 0; i < 6; i++) {
+      inputs[offset++] = count(attacks[i][c] & gs.piecess[co]);
     }
-    offset += len;
 
-    // Are any of the piece types safe?
-    for (uint8_t i = 0; i < len; i++) {
-      boardInfo[i + len] = static_cast<float>(utils::nrOfActiveBits(attacks.piecesArr[i][c] & gs.piecess[co])  / 100.0);
+    // how many pieces of each type aren't attacked?
+    for (int i = 0; i < 6; i++) {
+      inputs[offset++] = count(gs.piecesArr[i][c] & ~attacked[co]);
     }
-    offset += len;
+  }
+}
+
+} // anonymous namespace
+
+/**
+ * Write the network inputs of a position.
+ *
+ * @param gs position
+ * @param inputs ::david::constant::nn::INPUTSIZE floats
+ * @param layout which feature goes in which input
+ */
+void convertGameStateToInputs(const ::david::type::gameState_t& gs, float* inputs, const InputLayout layout) {
+  const uint8_t w = gs.isWhite ? 0 : 1;
+  const uint8_t b = w ^ 1;
+  const bool full = layout == LAYOUT_FULL;
+
+  // squares attacked by each piece type, and by each colour
+  std::array<std::array<::david::type::bitboard_t, 2>, 6> attacks{};
+  std::array<::david::type::bitboard_t, 2> attacked{};
+
+  // which colour is the active / currently playing
+  inputs[0] = flag(gs.isWhite);
+
+  //
+  // Black pieces, then white pieces
+  //
+  if (full) {
+    for (unsigned int i = 0; i < 6; i++) {
+      for (unsigned int c = 0; c < 2; c++) {
+        attacks[i][c] = ::david::see::attacksBy(gs, i, c);
+        attacked[c] |= attacks[i][c];
+      }
+    }
+    writePieceTypesFull(gs, attacks, attacked, b, inputs);
+  }
+  else {
+    writePieceTypesTrained(gs, b, w, inputs);
   }
 
   // how many pieces are there?
-  boardInfo[offset++] = static_cast<float>(::utils::nrOfActiveBits(gs.piecess[b]) / 100.0);
-  boardInfo[offset++] = static_cast<float>(::utils::nrOfActiveBits(gs.piecess[w]) / 100.0);
-  boardInfo[offset++] = static_cast<float>(::utils::nrOfActiveBits(gs.combinedPieces) / 100.0);
+  inputs[49] = count(gs.piecess[b]);
+  inputs[50] = count(gs.piecess[w]);
+  inputs[51] = count(gs.combinedPieces);
 
   // how many pieces can colour attack?
-  boardInfo[offset++] = static_cast<float>(::utils::nrOfActiveBits(attacks.piecess[b] & gs.piecess[w]) / 100.0);
-  boardInfo[offset++] = static_cast<float>(::utils::nrOfActiveBits(attacks.piecess[w] & gs.piecess[b]) / 100.0);
+  inputs[52] = full ? count(attacked[b] & gs.piecess[w]) : 0.0f;
+  inputs[53] = full ? count(attacked[w] & gs.piecess[b]) : 0.0f;
 
   // castling
-  boardInfo[offset++] = static_cast<float>(gs.queenCastlings[b]  ? 1.0 : -1.0);
-  boardInfo[offset++] = static_cast<float>(gs.kingCastlings[b]   ? 1.0 : -1.0);
-  boardInfo[offset++] = static_cast<float>(gs.queenCastlings[w]  ? 1.0 : -1.0);
-  boardInfo[offset++] = static_cast<float>(gs.kingCastlings[w]   ? 1.0 : -1.0);
+  inputs[54] = flag(gs.queenCastlings[b]);
+  inputs[55] = flag(gs.kingCastlings[b]);
+  inputs[56] = flag(gs.queenCastlings[w]);
+  inputs[57] = flag(gs.kingCastlings[w]);
 
   // game progress
-  boardInfo[offset++] = static_cast<float>(100 - gs.halfMoves / 100.0);
-  boardInfo[offset++] = static_cast<float>(50 - gs.fullMoves  / 100.0);
+  if (full) {
+    inputs[58] = gs.halfMoves * HUNDREDTH;
+    inputs[59] = gs.fullMoves * HUNDREDTH;
+  }
+  else {
+    inputs[58] = 100.0f - gs.halfMoves * HUNDREDTH;
+    inputs[59] = 50.0f - gs.fullMoves * HUNDREDTH;
+  }
 
-  // how many possible moves from this game state
-  boardInfo[offset++] = static_cast<float>(moveGen.nrOfPossibleMoves() / 100.0); // is this smart??
+  // squares the active colour can move a piece to, pawn pushes not counted
+  inputs[60] = full ? count(attacked[0] & ~gs.piecess[0]) : 0.0f;
 
-  std::array<::david::type::bitboard_t, 2> boards1 = {
-      gs.piecesArr[5][b],
-      gs.piecesArr[5][w]
-  };
-  std::array<::david::type::bitboard_t, 8> boards2 = {
+  // where the pieces are, the trained networks saw square 0 for a piece
+  // type that's gone. The pawns only partly fit
+  const float missing = full ? -1.0f : 0.0f;
+  int offset = 61;
+  offset = writeSquares(gs.piecesArr[::david::constant::index::king][b], 1, missing, inputs, offset);
+  offset = writeSquares(gs.piecesArr[::david::constant::index::king][w], 1, missing, inputs, offset);
+
+  const std::array<::david::type::bitboard_t, 8> boards2 = {
       gs.piecesArr[::david::constant::index::bishop][b],
       gs.piecesArr[::david::constant::index::knight][b],
       gs.piecesArr[::david::constant::index::queen][b],
@@ -106,69 +207,27 @@ std::array<float, ::david::constant::nn::INPUTSIZE> convertGameStateToInputs(::d
       gs.piecesArr[::david::constant::index::knight][w],
       gs.piecesArr[::david::constant::index::rook][w]
   };
-  std::array<::david::type::bitboard_t, 2> boards8 = {
-      gs.piecesArr[0][b],
-      gs.piecesArr[0][w]
-  };
-
-  // generate inputs
-  for (auto b : boards1) {
-    //auto ba = std::bitset<64>(b);
-    //double arr[1] = {-1.0};
-    auto prog = 0;
-    do {
-      auto i = LSB(b);
-      flipBitOff(b, i);
-
-      boardInfo[offset++] = (i == 0 ? 0.0f : i / 100.0f);
-      prog += 1;
-    } while (b != 0ULL && prog < 1);
-
-    // fill in missing pieces
-    for (; prog < 1; prog++) {
-      boardInfo[offset++] = (-1.0f);
-    }
+  for (const auto board : boards2) {
+    offset = writeSquares(board, 2, missing, inputs, offset);
   }
 
-  // Issue, what if the first on is gone? same on boards8
-  for (auto b : boards2) {
-    //auto ba = std::bitset<64>(b);
-    //double arr[2] = {-1.0, -1.0};
-    auto prog = 0;
-    do {
-      auto i = LSB(b);
-      flipBitOff(b, i);
-
-      boardInfo[offset++] = (i == 0 ? 0.0f : i / 100.0f);
-      prog += 1;
-    } while (b != 0ULL && prog < 2);
-
-    // fill in missing pieces
-    for (; prog < 2; prog++) {
-      boardInfo[offset++] = (-1.0f);
-    }
-  }
-  for (auto b : boards8) {
-    //auto ba = std::bitset<64>(b);
-    //double arr[8] = {-1.0, -1.0, -1.0, -1.0, -1.0, -1.0, -1.0, -1.0};
-    auto prog = 0;
-    do {
-      auto i = LSB(b);
-      flipBitOff(b, i);
-
-      boardInfo[offset++] = (i == 0 ? 0.0f : i / 100.0f);
-      prog += 1;
-    } while (b != 0ULL && prog < 8);
-
-    // fill in missing pieces
-    for (; prog < 8; prog++) {
-      boardInfo[offset++] = (-1.0f);
-    }
-  }
+  offset = writeSquares(gs.piecesArr[::david::constant::index::pawn][b], 8, missing, inputs, offset);
+  writeSquares(gs.piecesArr[::david::constant::index::pawn][w], 8, missing, inputs, offset);
+}
+
+/**
+ * The network inputs of a position in LAYOUT_TRAINED, as an array.
+ *
+ * @param node position
+ * @return std::array the inputs
+ */
+std::array<float, ::david::constant::nn::INPUTSIZE> convertGameStateToInputs(const ::david::type::gameState_t& node) {
+  std::array<float, ::david::constant::nn::INPUTSIZE> boardInfo;
+  convertGameStateToInputs(node, boardInfo.data());
 
   return boardInfo;
 }
 
 
 } // neuralNet
-} // utils
\ No newline at end of file
+} // utils
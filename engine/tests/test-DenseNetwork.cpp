@@ -0,0 +1,452 @@
+#include "david/ANN/DenseNetwork.h"
+#include "catch.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+
+namespace {
+
+/**
+ * A fully connected FANN float network file with symmetric sigmoid hidden
+ * layers and a linear output, weights[l][row] holds the inputs of a neuron
+ * followed by the bias. Removed again when it goes out of scope.
+ */
+struct NetworkFile {
+  std::string path;
+
+  NetworkFile(const std::vector<int>& sizes, const std::vector<std::vector<std::vector<double>>>& weights) {
+    char name[] = "net-XXXXXX";
+    const int fd = mkstemp(name);
+    ::close(fd);
+    path = name;
+
+    std::ofstream out(path);
+    out << "FANN_FLO_2.1\nnum_layers=" << sizes.size() << "\nconnection_rate=1.000000\nnetwork_type=0\n";
+    out << "layer_sizes=";
+    for (const auto size : sizes) {
+      out << (size + 1) << " ";
+    }
+    out << "\nscale_included=0\n";
+
+    out << "neurons (num_inputs, activation_function, activation_steepness)=";
+    for (size_t l = 0; l < sizes.size(); l++) {
+      for (int i = 0; i <= sizes[l]; i++) {
+        if (l == 0 || i == sizes[l]) {
+          out << "(0, " << (l == 0 ? 0 : 5) << ", " << (l == 0 ? 0.0 : 1.0) << ") ";
+        }
+        else {
+          out << "(" << (sizes[l - 1] + 1) << ", " << (l + 1 == sizes.size() ? 0 : 5) << ", 0.5) ";
+        }
+      }
+    }
+
+    out << "\nconnections (connected_to_neuron, weight)=";
+    int first = 0;
+    for (size_t l = 1; l < sizes.size(); l++) {
+      for (const auto& row : weights[l - 1]) {
+        for (size_t i = 0; i < row.size(); i++) {
+          out << "(" << (first + i) << ", " << row[i] << ") ";
+        }
+      }
+      first += sizes[l - 1] + 1;
+    }
+    out << "\n";
+  }
+
+  ~NetworkFile() {
+    std::remove(path.c_str());
+  }
+};
+
+// what FANN computes, in double precision
+double reference(const std::vector<int>& sizes, const std::vector<std::vector<std::vector<double>>>& weights, std::vector<double> values) {
+  for (size_t l = 1; l < sizes.size(); l++) {
+    std::vector<double> next;
+    for (const auto& row : weights[l - 1]) {
+      double sum = row.back();
+      for (size_t i = 0; i + 1 < row.size(); i++) {
+        sum += row[i] * values[i];
+      }
+      sum *= 0.5;
+      next.push_back(l + 1 == sizes.size() ? sum : std::tanh(sum));
+    }
+    values = next;
+  }
+
+  return values[0];
+}
+
+// name of a new empty file
+std::string temporaryFile() {
+  char name[] = "net-XXXXXX";
+  const int fd = mkstemp(name);
+  ::close(fd);
+  return name;
+}
+
+std::vector<std::vector<std::vector<double>>> randomWeights(const std::vector<int>& sizes, std::mt19937& rng) {
+  std::uniform_real_distribution<double> weight(-0.5, 0.5);
+  std::vector<std::vector<std::vector<double>>> weights(sizes.size() - 1);
+  for (size_t l = 1; l < sizes.size(); l++) {
+    weights[l - 1].resize(sizes[l], std::vector<double>(sizes[l - 1] + 1));
+    for (auto& row : weights[l - 1]) {
+      for (auto& w : row) {
+        w = weight(rng);
+      }
+    }
+  }
+
+  return weights;
+}
+
+}
+
+
+TEST_CASE("The layers of a FANN float file are loaded [DenseNetwork::load]") {
+  const std::vector<int> sizes = {2, 2, 1};
+  const NetworkFile file(sizes, {{{1.0, -1.0, 0.5}, {0.25, 0.25, 0.0}}, {{2.0, -2.0, 1.0}}});
+
+  ::david::DenseNetwork net;
+  REQUIRE(net.load(file.path));
+  REQUIRE(net.topology() == sizes);
+
+  const float inputs[2] = {1.0f, 0.0f};
+  const double expected = 0.5 * (2.0 * std::tanh(0.75) - 2.0 * std::tanh(0.125) + 1.0);
+  REQUIRE(std::fabs(net.run(inputs) - expected) < 1e-5);
+}
+
+TEST_CASE("Files that aren't float networks are rejected [DenseNetwork::load]") {
+  ::david::DenseNetwork net;
+  REQUIRE_FALSE(net.load("does-not-exist.net"));
+  REQUIRE_FALSE(net.isLoaded());
+
+  char name[] = "net-XXXXXX";
+  const int fd = mkstemp(name);
+  ::close(fd);
+  {
+    std::ofstream out(name);
+    out << "FANN_FIX_2.0\nnum_layers=3\n";
+  }
+  REQUIRE_FALSE(net.load(name));
+  std::remove(name);
+}
+
+TEST_CASE("The vectorized and scalar kernels match FANN [DenseNetwork::run]") {
+  // odd widths cover the padding of rows and the rows left after groups of four
+  const std::vector<int> sizes = {83, 37, 13, 5, 1};
+  std::mt19937 rng(1234);
+  const auto weights = randomWeights(sizes, rng);
+  const NetworkFile file(sizes, weights);
+
+  ::david::DenseNetwork vectorized;
+  ::david::DenseNetwork scalar;
+  REQUIRE(vectorized.load(file.path));
+  REQUIRE(scalar.load(file.path, false));
+  REQUIRE(std::string(scalar.kernel()) == "scalar");
+
+  std::uniform_real_distribution<float> input(-1.0f, 1.0f);
+  for (int n = 0; n < 20; n++) {
+    std::vector<float> inputs(sizes[0]);
+    for (auto& value : inputs) {
+      value = input(rng);
+    }
+
+    const double expected = reference(sizes, weights, std::vector<double>(inputs.begin(), inputs.end()));
+    REQUIRE(std::fabs(vectorized.run(inputs.data()) - expected) < 1e-4);
+    REQUIRE(std::fabs(scalar.run(inputs.data()) - expected) < 1e-4);
+  }
+}
+
+TEST_CASE("Batches give the same outputs as single positions [DenseNetwork::run]") {
+  const std::vector<int> sizes = {83, 37, 13, 5, 1};
+  std::mt19937 rng(4321);
+  const auto weights = randomWeights(sizes, rng);
+  const NetworkFile file(sizes, weights);
+
+  ::david::DenseNetwork vectorized;
+  ::david::DenseNetwork scalar;
+  REQUIRE(vectorized.load(file.path));
+  REQUIRE(scalar.load(file.path, false));
+
+  // more than one batch, with an odd number of positions in the last
+  const size_t n = ::david::DenseNetwork::BATCH * 2 + 3;
+  std::uniform_real_distribution<float> input(-1.0f, 1.0f);
+  std::vector<float> inputs(n * sizes[0]);
+  for (auto& value : inputs) {
+    value = input(rng);
+  }
+
+  std::vector<float> outputs(n);
+  std::vector<float> scalarOutputs(n);
+  vectorized.run(inputs.data(), n, outputs.data());
+  scalar.run(inputs.data(), n, scalarOutputs.data());
+
+  std::vector<::david::DenseNetwork::Accumulator> accumulators(n);
+  std::vector<float> accumulatorOutputs(n);
+  for (size_t b = 0; b < n; b++) {
+    vectorized.refresh(inputs.data() + b * sizes[0], accumulators[b]);
+  }
+  vectorized.run(accumulators.data(), n, accumulatorOutputs.data());
+
+  for (size_t b = 0; b < n; b++) {
+    const float single = vectorized.run(inputs.data() + b * sizes[0]);
+    REQUIRE(std::fabs(outputs[b] - single) < 1e-5);
+    REQUIRE(std::fabs(scalarOutputs[b] - single) < 1e-5);
+    REQUIRE(std::fabs(accumulatorOutputs[b] - single) < 1e-5);
+  }
+}
+
+TEST_CASE("Quantized networks stay close to the float network [DenseNetwork::quantize]") {
+  const std::vector<int> sizes = {83, 70, 33, 9, 1};
+  std::mt19937 rng(99);
+  const auto weights = randomWeights(sizes, rng);
+  const NetworkFile file(sizes, weights);
+
+  ::david::DenseNetwork vectorized;
+  ::david::DenseNetwork scalar;
+  REQUIRE(vectorized.load(file.path));
+  REQUIRE(scalar.load(file.path, false));
+
+  const size_t floatBytes = vectorized.weightBytes();
+  REQUIRE(vectorized.quantize());
+  REQUIRE(scalar.quantize());
+  REQUIRE(vectorized.isQuantized());
+  REQUIRE(vectorized.weightBytes() * 2 < floatBytes);
+
+  // inputs like the board features, mostly small with a few large ones
+  std::uniform_real_distribution<float> input(-1.0f, 1.0f);
+  for (int n = 0; n < 20; n++) {
+    std::vector<float> inputs(sizes[0]);
+    for (auto& value : inputs) {
+      value = input(rng);
+    }
+    inputs[10] = 100.0f;
+
+    const double expected = reference(sizes, weights, std::vector<double>(inputs.begin(), inputs.end()));
+    REQUIRE(std::fabs(vectorized.run(inputs.data()) - expected) < 0.05);
+    REQUIRE(std::fabs(vectorized.run(inputs.data()) - scalar.run(inputs.data())) < 1e-5);
+  }
+
+  // loading again goes back to floats
+  REQUIRE(vectorized.load(file.path));
+  REQUIRE_FALSE(vectorized.isQuantized());
+}
+
+TEST_CASE("Accumulators only add the inputs that changed [DenseNetwork::update]") {
+  const std::vector<int> sizes = {83, 37, 13, 1};
+  std::mt19937 rng(7);
+  const auto weights = randomWeights(sizes, rng);
+  const NetworkFile file(sizes, weights);
+
+  ::david::DenseNetwork net;
+  REQUIRE(net.load(file.path));
+  REQUIRE(net.hasAccumulators());
+
+  std::uniform_real_distribution<float> input(-1.0f, 1.0f);
+  std::vector<float> inputs(sizes[0]);
+  for (auto& value : inputs) {
+    value = input(rng);
+  }
+
+  ::david::DenseNetwork::Accumulator parent;
+  REQUIRE(parent.isEmpty());
+  net.refresh(inputs.data(), parent);
+  REQUIRE(std::fabs(net.run(parent) - net.run(inputs.data())) < 1e-5);
+
+  // a chain of positions, each a few inputs away from the one before
+  ::david::DenseNetwork::Accumulator child;
+  for (int n = 0; n < 20; n++) {
+    inputs[rng() % inputs.size()] = input(rng);
+    inputs[rng() % inputs.size()] = input(rng);
+
+    const size_t changed = net.update(parent, inputs.data(), child);
+    REQUIRE(changed <= 2);
+    REQUIRE(std::fabs(net.run(child) - net.run(inputs.data())) < 1e-4);
+    std::swap(parent, child);
+  }
+
+  REQUIRE(net.quantize());
+  REQUIRE_FALSE(net.hasAccumulators());
+}
+
+TEST_CASE("Binary files give the same outputs as the FANN file [DenseNetwork::save]") {
+  const std::vector<int> sizes = {83, 37, 13, 5, 1};
+  std::mt19937 rng(2468);
+  const auto weights = randomWeights(sizes, rng);
+  const NetworkFile file(sizes, weights);
+  const std::string binary = temporaryFile();
+
+  ::david::DenseNetwork parsed;
+  REQUIRE(parsed.load(file.path));
+  REQUIRE_FALSE(parsed.isMapped());
+  REQUIRE(parsed.inputLayout() == 1);
+  REQUIRE(parsed.save(binary, 2));
+
+  ::david::DenseNetwork mapped;
+  REQUIRE(mapped.load(binary));
+  REQUIRE(mapped.isMapped());
+  REQUIRE(mapped.inputLayout() == 2);
+  REQUIRE(mapped.topology() == sizes);
+
+  std::uniform_real_distribution<float> input(-1.0f, 1.0f);
+  for (int n = 0; n < 20; n++) {
+    std::vector<float> inputs(sizes[0]);
+    for (auto& value : inputs) {
+      value = input(rng);
+    }
+
+    REQUIRE(mapped.run(inputs.data()) == parsed.run(inputs.data()));
+
+    ::david::DenseNetwork::Accumulator accumulator;
+    mapped.refresh(inputs.data(), accumulator);
+    REQUIRE(std::fabs(mapped.run(accumulator) - parsed.run(inputs.data())) < 1e-5);
+  }
+
+  // the mapped weights can't be saved from once quantized
+  REQUIRE(mapped.quantize());
+  REQUIRE_FALSE(mapped.save(binary, 2));
+  std::remove(binary.c_str());
+}
+
+TEST_CASE("Networks loading the same file share the weights [DenseNetwork::load]") {
+  const std::vector<int> sizes = {83, 37, 13, 1};
+  std::mt19937 rng(1357);
+  const NetworkFile file(sizes, randomWeights(sizes, rng));
+
+  ::david::DenseNetwork first;
+  ::david::DenseNetwork second;
+  REQUIRE(first.load(file.path));
+  REQUIRE(second.load(file.path));
+  REQUIRE(first.sharesWeightsWith(second));
+
+  // quantizing one of them leaves the float weights of the other alone
+  std::vector<float> inputs(sizes[0], 0.25f);
+  const float expected = second.run(inputs.data());
+  REQUIRE(first.quantize());
+  REQUIRE(second.run(inputs.data()) == expected);
+
+  // a file that was replaced is loaded again
+  const NetworkFile other(sizes, randomWeights(sizes, rng));
+  ::david::DenseNetwork third;
+  REQUIRE(third.load(other.path));
+  REQUIRE_FALSE(third.sharesWeightsWith(second));
+}
+
+TEST_CASE("Broken binary files are rejected [DenseNetwork::load]") {
+  const std::vector<int> sizes = {8, 4, 1};
+  std::mt19937 rng(11);
+  const NetworkFile file(sizes, randomWeights(sizes, rng));
+  const std::string binary = temporaryFile();
+
+  ::david::DenseNetwork net;
+  REQUIRE(net.load(file.path));
+  REQUIRE(net.save(binary, 1));
+
+  std::string bytes;
+  {
+    std::ifstream in(binary, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  const auto rewrite = [&binary](const std::string& content) {
+    std::ofstream out(binary, std::ios::binary | std::ios::trunc);
+    out << content;
+  };
+
+  // cut short
+  rewrite(bytes.substr(0, bytes.size() - 4));
+  REQUIRE_FALSE(net.load(binary));
+
+  // another version of the format
+  std::string version = bytes;
+  version[8] = 9;
+  rewrite(version);
+  REQUIRE_FALSE(net.load(binary));
+
+  // an offset pointing past the end of the file
+  std::string offset = bytes;
+  offset[48 + 24 + 4] = 0x7f;
+  rewrite(offset);
+  REQUIRE_FALSE(net.load(binary));
+
+  rewrite(bytes);
+  REQUIRE(net.load(binary));
+  std::remove(binary.c_str());
+}
+
+TEST_CASE("Several threads can run one network at once [DenseNetwork::run]") {
+  const std::vector<int> sizes = {83, 70, 33, 9, 1};
+  std::mt19937 rng(2468);
+  const NetworkFile file(sizes, randomWeights(sizes, rng));
+
+  ::david::DenseNetwork net;
+  ::david::DenseNetwork quantized;
+  REQUIRE(net.load(file.path));
+  REQUIRE(quantized.load(file.path));
+  REQUIRE(quantized.quantize());
+
+  // a smaller network first, the scratch buffers of a thread have to grow
+  const std::vector<int> smallSizes = {8, 4, 1};
+  const NetworkFile smallFile(smallSizes, randomWeights(smallSizes, rng));
+  ::david::DenseNetwork small;
+  REQUIRE(small.load(smallFile.path));
+
+  const size_t n = ::david::DenseNetwork::BATCH + 5;
+  std::uniform_real_distribution<float> input(-1.0f, 1.0f);
+  std::vector<float> inputs(n * sizes[0]);
+  for (auto& value : inputs) {
+    value = input(rng);
+  }
+
+  std::vector<::david::DenseNetwork::Accumulator> accumulators(n);
+  std::vector<float> expected(n);
+  std::vector<float> expectedQuantized(n);
+  for (size_t b = 0; b < n; b++) {
+    net.refresh(inputs.data() + b * sizes[0], accumulators[b]);
+    expected[b] = net.run(inputs.data() + b * sizes[0]);
+    expectedQuantized[b] = quantized.run(inputs.data() + b * sizes[0]);
+  }
+
+  // Catch isn't thread safe, so every thread counts its own mismatches
+  const int nrOfThreads = 4;
+  std::vector<int> mismatches(nrOfThreads, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < nrOfThreads; t++) {
+    threads.emplace_back([&, t]() {
+      small.run(inputs.data());
+
+      std::vector<float> outputs(n);
+      for (int round = 0; round < 50; round++) {
+        net.run(inputs.data(), n, outputs.data());
+        for (size_t b = 0; b < n; b++) {
+          mismatches[t] += std::fabs(outputs[b] - expected[b]) > 1e-5;
+        }
+
+        net.run(accumulators.data(), n, outputs.data());
+        for (size_t b = 0; b < n; b++) {
+          mismatches[t] += std::fabs(outputs[b] - expected[b]) > 1e-5;
+        }
+
+        const size_t b = (t + round) % n;
+        mismatches[t] += net.run(inputs.data() + b * sizes[0]) != expected[b];
+        mismatches[t] += std::fabs(net.run(accumulators[b]) - expected[b]) > 1e-5;
+        mismatches[t] += quantized.run(inputs.data() + b * sizes[0]) != expectedQuantized[b];
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t < nrOfThreads; t++) {
+    REQUIRE(mismatches[t] == 0);
+  }
+}
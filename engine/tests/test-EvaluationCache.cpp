@@ -0,0 +1,92 @@
+#include "david/EvaluationCache.h"
+#include "david/utils/gameState.h"
+#include "catch.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+TEST_CASE("Stored scores can be probed [EvaluationCache::store]") {
+  ::david::EvaluationCache cache{1};
+  int score = 0;
+
+  REQUIRE_FALSE(cache.probe(42, score));
+  cache.store(42, -350);
+  REQUIRE(cache.probe(42, score));
+  REQUIRE(score == -350);
+
+  // same slot, different position
+  REQUIRE_FALSE(cache.probe(42 + cache.size(), score));
+
+  // an empty slot never matches, even for key 0 and score 0
+  REQUIRE_FALSE(cache.probe(0, score));
+
+  REQUIRE(cache.getProbes() == 4);
+  REQUIRE(cache.getHits() == 1);
+
+  cache.clear();
+  REQUIRE_FALSE(cache.probe(42, score));
+  REQUIRE(cache.getProbes() == 1);
+}
+
+TEST_CASE("A size of 0 turns the cache off [EvaluationCache::resize]") {
+  ::david::EvaluationCache cache{0};
+  int score = 0;
+
+  REQUIRE_FALSE(cache.isEnabled());
+  cache.store(42, 100);
+  REQUIRE_FALSE(cache.probe(42, score));
+  REQUIRE(cache.getProbes() == 0);
+
+  cache.resize(1);
+  REQUIRE(cache.isEnabled());
+  cache.store(42, 100);
+  REQUIRE(cache.probe(42, score));
+}
+
+TEST_CASE("Move counters are part of the key [EvaluationCache::key]") {
+  ::david::type::gameState_t gs;
+  ::utils::gameState::generateFromFEN(gs, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  const uint64_t key = ::david::EvaluationCache::key(gs);
+
+  ::david::type::gameState_t later;
+  ::utils::gameState::generateFromFEN(later, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 4 3");
+  REQUIRE(::david::EvaluationCache::key(later) != key);
+
+  ::david::type::gameState_t same;
+  ::utils::gameState::generateFromFEN(same, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  REQUIRE(::david::EvaluationCache::key(same) == key);
+}
+
+TEST_CASE("Threads sharing the cache never see a wrong score [EvaluationCache::probe]") {
+  // few positions, so the threads keep writing the same slots
+  ::david::EvaluationCache cache{1};
+  std::atomic<bool> wrong{false};
+
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, &wrong, t]() {
+      for (uint64_t i = 0; i < 200000; i++) {
+        const uint64_t key = (i * 4 + t) % 1000 * 0x9E3779B97F4A7C15ULL;
+        const int expected = static_cast<int>(key >> 40);
+
+        int score;
+        if (cache.probe(key, score) && score != expected) {
+          wrong = true;
+        }
+        cache.store(key, expected);
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE_FALSE(wrong);
+  REQUIRE(cache.getHits() > 0);
+
+  // every thread counts in a slot of its own, none of the probes are lost
+  REQUIRE(cache.getProbes() == 4 * 200000);
+}
@@ -0,0 +1,61 @@
+#include "david/MateSearch.h"
+#include "david/MoveGen.h"
+#include "david/utils/gameState.h"
+#include "catch.hpp"
+
+#include <string>
+
+
+namespace {
+std::string line(const ::david::type::gameState_t& root, const std::vector<::david::type::move_t>& moves) {
+  ::david::type::gameState_t parent = root;
+  ::david::type::gameState_t child;
+  std::string pv;
+
+  for (const auto move : moves) {
+    ::david::MoveGen gen{parent};
+    gen.applyMove(move, child);
+    pv += (pv.empty() ? "" : " ") + ::utils::gameState::getEGN(parent, child);
+    parent = child;
+  }
+
+  return pv;
+}
+}
+
+TEST_CASE("Back rank mate in one [MateSearch::search]") {
+  ::david::SearchControl control{};
+  ::david::SearchInfo info{};
+  ::david::MateSearch mateSearch{control, info, 1};
+
+  ::david::type::gameState_t gs;
+  ::utils::gameState::generateFromFEN(gs, "6k1/5ppp/8/8/8/8/8/R5K1 w - - 0 1");
+
+  REQUIRE(mateSearch.search(gs, 3) == 1);
+  REQUIRE(line(gs, mateSearch.getPV()) == "a1a8");
+}
+
+TEST_CASE("Smothered mate in two [MateSearch::search]") {
+  ::david::SearchControl control{};
+  ::david::SearchInfo info{};
+  ::david::MateSearch mateSearch{control, info, 1};
+
+  ::david::type::gameState_t gs;
+  ::utils::gameState::generateFromFEN(gs, "r6k/6pp/7N/8/8/1Q6/8/6K1 w - - 0 1");
+
+  REQUIRE(mateSearch.search(gs, 1) == 0);
+  REQUIRE(mateSearch.search(gs, 3) == 2);
+  REQUIRE(line(gs, mateSearch.getPV()) == "b3g8 a8g8 h6f7");
+}
+
+TEST_CASE("No mate in the start position [MateSearch::search]") {
+  ::david::SearchControl control{};
+  ::david::SearchInfo info{};
+  ::david::MateSearch mateSearch{control, info, 1};
+
+  ::david::type::gameState_t gs;
+  ::utils::gameState::setDefaultChessLayout(gs);
+
+  REQUIRE(mateSearch.search(gs, 2) == 0);
+  REQUIRE(mateSearch.getPV().empty());
+}
@@ -283,4 +283,45 @@ TEST_CASE("rook attack [MoveGen.generateRookAttack]") {
     REQUIRE(mgt.generateRookAttack(26, gs, true) == 4419437724672);
 
   }
-}
\ No newline at end of file
+}
+namespace {
+// walk the tree and make sure every encoded move recreates the generated child
+bool encodedMovesMatch(::david::type::gameState_t& gs, const int depth) {
+  ::david::MoveGen moveGen{gs};
+  std::array<::david::type::gameState_t, ::david::constant::MAXMOVES> children{};
+  std::array<::david::type::move_t, ::david::constant::MAXMOVES> moves{};
+
+  const auto len = moveGen.generateGameStates(children, 0, ::david::constant::MAXMOVES - 1, moves.data());
+  for (unsigned int i = 0; i < len; i++) {
+    ::david::type::gameState_t child;
+    if (!moveGen.applyMove(moves[i], child)
+        || !::utils::gameState::samePosition(child, children[i])
+        || child.halfMoves != children[i].halfMoves
+        || child.passant != children[i].passant) {
+      return false;
+    }
+
+    if (depth > 1 && !encodedMovesMatch(children[i], depth - 1)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+}
+
+TEST_CASE("Encoded moves recreate the generated game states [MoveGen::applyMove]") {
+  const std::array<std::string, 4> FENs = {
+      ::david::constant::FENStartPosition,
+      "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+      "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+      "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+  };
+
+  for (const auto& FEN : FENs) {
+    ::david::type::gameState_t gs;
+    ::utils::gameState::generateFromFEN(gs, FEN);
+
+    REQUIRE(encodedMovesMatch(gs, 3));
+  }
+}
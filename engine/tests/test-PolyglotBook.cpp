@@ -0,0 +1,119 @@
+#include "david/PolyglotBook.h"
+#include "david/utils/gameState.h"
+#include "catch.hpp"
+#include "test-helpers.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+
+namespace {
+
+// Polyglot move of two squares like "e2", with an optional promotion piece
+uint16_t bookMove(const std::string& from, const std::string& to, const int promotion = 0) {
+  return static_cast<uint16_t>((to[0] - 'a') | ((to[1] - '1') << 3)
+      | ((from[0] - 'a') << 6) | ((from[1] - '1') << 9) | (promotion << 12));
+}
+
+/**
+ * A book file written from a list of entries, which must be sorted by key.
+ * Removed again when it goes out of scope.
+ */
+struct BookFile {
+  std::string path;
+
+  explicit BookFile(const std::vector<::david::PolyglotBook::Entry>& entries) {
+    char name[] = "book-XXXXXX";
+    const int fd = mkstemp(name);
+    ::close(fd);
+    path = name;
+
+    std::ofstream out{path, std::ios::binary};
+    for (const auto& e : entries) {
+      writeBE(out, e.key, 8);
+      writeBE(out, e.move, 2);
+      writeBE(out, e.weight, 2);
+      writeBE(out, e.learn, 4);
+    }
+  }
+  ~BookFile() {
+    std::remove(path.c_str());
+  }
+
+  static void writeBE(std::ofstream& out, const uint64_t value, const int bytes) {
+    for (int i = bytes - 1; i >= 0; i--) {
+      out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+  }
+};
+
+}
+
+TEST_CASE("Positions get the keys of the Polyglot specification [PolyglotBook::key]") {
+  using ::david::PolyglotBook;
+
+  REQUIRE(PolyglotBook::key(test::position("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1")) == 0x463B96181691FC9CULL);
+  REQUIRE(PolyglotBook::key(test::position("rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1")) == 0x823C9B50FD114196ULL);
+  REQUIRE(PolyglotBook::key(test::position("rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2")) == 0x0756B94461C50FB0ULL);
+  REQUIRE(PolyglotBook::key(test::position("rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2")) == 0x662FAFB965DB29D4ULL);
+  REQUIRE(PolyglotBook::key(test::position("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3")) == 0x22A48B5A8E47FF78ULL);
+  REQUIRE(PolyglotBook::key(test::position("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3")) == 0x652A607CA3F242C1ULL);
+  REQUIRE(PolyglotBook::key(test::position("rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4")) == 0x00FDD303C946BDD9ULL);
+
+  // a black pawn can take en passant
+  REQUIRE(PolyglotBook::key(test::position("rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3")) == 0x3C8123EA7B067637ULL);
+  REQUIRE(PolyglotBook::key(test::position("rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4")) == 0x5C3F9B829B279560ULL);
+}
+
+TEST_CASE("Book moves are found by key and must be legal [PolyglotBook::probe]") {
+  using ::david::PolyglotBook;
+
+  const auto start = test::position("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  const auto castle = test::position("r3k2r/pppq1ppp/2np1n2/2b1p3/2B1P3/2NP1N2/PPPQ1PPP/R3K2R w KQkq - 0 1");
+  const auto promote = test::position("8/4P3/8/8/8/8/k7/6K1 w - - 0 1");
+
+  std::vector<PolyglotBook::Entry> entries = {
+      {PolyglotBook::key(start), bookMove("e2", "e4"), 10, 0},
+      {PolyglotBook::key(start), bookMove("d2", "d4"), 30, 0},
+      {PolyglotBook::key(start), bookMove("e2", "e5"), 100, 0}, // illegal
+      {PolyglotBook::key(castle), bookMove("e1", "h1"), 1, 0},
+      {PolyglotBook::key(promote), bookMove("e7", "e8", 4), 1, 0}
+  };
+  std::sort(entries.begin(), entries.end(), [](const PolyglotBook::Entry& a, const PolyglotBook::Entry& b) {
+    return a.key < b.key;
+  });
+  BookFile file{entries};
+
+  PolyglotBook book;
+  REQUIRE(!book.open("no-such-book.bin"));
+  REQUIRE(book.open(file.path));
+  REQUIRE(book.size() == 5);
+  REQUIRE(book.find(PolyglotBook::key(start)).size() == 3);
+
+  std::string move;
+  REQUIRE(book.probe(start, true, move));
+  REQUIRE(move == "d2d4");
+
+  for (int i = 0; i < 20; i++) {
+    REQUIRE(book.probe(start, false, move));
+    REQUIRE((move == "d2d4" || move == "e2e4"));
+  }
+
+  // castling is stored as the king taking the rook
+  REQUIRE(book.probe(castle, true, move));
+  REQUIRE(move == "e1g1");
+
+  REQUIRE(book.probe(promote, true, move));
+  REQUIRE(move == "e7e8q");
+
+  REQUIRE(!book.probe(test::position("8/8/8/4k3/8/8/8/K6Q w - - 0 1"), true, move));
+
+  book.close();
+  REQUIRE(!book.isOpen());
+  REQUIRE(!book.probe(start, true, move));
+}
@@ -0,0 +1,68 @@
+#include "david/SEE.h"
+#include "david/utils/gameState.h"
+#include "catch.hpp"
+#include "test-helpers.h"
+
+#include <string>
+
+
+namespace {
+
+// board index of a square like "e4", the h file is bit 0
+unsigned int square(const std::string& name) {
+  return static_cast<unsigned int>((name[1] - '1') * 8 + 7 - (name[0] - 'a'));
+}
+
+::david::type::move_t move(const std::string& from, const std::string& to, const unsigned int promotion = 0) {
+  return static_cast<::david::type::move_t>(square(from) | (square(to) << 6) | (promotion << 12));
+}
+
+}
+
+
+TEST_CASE("Undefended pieces are won [see::evaluate]") {
+  auto gs = test::position("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1");
+  REQUIRE(::david::see::evaluate(gs, move("e1", "e5")) == 100);
+
+  gs = test::position("4k3/8/8/3p4/4P3/8/8/4K3 b - - 0 1");
+  REQUIRE(::david::see::evaluate(gs, move("d5", "e4")) == 100);
+}
+
+TEST_CASE("Defended pieces cost the attacker [see::evaluate]") {
+  auto gs = test::position("4k3/8/3p4/4p3/8/8/8/4RK2 w - - 0 1");
+  REQUIRE(::david::see::evaluate(gs, move("e1", "e5")) == -400);
+
+  gs = test::position("4k3/8/2p5/3p4/4P3/8/8/4K3 w - - 0 1");
+  REQUIRE(::david::see::evaluate(gs, move("e4", "d5")) == 0);
+}
+
+TEST_CASE("Sliders behind an attacker join the exchange [see::evaluate]") {
+  auto gs = test::position("4r1k1/8/8/4p3/8/8/4R3/6K1 w - - 0 1");
+  REQUIRE(::david::see::evaluate(gs, move("e2", "e5")) == -400);
+
+  // the second rook recaptures through the square the first one left
+  gs = test::position("4r1k1/8/8/4p3/8/8/4R3/4R1K1 w - - 0 1");
+  REQUIRE(::david::see::evaluate(gs, move("e2", "e5")) == 100);
+}
+
+TEST_CASE("Kings don't take defended pieces [see::evaluate]") {
+  auto gs = test::position("4k3/3p4/8/8/8/8/8/3QK3 w - - 0 1");
+  REQUIRE(::david::see::evaluate(gs, move("d1", "d7")) == -800);
+
+  gs = test::position("4k3/3p4/8/8/8/8/3R4/3QK3 w - - 0 1");
+  REQUIRE(::david::see::evaluate(gs, move("d2", "d7")) == 100);
+}
+
+TEST_CASE("Quiet moves, en passant and promotions [see::evaluate]") {
+  auto gs = test::position("4k3/8/3p4/8/8/3N4/8/4K3 w - - 0 1");
+  REQUIRE(::david::see::evaluate(gs, move("d3", "e5")) == -300);
+  REQUIRE(::david::see::evaluate(gs, move("d3", "f4")) == 0);
+  REQUIRE_FALSE(::david::see::isCapture(gs, move("d3", "e5")));
+
+  gs = test::position("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1");
+  REQUIRE(::david::see::isCapture(gs, move("e5", "d6")));
+  REQUIRE(::david::see::evaluate(gs, move("e5", "d6")) == 100);
+
+  gs = test::position("4k3/P7/8/8/8/8/8/4K3 w - - 0 1");
+  REQUIRE(::david::see::evaluate(gs, move("a7", "a8", 4)) == 800);
+}
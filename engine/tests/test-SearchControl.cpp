@@ -0,0 +1,40 @@
+#include "david/SearchControl.h"
+#include "catch.hpp"
+
+#include <chrono>
+#include <thread>
+
+
+TEST_CASE("Stop and reset the stop flag [SearchControl::stop]") {
+  ::david::SearchControl control{};
+
+  REQUIRE(!control.stopped());
+  REQUIRE(control.bestMoveSent() == -1);
+
+  control.stop();
+  REQUIRE(control.stopped());
+  REQUIRE(control.bestMoveSent() >= 0);
+
+  control.reset();
+  REQUIRE(!control.stopped());
+  REQUIRE(control.bestMoveSent() == -1);
+}
+
+TEST_CASE("The timer raises the stop flag at the deadline [SearchControl::startTimer]") {
+  ::david::SearchControl control{};
+
+  control.startTimer(std::chrono::steady_clock::now() + std::chrono::milliseconds(20));
+  REQUIRE(!control.stopped());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  REQUIRE(control.stopped());
+  control.stopTimer();
+}
+
+TEST_CASE("A cancelled timer never raises the stop flag [SearchControl::stopTimer]") {
+  ::david::SearchControl control{};
+
+  control.startTimer(std::chrono::steady_clock::now() + std::chrono::seconds(60));
+  control.stopTimer();
+  REQUIRE(!control.stopped());
+}
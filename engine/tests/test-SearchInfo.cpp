@@ -0,0 +1,88 @@
+#include "david/SearchInfo.h"
+#include "david/david.h"
+#include "catch.hpp"
+
+#include <string>
+
+
+TEST_CASE("Node counters are summed over threads [SearchInfo::getNodes]") {
+  ::david::SearchInfo info{};
+
+  info.addNode(0);
+  info.addNode(0);
+  info.addNode(1);
+  info.addQuiescenceNode(2);
+
+  REQUIRE(info.getNodes() == 4);
+  REQUIRE(info.getQuiescenceNodes() == 1);
+
+  info.start();
+  REQUIRE(info.getNodes() == 0);
+}
+
+TEST_CASE("Tablebase hits are summed over threads [SearchInfo::getTablebaseHits]") {
+  ::david::SearchInfo info{};
+
+  info.addTablebaseHit(0);
+  info.addTablebaseHit(5);
+
+  REQUIRE(info.getTablebaseHits() == 2);
+  REQUIRE(info.toString().find(" tbhits 2") != std::string::npos);
+
+  info.start();
+  REQUIRE(info.getTablebaseHits() == 0);
+}
+
+TEST_CASE("Selective depth is the deepest ply of any thread [SearchInfo::getSelectiveDepth]") {
+  ::david::SearchInfo info{};
+
+  info.updateSelectiveDepth(0, 4);
+  info.updateSelectiveDepth(0, 2);
+  info.updateSelectiveDepth(3, 7);
+
+  REQUIRE(info.getSelectiveDepth() == 7);
+}
+
+TEST_CASE("Hashfull is only reported with a provider [SearchInfo::toString]") {
+  ::david::SearchInfo info{};
+
+  REQUIRE(info.toString().find("hashfull") == std::string::npos);
+
+  info.setHashfullProvider([]() { return 42; });
+  REQUIRE(info.toString().find("hashfull 42") != std::string::npos);
+
+  info.setCurrentMove("e2e4", 3);
+  REQUIRE(info.toString().find("currmove e2e4 currmovenumber 3") != std::string::npos);
+}
+
+TEST_CASE("Reports are throttled by the interval [SearchInfo::report]") {
+  ::david::SearchInfo info{};
+  info.setInterval(60000);
+
+  REQUIRE(info.report());
+  REQUIRE(!info.report());
+  REQUIRE(info.report(true));
+}
+
+TEST_CASE("Principal variation lines carry the line number and score [SearchInfo::lineToString]") {
+  ::david::SearchInfo info{};
+  info.setDepth(5);
+
+  const auto line = info.lineToString(2, -35, "e2e4 e7e5");
+  REQUIRE(line.find("info depth 5 ") == 0);
+  REQUIRE(line.find(" multipv 2 score cp -35 ") != std::string::npos);
+  REQUIRE(line.rfind(" pv e2e4 e7e5") + std::string(" pv e2e4 e7e5").size() == line.size());
+}
+
+TEST_CASE("Mate scores are reported in moves [SearchInfo::lineToString]") {
+  ::david::SearchInfo info{};
+  info.setDepth(4);
+
+  // the mating move is the third ply of the line
+  const auto mating = info.lineToString(1, ::david::constant::boardScore::HIGHEST, "e7e5 g2g4 d8h4");
+  REQUIRE(mating.find(" score mate 2 ") != std::string::npos);
+  REQUIRE(mating.find(" cp ") == std::string::npos);
+
+  const auto mated = info.lineToString(1, ::david::constant::boardScore::LOWEST, "f2f3 e7e5 g2g4 d8h4");
+  REQUIRE(mated.find(" score mate -2 ") != std::string::npos);
+}
@@ -0,0 +1,48 @@
+#include "david/SearchStack.h"
+#include "david/ANN/ANN.h"
+#include "david/utils/gameState.h"
+#include "catch.hpp"
+
+#include <string>
+
+
+namespace {
+
+// board index of a square like "e4", the h file is bit 0
+unsigned int square(const std::string& name) {
+  return static_cast<unsigned int>((name[1] - '1') * 8 + 7 - (name[0] - 'a'));
+}
+
+::david::type::move_t move(const std::string& from, const std::string& to) {
+  return static_cast<::david::type::move_t>(square(from) | (square(to) << 6));
+}
+
+}
+
+
+TEST_CASE("Lazy move lists are ordered without the network [SearchStack::generateMoves]") {
+  // no network is loaded, so evaluating anything would fail
+  ::david::ANN nn{};
+  ::david::TranspositionTable tt{1};
+  ::david::SearchStack stack{nn, tt, 4};
+
+  ::david::SearchStack::History history{};
+  history[0][square("e1")][square("f1")] = 50;
+  stack.setHistory(&history);
+  stack.setLazyEvaluation(true);
+
+  ::david::type::gameState_t gs;
+  ::utils::gameState::generateFromFEN(gs, "4k3/8/8/3q4/8/2N5/8/4K3 w - - 0 1");
+  stack.setPosition(0, gs);
+
+  const auto len = stack.generateMoves(0);
+  REQUIRE(len > 2);
+
+  // the capture that wins the queen, then the quiet move with the best history
+  REQUIRE(stack.getMove(0, 0).move == move("c3", "d5"));
+  REQUIRE(stack.getMove(0, 1).move == move("e1", "f1"));
+
+  // the position after the move is scored once the search asks for it
+  stack.makeMove(0, 0);
+  REQUIRE_FALSE(stack.hasScore(1));
+}
@@ -0,0 +1,84 @@
+#include "david/SearchStats.h"
+#include "catch.hpp"
+
+#include <string>
+
+
+TEST_CASE("Counters are cleared by start [SearchStats::start]") {
+  ::david::SearchStats stats;
+  stats.start(4);
+
+  stats.addNode(0);
+  stats.addNode(2);
+  stats.addNode(9); // deeper than counted per ply
+  stats.addQuiescenceNode();
+  stats.addEvaluations(20);
+  REQUIRE(stats.getNodes() == 3);
+  REQUIRE(stats.getNodesByPly()[2] == 1);
+  REQUIRE(stats.getQuiescenceNodes() == 1);
+  REQUIRE(stats.getEvaluations() == 20);
+
+  stats.start(4);
+  REQUIRE(stats.getNodes() == 0);
+  REQUIRE(stats.getNodesByPly()[2] == 0);
+  REQUIRE(stats.getEvaluations() == 0);
+}
+
+TEST_CASE("Iterations get the nodes counted since the last one [SearchStats::iterationComplete]") {
+  ::david::SearchStats stats;
+  stats.start(8);
+
+  for (int i = 0; i < 10; i++) {
+    stats.addNode(1);
+  }
+  stats.iterationComplete(1, 5);
+  for (int i = 0; i < 40; i++) {
+    stats.addNode(2);
+  }
+  stats.iterationComplete(2, 12);
+
+  const auto& iterations = stats.getIterations();
+  REQUIRE(iterations.size() == 2);
+  REQUIRE(iterations[0].nodes == 10);
+  REQUIRE(iterations[1].nodes == 40);
+  REQUIRE(iterations[1].time == 12);
+}
+
+TEST_CASE("Rates are exported as JSON [SearchStats::toJSON]") {
+  ::david::SearchStats stats;
+  stats.start(8);
+
+  stats.addBetaCutoff(0);
+  stats.addBetaCutoff(0);
+  stats.addBetaCutoff(0);
+  stats.addBetaCutoff(5);
+  stats.addNullMove(true);
+  stats.addNullMove(false);
+  stats.addReduction(false);
+  stats.addReduction(false);
+  stats.addReduction(false);
+  stats.addReduction(true);
+  stats.setTranspositionTable(10, 3);
+  stats.setAspiration(2, 1);
+
+  for (int i = 0; i < 10; i++) {
+    stats.addNode(1);
+  }
+  stats.iterationComplete(1, 1);
+  for (int i = 0; i < 25; i++) {
+    stats.addNode(2);
+  }
+  stats.iterationComplete(2, 2);
+
+  const std::string json = stats.toJSON();
+  REQUIRE(json.front() == '{');
+  REQUIRE(json.back() == '}');
+  REQUIRE(json.find("\"nodes\":35") != std::string::npos);
+  REQUIRE(json.find("\"firstMoveRate\":0.7500") != std::string::npos);
+  REQUIRE(json.find("\"tt\":{\"probes\":10,\"hits\":3,\"hitRate\":0.3000}") != std::string::npos);
+  REQUIRE(json.find("\"nullMove\":{\"tries\":2,\"cutoffs\":1,\"successRate\":0.5000}") != std::string::npos);
+  REQUIRE(json.find("\"lmr\":{\"reductions\":4,\"researches\":1,\"successRate\":0.7500}") != std::string::npos);
+  REQUIRE(json.find("\"aspiration\":{\"researches\":3,\"failHighs\":2,\"failLows\":1}") != std::string::npos);
+  REQUIRE(json.find("\"branching\":2.5000") != std::string::npos);
+  REQUIRE(json.find("\"nodesByPly\":[0,10,25]") != std::string::npos);
+}
@@ -0,0 +1,117 @@
+#include "david/Syzygy.h"
+#include "david/utils/gameState.h"
+#include "catch.hpp"
+#include "test-helpers.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+
+namespace {
+
+//
+// Tables where every position has the same value are only a header, so a
+// KQvK pair can be written by hand: white to move wins, black to move loses.
+//
+const std::vector<uint8_t> KQvK_WDL = {
+    0x71, 0xE8, 0x23, 0x5D, // magic
+    0x01,                   // both sides to move are stored
+    0x00,                   // group order
+    0x66, 0x55, 0xEE,       // pieces, white king, white queen, black king
+    0x00,                   // word alignment
+    0x80, 0x04,             // white to move, single value win
+    0x80, 0x00,             // black to move, single value loss
+    0x00, 0x00              // file size is 16 modulo 64
+};
+const std::vector<uint8_t> KQvK_DTZ = {
+    0xD7, 0x66, 0x0C, 0xA5, // magic
+    0x00,
+    0x00,                   // group order
+    0x06, 0x05, 0x0E,       // pieces
+    0x00,                   // word alignment
+    0x80, 0x04,             // white to move, four moves to zeroing
+    0x00, 0x00, 0x00, 0x00
+};
+
+/**
+ * A folder with the KQvK tables, removed again when it goes out of scope.
+ */
+struct TableFolder {
+  std::string path;
+
+  TableFolder() {
+    char name[] = "syzygy-XXXXXX";
+    path = mkdtemp(name);
+    write(path + "/KQvK.rtbw", KQvK_WDL);
+    write(path + "/KQvK.rtbz", KQvK_DTZ);
+  }
+  ~TableFolder() {
+    std::remove((path + "/KQvK.rtbw").c_str());
+    std::remove((path + "/KQvK.rtbz").c_str());
+    rmdir(path.c_str());
+  }
+
+  static void write(const std::string& file, const std::vector<uint8_t>& bytes) {
+    std::ofstream out{file, std::ios::binary};
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  }
+};
+
+}
+
+TEST_CASE("Tables are registered by their file names [Syzygy::init]") {
+  TableFolder folder;
+  ::david::Syzygy syzygy;
+
+  REQUIRE(syzygy.init("<empty>") == 0);
+  REQUIRE(syzygy.init("no-such-folder:" + folder.path) == 1);
+  REQUIRE(syzygy.getMaxPieces() == 3);
+
+  REQUIRE(syzygy.canProbe(test::position("8/8/8/4k3/8/8/8/K6Q w - - 0 1")));
+  REQUIRE(!syzygy.canProbe(test::position("8/8/8/4k3/8/8/8/K5RQ w - - 0 1")));
+  REQUIRE(!syzygy.canProbe(test::position("4k3/8/8/8/8/8/8/4K2Q w K - 0 1")));
+
+  syzygy.clear();
+  REQUIRE(syzygy.size() == 0);
+}
+
+TEST_CASE("Win, draw or loss is given for the side to move [Syzygy::probeWDL]") {
+  TableFolder folder;
+  ::david::Syzygy syzygy;
+  syzygy.init(folder.path);
+
+  int wdl = 0;
+  REQUIRE(syzygy.probeWDL(test::position("8/8/8/4k3/8/8/8/K6Q w - - 0 1"), wdl));
+  REQUIRE(wdl == ::david::Syzygy::WIN);
+  REQUIRE(syzygy.probeWDL(test::position("8/8/8/4k3/8/8/8/K6Q b - - 0 1"), wdl));
+  REQUIRE(wdl == ::david::Syzygy::LOSS);
+
+  // the same table, with the colours swapped
+  REQUIRE(syzygy.probeWDL(test::position("8/8/8/4K3/8/8/8/k6q b - - 0 1"), wdl));
+  REQUIRE(wdl == ::david::Syzygy::WIN);
+
+  // the king takes the queen, the table isn't trusted over the capture
+  REQUIRE(syzygy.probeWDL(test::position("8/8/8/8/8/8/1q6/K6k w - - 0 1"), wdl));
+  REQUIRE(wdl == ::david::Syzygy::DRAW);
+
+  // no table
+  REQUIRE(!syzygy.probeWDL(test::position("8/8/8/4k3/8/8/8/K6R w - - 0 1"), wdl));
+}
+
+TEST_CASE("Distance to zeroing is found for both sides to move [Syzygy::probeDTZ]") {
+  TableFolder folder;
+  ::david::Syzygy syzygy;
+  syzygy.init(folder.path);
+
+  int dtz = 0;
+  REQUIRE(syzygy.probeDTZ(test::position("8/8/8/4k3/8/8/8/K6Q w - - 0 1"), dtz));
+  REQUIRE(dtz == 9);
+
+  // only white to move is stored, black gets the best reply plus one ply
+  REQUIRE(syzygy.probeDTZ(test::position("8/8/8/4k3/8/8/8/K6Q b - - 0 1"), dtz));
+  REQUIRE(dtz == -10);
+}
@@ -0,0 +1,85 @@
+#include "david/TimeManager.h"
+#include "catch.hpp"
+
+#include <chrono>
+#include <thread>
+
+
+TEST_CASE("Fixed movetime uses the same soft and hard limit [TimeManager::start]") {
+  ::david::TimeManager tm{};
+  tm.setMoveOverhead(0);
+  tm.start(0, 0, 0, 1000);
+
+  REQUIRE(tm.hasTimeLimit());
+  REQUIRE(tm.getSoftLimit() == 1000);
+  REQUIRE(tm.getHardLimit() == 1000);
+}
+
+TEST_CASE("No clock information means no time limit [TimeManager::start]") {
+  ::david::TimeManager tm{};
+  tm.start(0, 0, 0, 0);
+
+  REQUIRE(!tm.hasTimeLimit());
+  REQUIRE(!tm.softLimitReached());
+  REQUIRE(!tm.hardLimitReached());
+}
+
+TEST_CASE("Clock budgets stay within the remaining time [TimeManager::start]") {
+  ::david::TimeManager tm{};
+  tm.setMoveOverhead(0);
+
+  // sudden death
+  tm.start(60000, 0, 0, 0);
+  REQUIRE(tm.getSoftLimit() == 2000);
+  REQUIRE(tm.getSoftLimit() < tm.getHardLimit());
+  REQUIRE(tm.getHardLimit() <= 60000);
+
+  // increments give more time per move
+  tm.start(60000, 1000, 0, 0);
+  REQUIRE(tm.getSoftLimit() == 2750);
+
+  // last move before the time control can use most of the clock
+  tm.start(10000, 0, 1, 0);
+  REQUIRE(tm.getHardLimit() == 9000);
+}
+
+TEST_CASE("Best move stability scales the soft limit [TimeManager::iterationComplete]") {
+  ::david::TimeManager tm{};
+  tm.setMoveOverhead(0);
+  tm.start(60000, 0, 0, 0);
+  const int optimum = tm.getSoftLimit();
+
+  tm.iterationComplete(1, 0);
+  REQUIRE(tm.getSoftLimit() == optimum);
+
+  // best move changed
+  tm.iterationComplete(2, 0);
+  REQUIRE(tm.getSoftLimit() > optimum);
+
+  // stable for three iterations
+  tm.iterationComplete(2, 0);
+  tm.iterationComplete(2, 0);
+  tm.iterationComplete(2, 0);
+  REQUIRE(tm.getSoftLimit() < optimum);
+
+  // score dropped
+  tm.iterationComplete(2, -200);
+  REQUIRE(tm.getSoftLimit() > optimum * 70 / 100);
+  REQUIRE(tm.getSoftLimit() <= tm.getHardLimit());
+}
+
+TEST_CASE("Ponder time is credited against the soft limit [TimeManager::ponderhit]") {
+  ::david::TimeManager tm{};
+  tm.setMoveOverhead(0);
+  tm.start(60000, 0, 0, 0);
+  const int soft = tm.getSoftLimit();
+  const int hard = tm.getHardLimit();
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  tm.ponderhit();
+
+  REQUIRE(tm.getSoftLimit() < soft);
+  REQUIRE(tm.getSoftLimit() >= soft / 4);
+  REQUIRE(tm.getHardLimit() == hard);
+  REQUIRE(tm.elapsed() < 100);
+}
@@ -0,0 +1,91 @@
+#include "david/TranspositionTable.h"
+#include "david/types.h"
+#include "catch.hpp"
+
+#include <array>
+
+
+TEST_CASE("Stored move lists can be probed [TranspositionTable::store]") {
+  ::david::TranspositionTable tt{1};
+  tt.newSearch();
+
+  const std::array<::david::ScoredMove, 3> moves = {{{12, 300}, {7, 20}, {4000, -50}}};
+
+  REQUIRE(tt.probe(42) == nullptr);
+  tt.store(42, moves.data(), 3);
+
+  auto entry = tt.probe(42);
+  REQUIRE(entry != nullptr);
+  REQUIRE(entry->nrOfMoves == 3);
+  REQUIRE(entry->moves[0].move == 12);
+  REQUIRE(entry->moves[2].score == -50);
+
+  // same slot, different position
+  REQUIRE(tt.probe(42 + tt.size()) == nullptr);
+
+  REQUIRE(tt.getProbes() == 3);
+  REQUIRE(tt.getHits() == 1);
+}
+
+TEST_CASE("Clearing forgets every position [TranspositionTable::clear]") {
+  ::david::TranspositionTable tt{1};
+  const std::array<::david::ScoredMove, 1> moves = {{{12, 300}}};
+
+  tt.store(42, moves.data(), 1);
+  tt.clear();
+  REQUIRE(tt.probe(42) == nullptr);
+
+  tt.store(42, moves.data(), 1);
+  tt.resize(2);
+  REQUIRE(tt.probe(42) == nullptr);
+}
+
+TEST_CASE("Hashfull only counts the current search [TranspositionTable::hashfull]") {
+  ::david::TranspositionTable tt{1};
+  const std::array<::david::ScoredMove, 1> moves = {{{12, 300}}};
+
+  REQUIRE(tt.hashfull() == 0);
+
+  for (uint64_t key = 0; key < tt.size(); key++) {
+    tt.store(key, moves.data(), 1);
+  }
+  REQUIRE(tt.hashfull() == 1000);
+
+  tt.newSearch();
+  REQUIRE(tt.hashfull() == 0);
+}
+
+TEST_CASE("Move lists written over by newer ones are forgotten [TranspositionTable::store]") {
+  ::david::TranspositionTable tt{1};
+  std::array<::david::ScoredMove, 200> moves{};
+  for (size_t i = 0; i < moves.size(); i++) {
+    moves[i] = {static_cast<::david::type::move_t>(i), static_cast<int>(i)};
+  }
+
+  tt.store(1, moves.data(), 3);
+
+  // storing the same position again doesn't take more of the arena
+  for (int i = 0; i < 100000; i++) {
+    tt.store(1, moves.data(), 3);
+  }
+  REQUIRE(tt.probe(1) != nullptr);
+
+  // other slots, until more than the whole arena has been written
+  for (uint64_t key = 2; key < tt.size(); key++) {
+    tt.store(key, moves.data(), 200);
+  }
+  REQUIRE(tt.probe(1) == nullptr);
+
+  // the lists that are still there are whole, also those that wrapped around
+  int kept = 0;
+  for (uint64_t key = 2; key < tt.size(); key++) {
+    const auto entry = tt.probe(key);
+    if (entry != nullptr) {
+      kept++;
+      REQUIRE(entry->nrOfMoves == 200);
+      REQUIRE(entry->moves[0].move == 0);
+      REQUIRE(entry->moves[199].score == 199);
+    }
+  }
+  REQUIRE(kept > 0);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "david/types.h"
+#include "david/utils/gameState.h"
+
+#include <string>
+
+//! Helpers shared by the unit tests.
+namespace test {
+
+/**
+ * The game state of a FEN string.
+ *
+ * @param fen std::string FEN(Forsyth–Edwards Notation)
+ * @return ::david::type::gameState_t the position
+ */
+inline ::david::type::gameState_t position(const std::string& fen) {
+  ::david::type::gameState_t gs;
+  ::utils::gameState::generateFromFEN(gs, fen);
+  return gs;
+}
+
+}
@@ -0,0 +1,118 @@
+#include "david/utils/neuralNet.h"
+#include "david/utils/gameState.h"
+#include "david/utils/utils.h"
+#include "david/Bench.h"
+#include "david/MoveGen.h"
+#include "catch.hpp"
+#include "test-helpers.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+using inputs_t = std::array<float, ::david::constant::nn::INPUTSIZE>;
+
+}
+
+
+TEST_CASE("The trained layout keeps the inputs the networks learned [neuralNet::convertGameStateToInputs]") {
+  const auto gs = test::position("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  const auto inputs = ::utils::neuralNet::convertGameStateToInputs(gs);
+
+  REQUIRE(inputs[0] == 1.0f);
+
+  // never written to by the legacy conversion
+  for (int i = 12; i < 25; i++) {
+    REQUIRE(inputs[i] == 0.0f);
+  }
+  for (int i = 31; i < 49; i++) {
+    REQUIRE(inputs[i] == 0.0f);
+  }
+  REQUIRE(inputs[52] == 0.0f);
+  REQUIRE(inputs[53] == 0.0f);
+  REQUIRE(inputs[60] == 0.0f);
+
+  REQUIRE(inputs[51] == Approx(0.32f));
+  REQUIRE(inputs[58] == Approx(100.0f));
+  REQUIRE(inputs[59] == Approx(49.99f));
+
+  // black king on e8, white king on e1
+  REQUIRE(inputs[61] == Approx(0.59f));
+  REQUIRE(inputs[62] == Approx(0.03f));
+
+  inputs_t buffer;
+  ::utils::neuralNet::convertGameStateToInputs(gs, buffer.data(), ::utils::neuralNet::LAYOUT_TRAINED);
+  REQUIRE(buffer == inputs);
+}
+
+TEST_CASE("The full layout gives every feature an input [neuralNet::convertGameStateToInputs]") {
+  const auto gs = test::position("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  inputs_t inputs;
+  ::utils::neuralNet::convertGameStateToInputs(gs, inputs.data(), ::utils::neuralNet::LAYOUT_FULL);
+
+  // black, then white: exists, counts, attacks, pieces not attacked
+  for (int c = 0; c < 2; c++) {
+    const int offset = 1 + c * 24;
+    REQUIRE(inputs[offset + 5] == 1.0f);
+    REQUIRE(inputs[offset + 6] == Approx(0.08f));
+    REQUIRE(inputs[offset + 12] == 0.0f);
+    REQUIRE(inputs[offset + 18] == Approx(0.08f));
+  }
+
+  REQUIRE(inputs[58] == 0.0f);
+  REQUIRE(inputs[59] == Approx(0.01f));
+
+  // pawns and knights reach the third rank
+  REQUIRE(inputs[60] == Approx(0.08f));
+}
+
+TEST_CASE("The full layout marks missing pieces and attacked pieces [neuralNet::convertGameStateToInputs]") {
+  // white to move, the black queen on d5 is attacked by the knight on c3
+  const auto gs = test::position("4k3/8/8/3q4/8/2N5/8/4K3 w - - 0 1");
+  inputs_t inputs;
+  ::utils::neuralNet::convertGameStateToInputs(gs, inputs.data(), ::utils::neuralNet::LAYOUT_FULL);
+
+  // black has no pawns, white has no queen
+  REQUIRE(inputs[1] == -1.0f);
+  REQUIRE(inputs[25 + 4] == -1.0f);
+
+  // the white knight attacks the queen, which is the only piece attacked
+  REQUIRE(inputs[25 + 12 + 2] == Approx(0.01f));
+  REQUIRE(inputs[1 + 18 + 4] == 0.0f);
+  REQUIRE(inputs[53] == Approx(0.01f));
+
+  // no pawns at all, every pawn square is missing
+  for (int i = 79; i < ::david::constant::nn::INPUTSIZE; i++) {
+    REQUIRE(inputs[i] == -1.0f);
+  }
+}
+
+TEST_CASE("The trained attack counts match the attacks of MoveGen [neuralNet::convertGameStateToInputs]") {
+  // the bench positions and their children, so both colours are to move
+  std::vector<::david::type::gameState_t> positions;
+  std::array<::david::type::gameState_t, ::david::constant::MAXMOVES> children;
+  for (const auto& fen : ::david::Bench::positions()) {
+    ::david::type::gameState_t gs;
+    ::utils::gameState::generateFromFEN(gs, fen);
+    positions.push_back(gs);
+
+    ::david::MoveGen moveGen{gs};
+    const auto len = moveGen.generateGameStates(children);
+    positions.insert(positions.end(), children.begin(), children.begin() + len);
+  }
+
+  for (const auto& gs : positions) {
+    inputs_t inputs;
+    ::utils::neuralNet::convertGameStateToInputs(gs, inputs.data(), ::utils::neuralNet::LAYOUT_TRAINED);
+
+    const uint8_t w = gs.isWhite ? 0 : 1;
+    ::david::MoveGen moveGen{gs};
+    const auto attacks = moveGen.generateAttacks();
+    for (int i = 0; i < 6; i++) {
+      REQUIRE(inputs[6 + i] == ::utils::nrOfActiveBits(attacks.piecesArr[i][w] & gs.piecess[w ^ 1]) * 0.01f);
+    }
+  }
+}
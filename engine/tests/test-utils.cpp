@@ -92,4 +92,44 @@ TEST_CASE ("chess index parser") {
 //  ::utils::generateMergedBoardVersion(gs);
 //
 //  ::utils::printGameState(gs);
-}
\ No newline at end of file
+}
+TEST_CASE("same position ignores search data [utils::gameState::samePosition]") {
+  ::david::type::gameState_t gs1;
+  ::utils::gameState::setDefaultChessLayout(gs1);
+
+  ::david::type::gameState_t gs2 = gs1;
+  gs2.score = 123;
+  gs2.depth = 4;
+  gs2.possibleSubMoves = 20;
+  REQUIRE(::utils::gameState::samePosition(gs1, gs2));
+
+  gs2.isWhite = !gs1.isWhite;
+  REQUIRE(!::utils::gameState::samePosition(gs1, gs2));
+
+  ::david::type::gameState_t gs3;
+  ::utils::gameState::generateNullMove(gs1, gs3);
+  REQUIRE(!::utils::gameState::samePosition(gs1, gs3));
+}
+
+TEST_CASE("zobrist hash follows samePosition [utils::gameState::zobristHash]") {
+  ::david::type::gameState_t gs1;
+  ::utils::gameState::setDefaultChessLayout(gs1);
+
+  ::david::type::gameState_t gs2 = gs1;
+  gs2.score = 123;
+  gs2.depth = 4;
+  gs2.halfMoves = 7;
+  gs2.fullMoves = 9;
+  REQUIRE(::utils::gameState::zobristHash(gs1) == ::utils::gameState::zobristHash(gs2));
+
+  ::david::type::gameState_t gs3;
+  ::utils::gameState::generateNullMove(gs1, gs3);
+  REQUIRE(::utils::gameState::zobristHash(gs1) != ::utils::gameState::zobristHash(gs3));
+
+  // same pieces, different castling rights
+  ::david::type::gameState_t gs4;
+  ::david::type::gameState_t gs5;
+  ::utils::gameState::generateFromFEN(gs4, "r3k2r/pppppppp/8/8/8/8/PPPPPPPP/R3K2R w KQkq - 0 1");
+  ::utils::gameState::generateFromFEN(gs5, "r3k2r/pppppppp/8/8/8/8/PPPPPPPP/R3K2R w Kkq - 0 1");
+  REQUIRE(::utils::gameState::samePosition(gs4, gs5) == (::utils::gameState::zobristHash(gs4) == ::utils::gameState::zobristHash(gs5)));
+}